@@ -0,0 +1,493 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#if defined(__unix__) || defined(__APPLE__)
+    #include <fcntl.h>
+    #include <sys/file.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+    #define CHECKERS_CACHE_FILES
+#endif
+
+#include "../Models/Move.h"
+
+using namespace std;
+
+// Анализ позиции из кэша: результат поиска с итеративным углублением
+struct cached_analysis
+{
+    int depth = 0;          // число завершенных уровней поиска
+    double score = 0;       // оценка лучшего хода
+    uint64_t nodes = 0;     // позиций, затраченных на анализ
+    size_t turn_length = 0; // число прыжков хода из корня в начале line
+    vector<move_pos> line;  // главный вариант, каждый прыжок - отдельный элемент
+
+    // Ход из корня (серия взятий целиком)
+    vector<move_pos> turn() const
+    {
+        return vector<move_pos>(line.begin(), line.begin() + min(turn_length, line.size()));
+    }
+};
+
+/**
+ * Кэш анализа позиций на диске: ключ - хеш позиции, значение - самый глубокий анализ.
+ * Анализы дописываются в конец журнала (path), индекс (path.idx) - хеш-таблица с открытой адресацией
+ * в файле, отображенном в память: ключ, смещение записи в журнале и ее глубина.
+ * Более глубокий анализ позиции дописывается новой записью, старая становится мусором;
+ * сжатие переписывает журнал только с живыми записями. У каждой записи контрольная сумма:
+ * недописанный хвост журнала после сбоя отрезается, а индекс, закрытый не штатно, строится заново по журналу.
+ * Файлы принадлежат одному процессу (блокировка журнала), потоки процесса работают с кэшем под мьютексом
+ */
+class AnalysisCache
+{
+    struct log_header
+    {
+        uint64_t magic;
+        uint64_t reserved;
+    };
+
+    // Запись журнала, за ней length ходов по 6 байт
+    struct record_header
+    {
+        uint64_t key;
+        double score;
+        uint64_t nodes;
+        uint32_t depth;
+        uint16_t turn_length;
+        uint16_t length;
+        uint32_t check; // контрольная сумма заголовка (с check = 0) и ходов
+        uint32_t reserved;
+    };
+
+    struct index_header
+    {
+        uint64_t magic;
+        uint64_t slot_count;
+        uint64_t records;    // занятые ячейки
+        uint64_t log_size;   // длина журнала, учтенная в индексе
+        uint64_t live_bytes; // байт журнала в живых записях
+        uint32_t clean;      // индекс закрыт штатно
+        uint32_t reserved[5];
+    };
+
+    struct slot
+    {
+        uint64_t key;
+        uint64_t offset; // смещение записи в журнале, 0 - пустая ячейка
+        uint32_t depth;
+        uint32_t size; // байт записи в журнале
+    };
+
+    static_assert(sizeof(log_header) == 16 && sizeof(record_header) == 40 && sizeof(index_header) == 64 &&
+                      sizeof(slot) == 24,
+                  "unexpected analysis cache layout");
+
+  public:
+    static constexpr uint64_t log_magic = 0x3130304341524843;   // "CHRAC001"
+    static constexpr uint64_t index_magic = 0x3130304941524843; // "CHRAI001"
+
+    explicit AnalysisCache(const string &path) : path(path)
+    {
+#ifdef CHECKERS_CACHE_FILES
+        open_log();
+        open_index();
+#else
+        throw runtime_error("analysis cache is not supported on this platform");
+#endif
+    }
+
+    ~AnalysisCache()
+    {
+#ifdef CHECKERS_CACHE_FILES
+        if (head)
+        {
+            head->clean = 1;
+            msync(head, mapped_size, MS_SYNC);
+            munmap(head, mapped_size);
+        }
+        if (index_fd >= 0)
+            close(index_fd);
+        if (log_fd >= 0)
+            close(log_fd);
+#endif
+    }
+
+    AnalysisCache(const AnalysisCache &) = delete;
+    AnalysisCache &operator=(const AnalysisCache &) = delete;
+
+    /**
+     * Общий кэш процесса для файла path. Кэш открывается при первом обращении и живет до конца процесса.
+     * Если файл не удалось открыть, исключение выбрасывается один раз, дальше возвращается nullptr
+     */
+    static shared_ptr<AnalysisCache> shared(const string &path)
+    {
+        static mutex registry_mutex;
+        static map<string, shared_ptr<AnalysisCache>> registry;
+        lock_guard<mutex> lock(registry_mutex);
+        const auto it = registry.find(path);
+        if (it != registry.end())
+            return it->second;
+        auto &cache = registry[path];
+        cache = make_shared<AnalysisCache>(path);
+        return cache;
+    }
+
+    /**
+     * Анализ позиции key не меньше чем на min_depth уровней
+     * @return false - позиции нет в кэше или она проанализирована мельче
+     */
+    bool lookup(const uint64_t key, const int min_depth, cached_analysis &res)
+    {
+        lock_guard<mutex> lock(cache_mutex);
+        const slot *s = find_slot(key);
+        if (!s->offset || int(s->depth) < min_depth || !read_record(s->offset, key, res))
+        {
+            ++misses;
+            return false;
+        }
+        ++hits;
+        return true;
+    }
+
+    // Запись анализа позиции key, если он глубже сохраненного
+    void store(const uint64_t key, const cached_analysis &analysis)
+    {
+        lock_guard<mutex> lock(cache_mutex);
+        const slot *s = find_slot(key);
+        if (s->offset && int(s->depth) >= analysis.depth)
+            return;
+        const vector<char> record = encode(key, analysis);
+        const uint64_t offset = head->log_size;
+        if (!write_all(log_fd, record.data(), record.size(), offset))
+            throw runtime_error("can't write analysis cache " + path);
+        head->log_size = offset + record.size();
+        put(key, offset, uint32_t(analysis.depth), uint32_t(record.size()));
+        ++stores;
+        // Журнал сжимается, когда мусора в нем больше, чем живых записей
+        if (head->log_size >= compact_min_bytes && garbage_bytes() > head->live_bytes)
+            compact_locked();
+    }
+
+    // Переписывание журнала только с живыми записями
+    void compact()
+    {
+        lock_guard<mutex> lock(cache_mutex);
+        compact_locked();
+    }
+
+    // Число проанализированных позиций
+    size_t size() const
+    {
+        return size_t(head->records);
+    }
+
+    // Ячеек индекса
+    size_t capacity() const
+    {
+        return size_t(head->slot_count);
+    }
+
+    uint64_t log_bytes() const
+    {
+        return head->log_size;
+    }
+
+    uint64_t live_bytes() const
+    {
+        return head->live_bytes + sizeof(log_header);
+    }
+
+    // Байт журнала в записях, вытесненных более глубоким анализом
+    uint64_t garbage_bytes() const
+    {
+        return head->log_size - sizeof(log_header) - head->live_bytes;
+    }
+
+    // Глубина анализа в ячейке index индекса, -1 - ячейка пуста
+    int depth_at(const size_t index) const
+    {
+        return slots[index].offset ? int(slots[index].depth) : -1;
+    }
+
+    // Счетчики обращений этого процесса
+    atomic<uint64_t> hits{0}, misses{0}, stores{0};
+
+  private:
+#ifdef CHECKERS_CACHE_FILES
+    void open_log()
+    {
+        log_fd = open(path.c_str(), O_RDWR | O_CREAT, 0666);
+        if (log_fd < 0)
+            throw runtime_error("can't open analysis cache " + path);
+        if (flock(log_fd, LOCK_EX | LOCK_NB) != 0)
+            throw runtime_error(path + " is used by another process");
+        struct stat st;
+        fstat(log_fd, &st);
+        log_header file_header{};
+        if (st.st_size == 0)
+        {
+            file_header.magic = log_magic;
+            if (!write_all(log_fd, &file_header, sizeof(file_header), 0))
+                throw runtime_error("can't create analysis cache " + path);
+        }
+        else if (pread(log_fd, &file_header, sizeof(file_header), 0) != sizeof(file_header) ||
+                 file_header.magic != log_magic)
+            throw runtime_error(path + " is not an analysis cache");
+    }
+
+    void open_index()
+    {
+        const string index_path = path + ".idx";
+        index_fd = open(index_path.c_str(), O_RDWR | O_CREAT, 0666);
+        if (index_fd < 0)
+            throw runtime_error("can't open analysis cache index " + index_path);
+        struct stat st;
+        fstat(log_fd, &st);
+        const uint64_t log_size = uint64_t(st.st_size);
+        fstat(index_fd, &st);
+        index_header file_header{};
+        const bool valid = uint64_t(st.st_size) >= sizeof(index_header) &&
+                           pread(index_fd, &file_header, sizeof(file_header), 0) == sizeof(file_header) &&
+                           file_header.magic == index_magic && file_header.slot_count >= min_slots &&
+                           !(file_header.slot_count & (file_header.slot_count - 1)) &&
+                           uint64_t(st.st_size) == sizeof(index_header) + file_header.slot_count * sizeof(slot) &&
+                           file_header.clean && file_header.log_size <= log_size;
+        if (valid)
+            map_index(file_header.slot_count, false);
+        else
+        {
+            // Индекс строится заново по журналу
+            map_index(min_slots, true);
+            head->log_size = sizeof(log_header);
+        }
+        head->clean = 0;
+        replay(log_size);
+    }
+
+    // Отображение индекса на slot_count ячеек; clear - пустой индекс
+    void map_index(const uint64_t slot_count, const bool clear)
+    {
+        mapped_size = sizeof(index_header) + slot_count * sizeof(slot);
+        if (clear && ftruncate(index_fd, 0) != 0)
+            throw runtime_error("can't resize analysis cache index " + path + ".idx");
+        if (ftruncate(index_fd, off_t(mapped_size)) != 0)
+            throw runtime_error("can't resize analysis cache index " + path + ".idx");
+        void *memory = mmap(nullptr, mapped_size, PROT_READ | PROT_WRITE, MAP_SHARED, index_fd, 0);
+        if (memory == MAP_FAILED)
+            throw runtime_error("can't map analysis cache index " + path + ".idx");
+        head = static_cast<index_header *>(memory);
+        slots = reinterpret_cast<slot *>(static_cast<char *>(memory) + sizeof(index_header));
+        if (clear)
+            *head = index_header{index_magic, slot_count, 0, sizeof(log_header), 0, 0, {}};
+        mask = slot_count - 1;
+    }
+
+    // Записи журнала после head->log_size добавляются в индекс; недописанный хвост отрезается
+    void replay(const uint64_t log_size)
+    {
+        uint64_t offset = head->log_size;
+        cached_analysis analysis;
+        while (offset + sizeof(record_header) <= log_size)
+        {
+            record_header rec;
+            if (pread(log_fd, &rec, sizeof(rec), off_t(offset)) != sizeof(rec) ||
+                !read_record(offset, rec.key, analysis))
+                break;
+            const uint32_t size = uint32_t(sizeof(record_header) + rec.length * move_size);
+            const slot *s = find_slot(rec.key);
+            if (!s->offset || s->depth <= rec.depth)
+                put(rec.key, offset, rec.depth, size);
+            offset += size;
+        }
+        if (offset != log_size && ftruncate(log_fd, off_t(offset)) != 0)
+            throw runtime_error("can't truncate analysis cache " + path);
+        head->log_size = offset;
+    }
+
+    // Новый журнал с живыми записями пишется рядом и заменяет старый
+    void compact_locked()
+    {
+        const string tmp_path = path + ".tmp";
+        const int fd = open(tmp_path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0666);
+        if (fd < 0)
+            throw runtime_error("can't create " + tmp_path);
+        flock(fd, LOCK_EX);
+        const log_header file_header{log_magic, 0};
+        bool ok = write_all(fd, &file_header, sizeof(file_header), 0);
+        uint64_t offset = sizeof(log_header);
+        vector<uint64_t> offsets(head->slot_count, 0);
+        vector<char> buffer;
+        for (uint64_t i = 0; ok && i < head->slot_count; ++i)
+        {
+            if (!slots[i].offset)
+                continue;
+            buffer.resize(slots[i].size);
+            ok = pread(log_fd, buffer.data(), buffer.size(), off_t(slots[i].offset)) == ssize_t(buffer.size()) &&
+                 write_all(fd, buffer.data(), buffer.size(), offset);
+            offsets[i] = offset;
+            offset += buffer.size();
+        }
+        if (!ok || fsync(fd) != 0 || rename(tmp_path.c_str(), path.c_str()) != 0)
+        {
+            close(fd);
+            unlink(tmp_path.c_str());
+            throw runtime_error("can't compact analysis cache " + path);
+        }
+        close(log_fd);
+        log_fd = fd;
+        for (uint64_t i = 0; i < head->slot_count; ++i)
+        {
+            if (slots[i].offset)
+                slots[i].offset = offsets[i];
+        }
+        head->log_size = offset;
+        head->live_bytes = offset - sizeof(log_header);
+        msync(head, mapped_size, MS_SYNC);
+    }
+
+    // Индекс вдвое больше: ячейки переносятся по ключам
+    void grow()
+    {
+        vector<slot> old(slots, slots + head->slot_count);
+        const index_header old_head = *head;
+        munmap(head, mapped_size);
+        map_index(old_head.slot_count * 2, true);
+        head->log_size = old_head.log_size;
+        for (const slot &s : old)
+        {
+            if (s.offset)
+                put(s.key, s.offset, s.depth, s.size);
+        }
+    }
+
+    static bool write_all(const int fd, const void *data, const size_t size, const uint64_t offset)
+    {
+        return pwrite(fd, data, size, off_t(offset)) == ssize_t(size);
+    }
+
+    // Чтение и проверка записи журнала
+    bool read_record(const uint64_t offset, const uint64_t key, cached_analysis &res) const
+    {
+        record_header rec;
+        if (pread(log_fd, &rec, sizeof(rec), off_t(offset)) != sizeof(rec) || rec.key != key ||
+            rec.turn_length > rec.length)
+            return false;
+        vector<int8_t> moves(size_t(rec.length) * move_size);
+        if (!moves.empty() &&
+            pread(log_fd, moves.data(), moves.size(), off_t(offset + sizeof(rec))) != ssize_t(moves.size()))
+            return false;
+        const uint32_t check = rec.check;
+        rec.check = 0;
+        if (checksum(rec, moves) != check)
+            return false;
+        res.depth = int(rec.depth);
+        res.score = rec.score;
+        res.nodes = rec.nodes;
+        res.turn_length = rec.turn_length;
+        res.line.clear();
+        for (size_t i = 0; i < moves.size(); i += move_size)
+            res.line.emplace_back(moves[i], moves[i + 1], moves[i + 2], moves[i + 3], moves[i + 4], moves[i + 5]);
+        return true;
+    }
+#else
+    bool read_record(const uint64_t, const uint64_t, cached_analysis &) const
+    {
+        return false;
+    }
+    bool write_all(const int, const void *, const size_t, const uint64_t)
+    {
+        return false;
+    }
+    void compact_locked()
+    {
+    }
+    void grow()
+    {
+    }
+#endif
+
+    static vector<char> encode(const uint64_t key, const cached_analysis &analysis)
+    {
+        const size_t length = min(analysis.line.size(), size_t(UINT16_MAX));
+        record_header rec{key, analysis.score, analysis.nodes, uint32_t(analysis.depth),
+                          uint16_t(min(analysis.turn_length, length)), uint16_t(length), 0, 0};
+        vector<int8_t> moves;
+        moves.reserve(length * move_size);
+        for (size_t i = 0; i < length; ++i)
+        {
+            const move_pos &m = analysis.line[i];
+            moves.insert(moves.end(), {m.x, m.y, m.x2, m.y2, m.xb, m.yb});
+        }
+        rec.check = checksum(rec, moves);
+        vector<char> res(sizeof(rec) + moves.size());
+        memcpy(res.data(), &rec, sizeof(rec));
+        if (!moves.empty())
+            memcpy(res.data() + sizeof(rec), moves.data(), moves.size());
+        return res;
+    }
+
+    // FNV-1a заголовка записи и ходов
+    static uint32_t checksum(const record_header &rec, const vector<int8_t> &moves)
+    {
+        uint32_t res = 2166136261u;
+        auto add = [&res](const void *data, const size_t size) {
+            for (size_t i = 0; i < size; ++i)
+                res = (res ^ static_cast<const uint8_t *>(data)[i]) * 16777619u;
+        };
+        add(&rec, sizeof(rec));
+        add(moves.data(), moves.size());
+        return res;
+    }
+
+    // Ячейка ключа key или пустая ячейка, в которую он попадет (линейное пробирование)
+    slot *find_slot(const uint64_t key) const
+    {
+        for (uint64_t i = key & mask;; i = (i + 1) & mask)
+        {
+            if (!slots[i].offset || slots[i].key == key)
+                return &slots[i];
+        }
+    }
+
+    // Ячейка индекса указывает на запись offset; прежняя запись ключа становится мусором
+    void put(const uint64_t key, const uint64_t offset, const uint32_t depth, const uint32_t size)
+    {
+        slot *s = find_slot(key);
+        if (s->offset)
+            head->live_bytes -= s->size;
+        else
+        {
+            // Индекс заполнен не больше чем наполовину
+            if ((head->records + 1) * 2 > head->slot_count)
+            {
+                grow();
+                s = find_slot(key);
+            }
+            ++head->records;
+        }
+        *s = slot{key, offset, depth, size};
+        head->live_bytes += size;
+    }
+
+    static constexpr size_t move_size = 6;
+    static constexpr uint64_t min_slots = 4096;
+    static constexpr uint64_t compact_min_bytes = 1 << 20;
+
+    string path;
+    mutex cache_mutex;
+    int log_fd = -1;
+    int index_fd = -1;
+    index_header *head = nullptr;
+    slot *slots = nullptr;
+    size_t mapped_size = 0;
+    uint64_t mask = 0;
+};
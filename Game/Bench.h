@@ -0,0 +1,125 @@
+#pragma once
+#include <chrono>
+#include <ostream>
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+#include "../Models/Settings.h"
+#include "History.h"
+#include "Logic.h"
+#include "Notation.h"
+
+using json = nlohmann::json;
+using namespace std;
+
+// Воспроизводимый замер скорости поиска: набор позиций перебирается на фиксированную глубину.
+// Случайность отключена, поэтому суммарное число позиций - подпись поиска:
+// оно меняется только при изменении самого алгоритма
+class Bench
+{
+  public:
+    // Набор позиций: дебют, миттельшпиль, эндшпиль простыми и с дамками
+    static const vector<string> &positions()
+    {
+        static const vector<string> suite = {
+            "W:Wa1,c1,e1,g1,b2,d2,f2,h2,a3,c3,e3,g3:Bb6,d6,f6,h6,a7,c7,e7,g7,b8,d8,f8,h8",
+            "B:Wa1,c1,e1,g1,b2,d2,f2,h2,a3,e3,g3,d4:Bb6,d6,f6,h6,a7,c7,e7,g7,b8,d8,f8,h8",
+            "W:Wa1,c1,e1,g1,d2,f2,h2,g3:Be3,f6,h6,e7,g7,b8,d8,f8,h8",
+            "W:Wa1,c1,e1,g1,f2,h2,f4:Bc5,h6,a7,g7,d8,f8,h8",
+            "W:Wa1,c1,e1,g1,e3,f4,h4:Ba5,c5,h6,c7,g7,f8,h8",
+            "W:We1,d2,f2,a3,e3,f4:Ba5,c5,g5,b6,d6,h6",
+            "W:We1,f2,a3,e3,f4,e5:Bb4,h4,a5,c5,d6,h6",
+            "W:WKa1,Kc3,e3:BKh8,f6,g7",
+            "B:WKd4,g3,h2:BKb8,Ke7,a5",
+            "W:WKe1,Kg1,c3:BKa7,Kh6,f6,b4",
+        };
+        return suite;
+    }
+
+    // Результат одной позиции
+    struct result
+    {
+        string fen;
+        string best;
+        double score = 0;
+        uint64_t nodes = 0;
+        double time_ms = 0;
+    };
+
+    /**
+     * Поиск на глубину level + 1 в каждой позиции набора
+     * @param out поток для построчного отчета
+     * @return результаты по позициям
+     */
+    static vector<result> run(const int level, ostream &out)
+    {
+        Settings settings;
+        settings.no_random = true;
+        vector<result> results;
+        uint64_t total_nodes = 0;
+        double total_ms = 0;
+        for (size_t i = 0; i < positions().size(); ++i)
+        {
+            result res;
+            res.fen = positions()[i];
+            vector<vector<POS_T>> mtx;
+            bool color;
+            notation::parse_fen(res.fen, mtx, color);
+            History history;
+            history.reset(mtx, color);
+            // Новый поиск для каждой позиции: результат не зависит от порядка позиций
+            Logic logic(settings);
+            logic.Max_depth = level;
+            auto start = chrono::steady_clock::now();
+            res.best = notation::chain_to_string(logic.find_best_turns(mtx, history, color));
+            res.time_ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+            res.nodes = logic.stats.nodes;
+            res.score = logic.stats.score;
+            total_nodes += res.nodes;
+            total_ms += res.time_ms;
+            out << "position " << i + 1 << "/" << positions().size() << " nodes " << res.nodes << " time "
+                << uint64_t(res.time_ms) << " best " << res.best << '\n';
+            results.push_back(res);
+        }
+        out << "total nodes " << total_nodes << " time " << uint64_t(total_ms) << " nps "
+            << uint64_t(nps(total_nodes, total_ms)) << endl;
+        return results;
+    }
+
+    // Отчет в JSON для сравнения между версиями
+    static json to_json(const int level, const vector<result> &results)
+    {
+        json positions_json = json::array();
+        uint64_t total_nodes = 0;
+        double total_ms = 0;
+        for (const auto &res : results)
+        {
+            json item;
+            item["fen"] = res.fen;
+            item["best"] = res.best;
+            item["score"] = res.score;
+            item["nodes"] = res.nodes;
+            item["time_ms"] = res.time_ms;
+            positions_json.push_back(item);
+            total_nodes += res.nodes;
+            total_ms += res.time_ms;
+        }
+        json report;
+        report["depth"] = level + 1;
+        report["nodes"] = total_nodes;
+        report["time_ms"] = total_ms;
+        report["nps"] = nps(total_nodes, total_ms);
+        report["positions"] = positions_json;
+        return report;
+    }
+
+    // Уровень по умолчанию: весь набор перебирается за несколько секунд
+    static constexpr int default_level = 5;
+
+  private:
+    static double nps(const uint64_t nodes, const double ms)
+    {
+        return ms > 0 ? double(nodes) * 1000 / ms : 0;
+    }
+};
@@ -1,405 +1,704 @@
-#pragma once
-#include <iostream>
-#include <fstream>
-#include <vector>
-
-#include "../Models/Move.h"
-#include "../Models/Project_path.h"
-//  SDL     
-#ifdef __APPLE__
-    #include <SDL2/SDL.h>
-    #include <SDL2/SDL_image.h>
-#else
-    #include <SDL.h>
-    #include <SDL_image.h>
-#endif
-
-using namespace std;
-
-class Board
-{
-public:
-    Board() = default;
-    //       
-    Board(const unsigned int W, const unsigned int H) : W(W), H(H)
-    {
-    }
-
-    //      
-    int start_draw()
-    {
-        if (SDL_Init(SDL_INIT_EVERYTHING) != 0)
-        {
-            print_exception("SDL_Init can't init SDL2 lib");
-            return 1;
-        }
-        if (W == 0 || H == 0)
-        {
-            SDL_DisplayMode dm;
-            if (SDL_GetDesktopDisplayMode(0, &dm))
-            {
-                print_exception("SDL_GetDesktopDisplayMode can't get desctop display mode");
-                return 1;
-            }
-            W = min(dm.w, dm.h);
-            W -= W / 15;
-            H = W;
-        }
-        //  
-        win = SDL_CreateWindow("Checkers", 0, H / 30, W, H, SDL_WINDOW_RESIZABLE);
-        if (win == nullptr)
-        {
-            print_exception("SDL_CreateWindow can't create window");
-            return 1;
-        }
-        ren = SDL_CreateRenderer(win, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
-        if (ren == nullptr)
-        {
-            print_exception("SDL_CreateRenderer can't create renderer");
-            return 1;
-        }
-        //  
-        board = IMG_LoadTexture(ren, board_path.c_str());
-        w_piece = IMG_LoadTexture(ren, piece_white_path.c_str());
-        b_piece = IMG_LoadTexture(ren, piece_black_path.c_str());
-        w_queen = IMG_LoadTexture(ren, queen_white_path.c_str());
-        b_queen = IMG_LoadTexture(ren, queen_black_path.c_str());
-        back = IMG_LoadTexture(ren, back_path.c_str());
-        replay = IMG_LoadTexture(ren, replay_path.c_str());
-        if (!board || !w_piece || !b_piece || !w_queen || !b_queen || !back || !replay)
-        {
-            print_exception("IMG_LoadTexture can't load main textures from " + textures_path);
-            return 1;
-        }
-        //        
-        SDL_GetRendererOutputSize(ren, &W, &H);
-        make_start_mtx();
-        rerender();
-        return 0;
-    }
-
-    //     
-    void redraw()
-    {
-        game_results = -1;
-        history_mtx.clear();
-        history_beat_series.clear();
-        make_start_mtx();
-        clear_active();
-        clear_highlight();
-    }
-
-    //      move_pos
-    void move_piece(move_pos turn, const int beat_series = 0)
-    {
-        if (turn.xb != -1)
-        {
-            mtx[turn.xb][turn.yb] = 0;
-        }
-        move_piece(turn.x, turn.y, turn.x2, turn.y2, beat_series);
-    }
-
-    //    
-    void move_piece(const POS_T i, const POS_T j, const POS_T i2, const POS_T j2, const int beat_series = 0)
-    {
-        if (mtx[i2][j2])
-        {
-            throw runtime_error("final position is not empty, can't move");
-        }
-        if (!mtx[i][j])
-        {
-            throw runtime_error("begin position is empty, can't move");
-        }
-        //       
-        if ((mtx[i][j] == 1 && i2 == 0) || (mtx[i][j] == 2 && i2 == 7))
-            mtx[i][j] += 2;
-        mtx[i2][j2] = mtx[i][j];
-        drop_piece(i, j);
-        add_history(beat_series);
-    }
-
-    //    
-    void drop_piece(const POS_T i, const POS_T j)
-    {
-        mtx[i][j] = 0;
-        rerender();
-    }
-
-    //    
-    void turn_into_queen(const POS_T i, const POS_T j)
-    {
-        if (mtx[i][j] == 0 || mtx[i][j] > 2)
-        {
-            throw runtime_error("can't turn into queen in this position");
-        }
-        mtx[i][j] += 2;
-        rerender();
-    }
-    //    
-    vector<vector<POS_T>> get_board() const
-    {
-        return mtx;
-    }
-
-    //   
-    void highlight_cells(vector<pair<POS_T, POS_T>> cells)
-    {
-        for (auto pos : cells)
-        {
-            POS_T x = pos.first, y = pos.second;
-            is_highlighted_[x][y] = 1;
-        }
-        rerender();
-    }
-
-    //    
-    void clear_highlight()
-    {
-        for (POS_T i = 0; i < 8; ++i)
-        {
-            is_highlighted_[i].assign(8, 0);
-        }
-        rerender();
-    }
-
-    //   
-    void set_active(const POS_T x, const POS_T y)
-    {
-        active_x = x;
-        active_y = y;
-        rerender();
-    }
-
-    //   
-    void clear_active()
-    {
-        active_x = -1;
-        active_y = -1;
-        rerender();
-    }
-
-    // ,   
-    bool is_highlighted(const POS_T x, const POS_T y)
-    {
-        return is_highlighted_[x][y];
-    }
-
-    //   
-    void rollback()
-    {
-        auto beat_series = max(1, *(history_beat_series.rbegin()));
-        while (beat_series-- && history_mtx.size() > 1)
-        {
-            history_mtx.pop_back();
-            history_beat_series.pop_back();
-        }
-        mtx = *(history_mtx.rbegin());
-        clear_highlight();
-        clear_active();
-    }
-
-    //   
-    void show_final(const int res)
-    {
-        game_results = res;
-        rerender();
-    }
-
-    //   
-    void reset_window_size()
-    {
-        SDL_GetRendererOutputSize(ren, &W, &H);
-        rerender();
-    }
-
-    //   SDL
-    void quit()
-    {
-        SDL_DestroyTexture(board);
-        SDL_DestroyTexture(w_piece);
-        SDL_DestroyTexture(b_piece);
-        SDL_DestroyTexture(w_queen);
-        SDL_DestroyTexture(b_queen);
-        SDL_DestroyTexture(back);
-        SDL_DestroyTexture(replay);
-        SDL_DestroyRenderer(ren);
-        SDL_DestroyWindow(win);
-        SDL_Quit();
-    }
-
-    ~Board()
-    {
-        if (win)
-            quit();
-    }
-
-private:
-    //     
-    void add_history(const int beat_series = 0)
-    {
-        history_mtx.push_back(mtx);
-        history_beat_series.push_back(beat_series);
-    }
-    //    
-    void make_start_mtx()
-    {
-        for (POS_T i = 0; i < 8; ++i)
-        {
-            for (POS_T j = 0; j < 8; ++j)
-            {
-                mtx[i][j] = 0;
-                //   
-                if (i < 3 && (i + j) % 2 == 1)
-                    mtx[i][j] = 2;
-                //   
-                if (i > 4 && (i + j) % 2 == 1)
-                    mtx[i][j] = 1;
-            }
-        }
-        add_history();
-    }
-
-    //   
-    void rerender()
-    {
-        //  
-        SDL_RenderClear(ren);
-        //  
-        SDL_RenderCopy(ren, board, NULL, NULL);
-
-        //  
-        for (POS_T i = 0; i < 8; ++i)
-        {
-            for (POS_T j = 0; j < 8; ++j)
-            {
-                if (!mtx[i][j])
-                    continue;
-                //   
-                int wpos = W * (j + 1) / 10 + W / 120;
-                int hpos = H * (i + 1) / 10 + H / 120;
-                SDL_Rect rect{ wpos, hpos, W / 12, H / 12 };
-
-                //       
-                SDL_Texture* piece_texture;
-                if (mtx[i][j] == 1)
-                    piece_texture = w_piece;
-                else if (mtx[i][j] == 2)
-                    piece_texture = b_piece;
-                else if (mtx[i][j] == 3)
-                    piece_texture = w_queen;
-                else
-                    piece_texture = b_queen;
-
-                SDL_RenderCopy(ren, piece_texture, NULL, &rect);
-            }
-        }
-
-        //    
-        SDL_SetRenderDrawColor(ren, 0, 255, 0, 0);
-        const double scale = 2.5;
-        SDL_RenderSetScale(ren, scale, scale);
-        for (POS_T i = 0; i < 8; ++i)
-        {
-            for (POS_T j = 0; j < 8; ++j)
-            {
-                if (!is_highlighted_[i][j])
-                    continue;
-                SDL_Rect cell{ int(W * (j + 1) / 10 / scale), int(H * (i + 1) / 10 / scale), int(W / 10 / scale),
-                              int(H / 10 / scale) };
-                SDL_RenderDrawRect(ren, &cell);
-            }
-        }
-
-        //   
-        if (active_x != -1)
-        {
-            SDL_SetRenderDrawColor(ren, 255, 0, 0, 0);
-            SDL_Rect active_cell{ int(W * (active_y + 1) / 10 / scale), int(H * (active_x + 1) / 10 / scale),
-                                 int(W / 10 / scale), int(H / 10 / scale) };
-            SDL_RenderDrawRect(ren, &active_cell);
-        }
-        SDL_RenderSetScale(ren, 1, 1);
-
-        // draw arrows
-        SDL_Rect rect_left{ W / 40, H / 40, W / 15, H / 15 };
-        SDL_RenderCopy(ren, back, NULL, &rect_left);
-        SDL_Rect replay_rect{ W * 109 / 120, H / 40, W / 15, H / 15 };
-        SDL_RenderCopy(ren, replay, NULL, &replay_rect);
-
-        //   
-        if (game_results != -1)
-        {
-            string result_path = draw_path;
-            if (game_results == 1)
-                result_path = white_path;
-            else if (game_results == 2)
-                result_path = black_path;
-            SDL_Texture* result_texture = IMG_LoadTexture(ren, result_path.c_str());
-            if (result_texture == nullptr)
-            {
-                print_exception("IMG_LoadTexture can't load game result picture from " + result_path);
-                return;
-            }
-            SDL_Rect res_rect{ W / 5, H * 3 / 10, W * 3 / 5, H * 2 / 5 };
-            SDL_RenderCopy(ren, result_texture, NULL, &res_rect);
-            SDL_DestroyTexture(result_texture);
-        }
-
-        //  
-        SDL_RenderPresent(ren);
-        //    MacOS
-        SDL_Delay(10);
-        SDL_Event windowEvent;
-        SDL_PollEvent(&windowEvent);
-    }
-
-    //  
-    void print_exception(const string& text) {
-        ofstream fout(project_path + "log.txt", ios_base::app);
-        fout << "Error: " << text << ". "<< SDL_GetError() << endl;
-        fout.close();
-    }
-
-  public:
-     //  
-    int W = 0;
-    //  
-    int H = 0;
-    //   
-    vector<vector<vector<POS_T>>> history_mtx;
-
-  private:
-    SDL_Window *win = nullptr;
-    SDL_Renderer *ren = nullptr;
-    // 
-    SDL_Texture *board = nullptr;
-    SDL_Texture *w_piece = nullptr;
-    SDL_Texture *b_piece = nullptr;
-    SDL_Texture *w_queen = nullptr;
-    SDL_Texture *b_queen = nullptr;
-    SDL_Texture *back = nullptr;
-    SDL_Texture *replay = nullptr;
-    //    
-    const string textures_path = project_path + "Textures/";
-    const string board_path = textures_path + "board.png";
-    const string piece_white_path = textures_path + "piece_white.png";
-    const string piece_black_path = textures_path + "piece_black.png";
-    const string queen_white_path = textures_path + "queen_white.png";
-    const string queen_black_path = textures_path + "queen_black.png";
-    const string white_path = textures_path + "white_wins.png";
-    const string black_path = textures_path + "black_wins.png";
-    const string draw_path = textures_path + "draw.png";
-    const string back_path = textures_path + "back.png";
-    const string replay_path = textures_path + "replay.png";
-    //   
-    int active_x = -1, active_y = -1;
-    //   (-1 -  , 1 -  , 2 -  )
-    int game_results = -1;
-    //   
-    vector<vector<bool>> is_highlighted_ = vector<vector<bool>>(8, vector<bool>(8, 0));
-    //   
-    // 0 - , 1 -  , 2 -  , 3 -  , 4 -  
-    vector<vector<POS_T>> mtx = vector<vector<POS_T>>(8, vector<POS_T>(8, 0));
-    //      
-    vector<int> history_beat_series;
-};
+#pragma once
+#include <chrono>
+#include <cmath>
+#include <deque>
+#include <iostream>
+#include <fstream>
+#include <vector>
+
+#include "../Models/Move.h"
+#include "../Models/Project_path.h"
+#include "../Models/Search_stats.h"
+#include "History.h"
+#include "Variant.h"
+// Подключение SDL библиотек в зависимости от платформы
+#ifdef __APPLE__
+    #include <SDL2/SDL.h>
+    #include <SDL2/SDL_image.h>
+#else
+    #include <SDL.h>
+    #include <SDL_image.h>
+#endif
+
+using namespace std;
+
+class Board
+{
+    // Прыжок в очереди анимации: позиция уже изменена, фигура показывается в пути
+    struct jump_animation
+    {
+        move_pos turn;
+        POS_T type = 0;        // фигура до прыжка (превращение в дамку видно после прыжка)
+        POS_T beaten_type = 0; // взятая фигура, 0 - прыжок без взятия
+        chrono::steady_clock::time_point start;
+        bool is_started = false;
+    };
+
+public:
+    Board() = default;
+    // Конструктор с параметрами ширины и высоты доски
+    Board(const unsigned int W, const unsigned int H) : W(W), H(H)
+    {
+    }
+
+    // Инициализация и отрисовка начального состояния доски
+    int start_draw()
+    {
+        if (SDL_Init(SDL_INIT_EVERYTHING) != 0)
+        {
+            print_exception("SDL_Init can't init SDL2 lib");
+            return 1;
+        }
+        if (W == 0 || H == 0)
+        {
+            SDL_DisplayMode dm;
+            if (SDL_GetDesktopDisplayMode(0, &dm))
+            {
+                print_exception("SDL_GetDesktopDisplayMode can't get desctop display mode");
+                return 1;
+            }
+            W = min(dm.w, dm.h);
+            W -= W / 15;
+            H = W;
+        }
+        // Создание окна
+        win = SDL_CreateWindow("Checkers", 0, H / 30, W, H, SDL_WINDOW_RESIZABLE);
+        if (win == nullptr)
+        {
+            print_exception("SDL_CreateWindow can't create window");
+            return 1;
+        }
+        ren = SDL_CreateRenderer(win, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
+        if (ren == nullptr)
+        {
+            print_exception("SDL_CreateRenderer can't create renderer");
+            return 1;
+        }
+        // Загрузка текстур
+        board = IMG_LoadTexture(ren, board_path.c_str());
+        w_piece = IMG_LoadTexture(ren, piece_white_path.c_str());
+        b_piece = IMG_LoadTexture(ren, piece_black_path.c_str());
+        w_queen = IMG_LoadTexture(ren, queen_white_path.c_str());
+        b_queen = IMG_LoadTexture(ren, queen_black_path.c_str());
+        back = IMG_LoadTexture(ren, back_path.c_str());
+        replay = IMG_LoadTexture(ren, replay_path.c_str());
+        if (!board || !w_piece || !b_piece || !w_queen || !b_queen || !back || !replay)
+        {
+            print_exception("IMG_LoadTexture can't load main textures from " + textures_path);
+            return 1;
+        }
+        // Получение размеров рендерера и подготовка к работе доски
+        SDL_GetRendererOutputSize(ren, &W, &H);
+        make_start_mtx();
+        rerender();
+        return 0;
+    }
+
+    // Перерисовка доски в начальное состояние
+    void redraw()
+    {
+        animations.clear();
+        game_results = -1;
+        make_start_mtx();
+        clear_active();
+        clear_highlight();
+    }
+
+    /**
+     * Перемещение фигуры с использованием структуры move_pos
+     * @param animate прыжок ставится в очередь анимации: позиция меняется сразу,
+     *        а фигура плавно движется в кадрах, которые рисует animate_frame
+     */
+    void move_piece(move_pos turn, const int beat_series = 0, const bool animate = false)
+    {
+        if (mtx[turn.x2][turn.y2])
+        {
+            throw runtime_error("final position is not empty, can't move");
+        }
+        if (!mtx[turn.x][turn.y])
+        {
+            throw runtime_error("begin position is empty, can't move");
+        }
+        jump_animation jump{turn, mtx[turn.x][turn.y], turn.xb != -1 ? mtx[turn.xb][turn.yb] : POS_T(0), {}, false};
+        // Ход (и превращение в дамку) выполняется вместе с записью в историю
+        history.apply(mtx, turn, beat_series);
+        if (animate && ren && move_ms > 0)
+        {
+            animations.push_back(jump);
+            animate_frame();
+        }
+        else
+            rerender();
+    }
+
+    // Перемещение фигуры по координатам
+    void move_piece(const POS_T i, const POS_T j, const POS_T i2, const POS_T j2, const int beat_series = 0)
+    {
+        move_piece(move_pos(i, j, i2, j2), beat_series);
+    }
+
+    // Скорость анимации ходов: кадров в секунду и длительность одного прыжка (0 - без анимации)
+    void set_animation(const unsigned int fps, const unsigned int jump_ms)
+    {
+        frame_ms = 1000.0 / max(1u, fps);
+        move_ms = jump_ms;
+    }
+
+    // Идет анимация хода
+    bool is_animating() const
+    {
+        return !animations.empty();
+    }
+
+    /**
+     * Кадр анимации, если с прошлого кадра прошло не меньше 1 / FPS секунды.
+     * Вызывается циклами ожидания (поиск бота, ввод игрока), поэтому анимация не задерживает поиск
+     * @return анимация еще идет
+     */
+    bool animate_frame()
+    {
+        if (animations.empty())
+            return false;
+        const auto now = chrono::steady_clock::now();
+        if (chrono::duration<double, milli>(now - last_frame).count() < frame_ms)
+            return true;
+        // Прыжки идут друг за другом: прыжок начинается, когда становится первым в очереди
+        if (!animations.front().is_started)
+        {
+            animations.front().start = now;
+            animations.front().is_started = true;
+        }
+        while (!animations.empty() && jump_progress(animations.front(), now) >= 1)
+        {
+            animations.pop_front();
+            if (!animations.empty())
+            {
+                animations.front().start = now;
+                animations.front().is_started = true;
+            }
+        }
+        last_frame = now;
+        rerender();
+        return !animations.empty();
+    }
+
+    // Ожидание конца анимации с отрисовкой кадров
+    void finish_animation()
+    {
+        while (animate_frame())
+            SDL_Delay(1);
+    }
+
+    // Удаление фигуры с доски
+    void drop_piece(const POS_T i, const POS_T j)
+    {
+        mtx[i][j] = 0;
+        rerender();
+    }
+
+    // Превращение фигуры в дамку
+    void turn_into_queen(const POS_T i, const POS_T j)
+    {
+        if (mtx[i][j] == 0 || mtx[i][j] > 2)
+        {
+            throw runtime_error("can't turn into queen in this position");
+        }
+        mtx[i][j] += 2;
+        rerender();
+    }
+    // Получение текущего состояния доски
+    vector<vector<POS_T>> get_board() const
+    {
+        return mtx;
+    }
+
+    // Подсветка указанных клеток
+    void highlight_cells(vector<pair<POS_T, POS_T>> cells)
+    {
+        for (auto pos : cells)
+        {
+            POS_T x = pos.first, y = pos.second;
+            is_highlighted_[x][y] = 1;
+        }
+        rerender();
+    }
+
+    // Очистка подсветки всех клеток
+    void clear_highlight()
+    {
+        for (POS_T i = 0; i < board_size; ++i)
+        {
+            is_highlighted_[i].assign(board_size, 0);
+        }
+        rerender();
+    }
+
+    // Установка активной клетки
+    void set_active(const POS_T x, const POS_T y)
+    {
+        active_x = x;
+        active_y = y;
+        rerender();
+    }
+
+    // Очистка активной клетки
+    void clear_active()
+    {
+        active_x = -1;
+        active_y = -1;
+        rerender();
+    }
+
+    // Проверка, подсвечена ли клетка
+    bool is_highlighted(const POS_T x, const POS_T y)
+    {
+        return is_highlighted_[x][y];
+    }
+
+    // Установка позиции mtx (начало истории ходов)
+    void set_board(const vector<vector<POS_T>> &new_mtx)
+    {
+        animations.clear();
+        mtx = new_mtx;
+        history.reset(mtx);
+        rerender();
+    }
+
+    // Отмена последнего хода
+    void rollback()
+    {
+        animations.clear();
+        auto beat_series = max(1, history.last_beat_series());
+        while (beat_series-- && history.size() > 0)
+        {
+            history.undo(mtx);
+        }
+        clear_highlight();
+        clear_active();
+    }
+
+    // Показ статистики поиска бота поверх доски
+    void show_search_info(const search_info &info)
+    {
+        overlay = info;
+        is_overlay = true;
+        rerender();
+    }
+
+    // Скрытие статистики поиска
+    void clear_search_info()
+    {
+        if (!is_overlay)
+            return;
+        is_overlay = false;
+        rerender();
+    }
+
+    // Показ подсказанного хода игроку стрелками
+    void show_hint(const vector<move_pos> &turns)
+    {
+        hint = turns;
+        rerender();
+    }
+
+    // Скрытие подсказки
+    void clear_hint()
+    {
+        if (hint.empty())
+            return;
+        hint.clear();
+        rerender();
+    }
+
+    // Показ часов партии: остаток времени белых и черных, active - чьи часы идут (-1 - ничьи)
+    void show_clock(const string &white, const string &black, const int active)
+    {
+        clock_text[0] = white;
+        clock_text[1] = black;
+        clock_active = active;
+        rerender();
+    }
+
+    // Отображение результата игры
+    void show_final(const int res)
+    {
+        game_results = res;
+        rerender();
+    }
+
+    // Обновление размеров окна
+    void reset_window_size()
+    {
+        SDL_GetRendererOutputSize(ren, &W, &H);
+        rerender();
+    }
+
+    // Очистка ресурсов SDL
+    void quit()
+    {
+        SDL_DestroyTexture(board);
+        SDL_DestroyTexture(w_piece);
+        SDL_DestroyTexture(b_piece);
+        SDL_DestroyTexture(w_queen);
+        SDL_DestroyTexture(b_queen);
+        SDL_DestroyTexture(back);
+        SDL_DestroyTexture(replay);
+        SDL_DestroyRenderer(ren);
+        SDL_DestroyWindow(win);
+        SDL_Quit();
+    }
+
+    ~Board()
+    {
+        if (win)
+            quit();
+    }
+
+private:
+    // Создание начального состояния доски
+    void make_start_mtx()
+    {
+        for (POS_T i = 0; i < board_size; ++i)
+        {
+            for (POS_T j = 0; j < board_size; ++j)
+            {
+                mtx[i][j] = 0;
+                // Расстановка черных фигур
+                if (i < game_variant::start_rows && (i + j) % 2 == 1)
+                    mtx[i][j] = 2;
+                // Расстановка белых фигур
+                if (i >= board_size - game_variant::start_rows && (i + j) % 2 == 1)
+                    mtx[i][j] = 1;
+            }
+        }
+        history.reset(mtx);
+    }
+
+    // Полная перерисовка доски
+    void rerender()
+    {
+        // Доска без окна (например, в замерах скорости) не рисуется
+        if (!ren)
+            return;
+        // Очистка рендерера
+        SDL_RenderClear(ren);
+        // Отрисовка доски
+        SDL_RenderCopy(ren, board, NULL, NULL);
+
+        // Отрисовка фигур; фигура, которая еще движется, рисуется отдельно
+        for (POS_T i = 0; i < board_size; ++i)
+        {
+            for (POS_T j = 0; j < board_size; ++j)
+            {
+                if (mtx[i][j] && !is_animated_cell(i, j))
+                    draw_piece(mtx[i][j], i, j);
+            }
+        }
+        // Взятые фигуры остаются на доске до конца своего прыжка, прыгающая фигура - между клетками
+        if (!animations.empty())
+        {
+            for (const auto &jump : animations)
+            {
+                if (jump.beaten_type)
+                    draw_piece(jump.beaten_type, jump.turn.xb, jump.turn.yb);
+            }
+            const auto &jump = animations.front();
+            const double t = jump.is_started ? jump_progress(jump, chrono::steady_clock::now()) : 0;
+            // Плавный разгон и торможение
+            const double s = t * t * (3 - 2 * t);
+            draw_piece(jump.type, jump.turn.x + (jump.turn.x2 - jump.turn.x) * s,
+                       jump.turn.y + (jump.turn.y2 - jump.turn.y) * s);
+        }
+
+        // Отрисовка подсветки возможных ходов
+        SDL_SetRenderDrawColor(ren, 0, 255, 0, 0);
+        const double scale = 2.5;
+        SDL_RenderSetScale(ren, scale, scale);
+        for (POS_T i = 0; i < board_size; ++i)
+        {
+            for (POS_T j = 0; j < board_size; ++j)
+            {
+                if (!is_highlighted_[i][j])
+                    continue;
+                SDL_Rect cell{ int(W * (j + 1) / cells / scale), int(H * (i + 1) / cells / scale),
+                              int(W / cells / scale), int(H / cells / scale) };
+                SDL_RenderDrawRect(ren, &cell);
+            }
+        }
+
+        // Отрисовка активной клетки
+        if (active_x != -1)
+        {
+            SDL_SetRenderDrawColor(ren, 255, 0, 0, 0);
+            SDL_Rect active_cell{ int(W * (active_y + 1) / cells / scale), int(H * (active_x + 1) / cells / scale),
+                                 int(W / cells / scale), int(H / cells / scale) };
+            SDL_RenderDrawRect(ren, &active_cell);
+        }
+        SDL_RenderSetScale(ren, 1, 1);
+
+        // draw arrows
+        SDL_Rect rect_left{ W / 40, H / 40, W / 15, H / 15 };
+        SDL_RenderCopy(ren, back, NULL, &rect_left);
+        SDL_Rect replay_rect{ W * 109 / 120, H / 40, W / 15, H / 15 };
+        SDL_RenderCopy(ren, replay, NULL, &replay_rect);
+
+        // Отрисовка подсказки
+        if (!hint.empty())
+        {
+            SDL_SetRenderDrawColor(ren, 0, 160, 255, 0);
+            for (const auto &turn : hint)
+                draw_arrow(turn.x, turn.y, turn.x2, turn.y2);
+        }
+
+        // Отрисовка часов в верхнем поле между кнопками
+        if (!clock_text[0].empty())
+        {
+            const int px = max(1, H / 120);
+            for (int side = 0; side < 2; ++side)
+            {
+                if (side == clock_active)
+                    SDL_SetRenderDrawColor(ren, 255, 200, 0, 255);
+                else
+                    SDL_SetRenderDrawColor(ren, 255, 255, 255, 255);
+                draw_text((side ? "B " : "W ") + clock_text[side], W * (side ? 11 : 3) / 20, H / 20 - px * 5 / 2, px,
+                          W * 3 / 10);
+            }
+        }
+
+        // Отрисовка статистики поиска
+        if (is_overlay)
+            draw_overlay();
+
+        // Отрисовка результата игры
+        if (game_results != -1)
+        {
+            string result_path = draw_path;
+            if (game_results == 1)
+                result_path = white_path;
+            else if (game_results == 2)
+                result_path = black_path;
+            SDL_Texture* result_texture = IMG_LoadTexture(ren, result_path.c_str());
+            if (result_texture == nullptr)
+            {
+                print_exception("IMG_LoadTexture can't load game result picture from " + result_path);
+                return;
+            }
+            SDL_Rect res_rect{ W / 5, H * 3 / 10, W * 3 / 5, H * 2 / 5 };
+            SDL_RenderCopy(ren, result_texture, NULL, &res_rect);
+            SDL_DestroyTexture(result_texture);
+        }
+
+        // Обновление экрана
+        SDL_RenderPresent(ren);
+        // Небольшая задержка для MacOS
+        SDL_Delay(10);
+        SDL_Event windowEvent;
+        SDL_PollEvent(&windowEvent);
+    }
+
+    // Фигура type в точке (x, y) доски (дробные координаты - между клетками)
+    void draw_piece(const POS_T type, const double x, const double y)
+    {
+        // Расчет позиции фигуры: фигура занимает 5/6 клетки и стоит в ее середине
+        int wpos = int(W * (y + 1) / cells) + W / (cells * 12);
+        int hpos = int(H * (x + 1) / cells) + H / (cells * 12);
+        SDL_Rect rect{ wpos, hpos, W * 5 / (cells * 6), H * 5 / (cells * 6) };
+
+        // Выбор текстуры в зависимости от типа фигуры
+        SDL_Texture* piece_texture;
+        if (type == 1)
+            piece_texture = w_piece;
+        else if (type == 2)
+            piece_texture = b_piece;
+        else if (type == 3)
+            piece_texture = w_queen;
+        else
+            piece_texture = b_queen;
+
+        SDL_RenderCopy(ren, piece_texture, NULL, &rect);
+    }
+
+    // На клетке стоит фигура, прыжки которой еще не показаны
+    bool is_animated_cell(const POS_T x, const POS_T y) const
+    {
+        for (const auto &jump : animations)
+        {
+            if (jump.turn.x2 == x && jump.turn.y2 == y)
+                return true;
+        }
+        return false;
+    }
+
+    // Доля прошедшего времени прыжка (от 0 до 1)
+    double jump_progress(const jump_animation &jump, const chrono::steady_clock::time_point now) const
+    {
+        if (move_ms == 0)
+            return 1;
+        return min(1.0, chrono::duration<double, milli>(now - jump.start).count() / move_ms);
+    }
+
+    // Статистика поиска: стрелки лучшей цепочки ходов и текст в нижнем поле доски
+    void draw_overlay()
+    {
+        SDL_SetRenderDrawBlendMode(ren, SDL_BLENDMODE_BLEND);
+        SDL_SetRenderDrawColor(ren, 255, 200, 0, 220);
+        for (auto turn : overlay.pv)
+            draw_arrow(turn.x, turn.y, turn.x2, turn.y2);
+
+        // Полупрозрачная подложка
+        SDL_Rect panel{ W / cells, H * (cells - 1) / cells + H / 200, W * board_size / cells, H / cells - H / 100 };
+        SDL_SetRenderDrawColor(ren, 0, 0, 0, 160);
+        SDL_RenderFillRect(ren, &panel);
+
+        string pv;
+        for (size_t i = 0; i < overlay.pv.size(); ++i)
+        {
+            const move_pos &turn = overlay.pv[i];
+            if (i == 0)
+                pv += cell_name(turn.x, turn.y);
+            pv += (turn.xb != -1 ? ':' : '-') + cell_name(turn.x2, turn.y2);
+        }
+        char time_str[32];
+        snprintf(time_str, sizeof(time_str), "%.2f S", overlay.elapsed_ms / 1000);
+        const string line1 = "DEPTH " + to_string(overlay.depth) + "  NODES " + format_count(overlay.nodes);
+        const string line2 = format_count(uint64_t(overlay.nps)) + " N/S  " + time_str + "  PV " + pv;
+
+        // Размер "пикселя" шрифта 3x5: две строки по 5 точек с промежутками
+        const int px = max(1, panel.h / 13);
+        SDL_SetRenderDrawColor(ren, 255, 255, 255, 255);
+        draw_text(line1, panel.x + px * 2, panel.y + px * 1, px, panel.w - px * 4);
+        draw_text(line2, panel.x + px * 2, panel.y + px * 7, px, panel.w - px * 4);
+        SDL_SetRenderDrawBlendMode(ren, SDL_BLENDMODE_NONE);
+    }
+
+    // Стрелка из центра клетки (x, y) в центр клетки (x2, y2)
+    void draw_arrow(const POS_T x, const POS_T y, const POS_T x2, const POS_T y2)
+    {
+        const int x_from = W * (y + 1) / cells + W / (cells * 2), y_from = H * (x + 1) / cells + H / (cells * 2);
+        const int x_to = W * (y2 + 1) / cells + W / (cells * 2), y_to = H * (x2 + 1) / cells + H / (cells * 2);
+        const int width = max(1, W / 250);
+        for (int d = -width; d <= width; ++d)
+        {
+            SDL_RenderDrawLine(ren, x_from + d, y_from, x_to + d, y_to);
+            SDL_RenderDrawLine(ren, x_from, y_from + d, x_to, y_to + d);
+        }
+        // Наконечник
+        const double angle = atan2(y_to - y_from, x_to - x_from);
+        const double len = W / 30.0;
+        for (const double side : {angle + 2.6, angle - 2.6})
+        {
+            for (int d = -width; d <= width; ++d)
+            {
+                SDL_RenderDrawLine(ren, x_to + d, y_to, x_to + d + int(len * cos(side)), y_to + int(len * sin(side)));
+            }
+        }
+    }
+
+    // Текст шрифтом 3x5 (цифры, заглавные латинские буквы и знаки " -./:")
+    void draw_text(const string &text, int x, const int y, const int px, const int max_width)
+    {
+        const int right = x + max_width;
+        for (char c : text)
+        {
+            if (x + px * 3 > right)
+                break;
+            c = char(toupper(c));
+            const int glyph = (c >= ' ' && c <= 'Z') ? font_3x5[c - ' '] : 0;
+            for (int bit = 0; bit < 15; ++bit)
+            {
+                if (!(glyph >> (14 - bit) & 1))
+                    continue;
+                SDL_Rect dot{ x + bit % 3 * px, y + bit / 3 * px, px, px };
+                SDL_RenderFillRect(ren, &dot);
+            }
+            x += px * 4;
+        }
+    }
+
+    // Краткая запись больших чисел: 1234567 -> 1.2M
+    static string format_count(const uint64_t count)
+    {
+        char buf[32];
+        if (count >= 10000000)
+            snprintf(buf, sizeof(buf), "%lluM", (unsigned long long)(count / 1000000));
+        else if (count >= 1000000)
+            snprintf(buf, sizeof(buf), "%.1fM", count / 1e6);
+        else if (count >= 10000)
+            snprintf(buf, sizeof(buf), "%lluK", (unsigned long long)(count / 1000));
+        else
+            snprintf(buf, sizeof(buf), "%llu", (unsigned long long)count);
+        return buf;
+    }
+
+    // Логирование ошибок
+    void print_exception(const string& text) {
+        ofstream fout(project_path + "log.txt", ios_base::app);
+        fout << "Error: " << text << ". "<< SDL_GetError() << endl;
+        fout.close();
+    }
+
+  public:
+    // Клеток по стороне окна: доска и поля шириной в клетку с каждой стороны
+    static constexpr int cells = board_size + 2;
+     // Ширина окна
+    int W = 0;
+    // Высота окна
+    int H = 0;
+    // История партии: журнал ходов и хеши позиций
+    History history;
+
+  private:
+    SDL_Window *win = nullptr;
+    SDL_Renderer *ren = nullptr;
+    // Текстуры
+    SDL_Texture *board = nullptr;
+    SDL_Texture *w_piece = nullptr;
+    SDL_Texture *b_piece = nullptr;
+    SDL_Texture *w_queen = nullptr;
+    SDL_Texture *b_queen = nullptr;
+    SDL_Texture *back = nullptr;
+    SDL_Texture *replay = nullptr;
+    // Пути к файлам текстур
+    const string textures_path = project_path + "Textures/";
+    const string board_path = textures_path + "board.png";
+    const string piece_white_path = textures_path + "piece_white.png";
+    const string piece_black_path = textures_path + "piece_black.png";
+    const string queen_white_path = textures_path + "queen_white.png";
+    const string queen_black_path = textures_path + "queen_black.png";
+    const string white_path = textures_path + "white_wins.png";
+    const string black_path = textures_path + "black_wins.png";
+    const string draw_path = textures_path + "draw.png";
+    const string back_path = textures_path + "back.png";
+    const string replay_path = textures_path + "replay.png";
+    // Координаты активной клетки
+    int active_x = -1, active_y = -1;
+    // Результат игры (-1 - игра продолжается, 1 - победа белых, 2 - победа черных)
+    int game_results = -1;
+    // Показывается ли статистика поиска
+    bool is_overlay = false;
+    // Статистика поиска для отображения
+    search_info overlay;
+    // Подсказанный игроку ход (пустой - подсказки нет)
+    vector<move_pos> hint;
+    // Очередь анимации: прыжки показываются по одному
+    deque<jump_animation> animations;
+    // Длительность кадра и прыжка в мс
+    double frame_ms = 1000.0 / 60;
+    unsigned int move_ms = 0;
+    // Время последнего кадра анимации
+    chrono::steady_clock::time_point last_frame;
+    // Остаток времени на часах (пустые строки - партия без часов) и чьи часы идут
+    string clock_text[2];
+    int clock_active = -1;
+    // Шрифт 3x5 для символов от ' ' до 'Z': 15 бит, строки сверху вниз
+    static constexpr uint16_t font_3x5[59] = {
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 448, 2, 4772, 31599, 11415, 29671, 29391,
+        23497, 31183, 31215, 29330, 31727, 31695, 1040, 0, 0, 0, 0, 0, 0, 11245, 27566, 14627, 27502, 31143, 31140,
+        14699, 23533, 29847, 4714, 23469, 18727, 24557, 27501, 11114, 27556, 11123, 27565, 14478, 29842, 23407, 23402,
+        23549, 23213, 23186, 29351 };
+    // Матрица подсвеченных клеток
+    vector<vector<bool>> is_highlighted_ = vector<vector<bool>>(board_size, vector<bool>(board_size, 0));
+    // Текущее состояние доски
+    // 0 - пусто, 1 - белая фигура, 2 - черная фигура, 3 - белая дамка, 4 - черная дамка
+    vector<vector<POS_T>> mtx = vector<vector<POS_T>>(board_size, vector<POS_T>(board_size, 0));
+};
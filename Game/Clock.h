@@ -0,0 +1,173 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <string>
+
+using namespace std;
+
+// Шахматные часы партии: основное время и добавка за каждый сделанный ход (индекс - цвет, 0 - белые)
+class GameClock
+{
+  public:
+    // Сброс часов; base_ms = 0 - партия без часов
+    void reset(const double base_ms, const double increment_ms)
+    {
+        is_enabled = base_ms > 0;
+        remaining[0] = remaining[1] = base_ms;
+        increment = increment_ms;
+        running = -1;
+    }
+
+    bool enabled() const
+    {
+        return is_enabled;
+    }
+
+    // Запуск часов стороны color (часы другой стороны при этом не идут)
+    void start(const bool color)
+    {
+        if (!is_enabled)
+            return;
+        running = color;
+        start_time = chrono::steady_clock::now();
+    }
+
+    // Остановка часов после хода: прошедшее время вычитается, добавка начисляется
+    void stop()
+    {
+        if (running == -1)
+            return;
+        remaining[running] = max(0.0, remaining[running] - elapsed_ms()) + increment;
+        running = -1;
+    }
+
+    // Остаток времени стороны color с учетом идущего хода
+    double remaining_ms(const bool color) const
+    {
+        const double res = remaining[color] - (running == int(color) ? elapsed_ms() : 0);
+        return max(0.0, res);
+    }
+
+    // Цвет, чьи часы идут (-1 - часы стоят)
+    int running_color() const
+    {
+        return running;
+    }
+
+    double increment_ms() const
+    {
+        return increment;
+    }
+
+    // Время стороны color истекло
+    bool is_flagged(const bool color) const
+    {
+        return enabled() && remaining_ms(color) <= 0;
+    }
+
+    // Запись остатка времени для окна: "4:59.8"
+    static string format(const double ms)
+    {
+        const long long tenths = (long long)(ms / 100);
+        char buf[32];
+        snprintf(buf, sizeof(buf), "%lld:%02lld.%lld", tenths / 600, tenths / 10 % 60, tenths % 10);
+        return buf;
+    }
+
+  private:
+    double elapsed_ms() const
+    {
+        return chrono::duration<double, milli>(chrono::steady_clock::now() - start_time).count();
+    }
+
+    bool is_enabled = false;
+    double remaining[2] = {0, 0};
+    double increment = 0;
+    int running = -1; // цвет, чьи часы идут (-1 - часы стоят)
+    chrono::steady_clock::time_point start_time;
+};
+
+/**
+ * Распределение времени бота по ходам.
+ * Базовая доля - остаток времени на оставшиеся ходы плюс добавка. Единственный ход делается сразу,
+ * при выборе между взятиями доля больше. Во время поиска после каждого уровня решается,
+ * начинать ли следующий: при смене лучшего хода время продлевается, при устойчивом лучшем ходе - сокращается.
+ * Жесткий предел всегда меньше остатка на запас reserve, поэтому бот не просрочивает время.
+ * Пределы всегда положительны (0 в search_limits - поиск без ограничения): без запаса времени
+ * поиск получает min_think_ms или половину добавки, но не больше половины остатка
+ */
+class TimeManager
+{
+  public:
+    /**
+     * @param remaining_ms остаток времени бота
+     * @param increment_ms добавка за ход
+     * @param turns_left сколько ходов бота может остаться до конца партии
+     * @param legal_moves число ходов (серий взятий) в позиции
+     * @param captures ходы - взятия
+     */
+    TimeManager(const double remaining_ms, const double increment_ms, const int turns_left, const size_t legal_moves,
+                const bool captures)
+    {
+        const double reserve = min(remaining_ms / 10, max_reserve_ms) + overhead_ms;
+        const double available = max(0.0, remaining_ms - reserve);
+        // Нижний предел не больше половины остатка; при пустых часах время уже вышло, и предел
+        // остается min_think_ms только потому, что 0 означает поиск без ограничения
+        double floor_ms = min(max(min_think_ms, min(increment_ms, remaining_ms) / 2), remaining_ms / 2);
+        if (floor_ms <= 0)
+            floor_ms = min_think_ms;
+        soft = hard = floor_ms;
+        if (legal_moves <= 1 || available <= 0)
+            return;
+        const int moves_to_go = max(min_moves_to_go, min(turns_left, max_moves_to_go));
+        double base = available / moves_to_go + increment_ms * 0.9;
+        if (captures)
+            base *= capture_factor;
+        hard = max(floor_ms, min(available, base * hard_factor));
+        soft = max(floor_ms, min(base, hard));
+    }
+
+    // Основная доля времени на ход
+    double soft_ms() const
+    {
+        return soft;
+    }
+
+    // Предел, после которого поиск прерывается
+    double hard_ms() const
+    {
+        return hard;
+    }
+
+    /**
+     * Решение после завершенного уровня поиска
+     * @param elapsed_ms время с начала хода
+     * @param best_changed лучший ход изменился на этом уровне
+     * @return true - следующий уровень не начинать
+     */
+    bool should_stop(const double elapsed_ms, const bool best_changed)
+    {
+        stable = best_changed ? 0 : stable + 1;
+        const double factor = best_changed ? unstable_factor : stable >= stable_iterations ? stable_factor : 1.0;
+        // Следующий уровень обычно дольше всех предыдущих вместе, поэтому он начинается,
+        // только если до цели осталось больше половины
+        return elapsed_ms >= min(hard, soft * factor) / 2;
+    }
+
+  private:
+    static constexpr double overhead_ms = 30;    // запас на отрисовку и переключение потоков
+    static constexpr double max_reserve_ms = 1000;
+    static constexpr double min_think_ms = 1; // нижний предел времени на ход
+    static constexpr int min_moves_to_go = 10;
+    static constexpr int max_moves_to_go = 30;
+    static constexpr double capture_factor = 1.3;
+    static constexpr double hard_factor = 4;
+    static constexpr double unstable_factor = 1.8;
+    static constexpr double stable_factor = 0.5;
+    static constexpr int stable_iterations = 3;
+
+    double soft = 0;
+    double hard = 0;
+    int stable = 0;
+};
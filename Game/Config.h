@@ -1,9 +1,24 @@
 #pragma once
+#include <atomic>
+#include <chrono>
+#include <filesystem>
 #include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
 #include <nlohmann/json.hpp>
+#ifdef __linux__
+    #include <poll.h>
+    #include <sys/inotify.h>
+    #include <unistd.h>
+#endif
 using json = nlohmann::json;
+using namespace std;
 
 #include "../Models/Project_path.h"
+#include "../Models/Settings.h"
+#include "Levels.h"
 
 class Config
 {
@@ -12,39 +27,320 @@ class Config
     {
         reload();
     }
+
+    ~Config()
+    {
+        stop_watch();
+    }
+
+    Config(const Config &) = delete;
+    Config &operator=(const Config &) = delete;
+
     /**
-  * @brief     JSON-
+  * @brief Перезагружает конфигурационные данные из JSON-файла
   *
-  *    :
-  * 1.    "settings.json"   
-  * 2.      JSON
-  * 3.   
+  * Метод выполняет следующие действия:
+  * 1. Открывает файл настроек "settings.json" из директории проекта
+  * 2. Парсит содержимое файла и проверяет значения
+  * 3. Атомарно заменяет текущий снимок настроек новым
   *
-  * @note        JSON,
-  *            nlohmann/json
+  * @note Если файл не существует, содержит некорректный JSON или недопустимые значения,
+  *       будет выброшено исключение, а текущий снимок останется прежним
   */
 
     void reload()
     {
-        std::ifstream fin(project_path + "settings.json");
+        ifstream fin(project_path + "settings.json");
+        if (!fin)
+            throw runtime_error("can't open " + project_path + "settings.json");
+        json config;
         fin >> config;
         fin.close();
+        atomic_store(&settings, make_shared<const Settings>(parse(config)));
+    }
+
+    /**
+ * @brief Текущий снимок настроек
+ *
+ * @return Неизменяемый снимок; его можно хранить и читать из любого потока,
+ *         перезагрузка файла на него не влияет
+ */
+
+    shared_ptr<const Settings> snapshot() const
+    {
+        return atomic_load(&settings);
     }
+
     /**
- * @brief     
+ * @brief Запускает фоновое отслеживание изменений settings.json
  *
- * @param setting_dir      
- * @param setting_name     
- * @return json&      
- * @note     ,  
- *         json,     is_null()
+ * После записи файла настройки перечитываются автоматически. На Linux используется inotify
+ * (отслеживается каталог, так как редакторы часто заменяют файл переименованием),
+ * на других платформах время изменения файла проверяется дважды в секунду.
+ * Ошибки перезагрузки записываются в log.txt, прежний снимок при этом сохраняется.
  */
 
-    auto operator()(const string &setting_dir, const string &setting_name) const
+    void watch()
+    {
+        if (watcher.joinable())
+            return;
+        is_watching = true;
+        watcher = thread(&Config::watch_loop, this);
+    }
+
+    // Остановка фонового отслеживания
+    void stop_watch()
     {
-        return config[setting_dir][setting_name];
+        is_watching = false;
+        if (watcher.joinable())
+            watcher.join();
+    }
+
+    // Число успешных перезагрузок (включая первую загрузку)
+    unsigned int version() const
+    {
+        return reloads;
     }
 
   private:
-    json config; //       JSON
+    // Разбор и проверка всех значений настроек
+    static Settings parse(const json &config)
+    {
+        Settings s;
+        s.width = get_unsigned(config, "WindowSize", "Width", s.width);
+        s.height = get_unsigned(config, "WindowSize", "Hight", s.height);
+
+        s.is_bot[0] = get_bool(config, "Bot", "IsWhiteBot", s.is_bot[0]);
+        s.is_bot[1] = get_bool(config, "Bot", "IsBlackBot", s.is_bot[1]);
+        s.bot_level[0] = get_unsigned(config, "Bot", "WhiteBotLevel", s.bot_level[0], max_bot_level);
+        s.bot_level[1] = get_unsigned(config, "Bot", "BlackBotLevel", s.bot_level[1], max_bot_level);
+        const string scoring = get_string(config, "Bot", "BotScoringType", "NumberAndPotential");
+        if (scoring == "NumberOnly")
+            s.scoring = ScoringType::NumberOnly;
+        else if (scoring == "NumberAndPotential")
+            s.scoring = ScoringType::NumberAndPotential;
+        else if (scoring == "NumberAndStructure")
+            s.scoring = ScoringType::NumberAndStructure;
+        else
+            throw runtime_error(
+                "Bot.BotScoringType must be \"NumberOnly\", \"NumberAndPotential\" or \"NumberAndStructure\"");
+        s.eval_cache = get_bool(config, "Bot", "EvalCache", s.eval_cache);
+        s.endgame = get_bool(config, "Bot", "Endgame", s.endgame);
+        s.bot_delay_ms = get_unsigned(config, "Bot", "BotDelayMS", s.bot_delay_ms);
+        s.no_random = get_bool(config, "Bot", "NoRandom", s.no_random);
+        const string optimization = get_string(config, "Bot", "Optimization", "O1");
+        if (optimization == "O0")
+            s.optimization = Optimization::O0;
+        else if (optimization == "O1")
+            s.optimization = Optimization::O1;
+        else if (optimization == "O2")
+            s.optimization = Optimization::O2;
+        else
+            throw runtime_error("Bot.Optimization must be \"O0\", \"O1\" or \"O2\"");
+        s.search_overlay = get_bool(config, "Bot", "SearchOverlay", s.search_overlay);
+        const string engine = get_string(config, "Bot", "Engine", "AlphaBeta");
+        if (engine == "AlphaBeta")
+            s.engine = EngineType::AlphaBeta;
+        else if (engine == "Mcts")
+            s.engine = EngineType::Mcts;
+        else
+            throw runtime_error("Bot.Engine must be \"AlphaBeta\" or \"Mcts\"");
+        const string difficulty = get_string(config, "Bot", "Difficulty", "Depth");
+        if (difficulty == "Depth")
+            s.difficulty = Difficulty::Depth;
+        else if (difficulty == "Budget")
+            s.difficulty = Difficulty::Budget;
+        else
+            throw runtime_error("Bot.Difficulty must be \"Depth\" or \"Budget\"");
+        if (s.difficulty == Difficulty::Budget && max(s.bot_level[0], s.bot_level[1]) > max_budget_level)
+            throw runtime_error("Bot levels must not exceed " + to_string(max_budget_level) +
+                                " when Bot.Difficulty is \"Budget\"");
+
+        s.animation_fps = get_unsigned(config, "Animation", "FPS", s.animation_fps, 240);
+        if (!s.animation_fps)
+            throw runtime_error("Animation.FPS must be positive");
+        s.animation_move_ms = get_unsigned(config, "Animation", "MoveMS", s.animation_move_ms, 10000);
+
+        const string policy = get_string(config, "Mcts", "Policy", "UCT");
+        if (policy == "UCT")
+            s.mcts_policy = MctsPolicy::UCT;
+        else if (policy == "PUCT")
+            s.mcts_policy = MctsPolicy::PUCT;
+        else
+            throw runtime_error("Mcts.Policy must be \"UCT\" or \"PUCT\"");
+        s.mcts_threads = get_unsigned(config, "Mcts", "Threads", s.mcts_threads, 256);
+        if (!s.mcts_threads)
+            throw runtime_error("Mcts.Threads must be positive");
+        s.mcts_time_ms = get_unsigned(config, "Mcts", "TimeMS", s.mcts_time_ms);
+        s.mcts_playouts = get_unsigned(config, "Mcts", "Playouts", s.mcts_playouts, 100000000);
+        if (!s.mcts_time_ms && !s.mcts_playouts)
+            throw runtime_error("Mcts.TimeMS and Mcts.Playouts can't both be 0");
+        s.mcts_exploration = get_double(config, "Mcts", "Exploration", s.mcts_exploration);
+        s.mcts_eval_rollouts = get_bool(config, "Mcts", "EvalRollouts", s.mcts_eval_rollouts);
+        s.mcts_rollout_turns = get_unsigned(config, "Mcts", "RolloutTurns", s.mcts_rollout_turns, 1000);
+        s.mcts_memory_mb = get_unsigned(config, "Mcts", "MemoryMB", s.mcts_memory_mb, 65536);
+        if (!s.mcts_memory_mb)
+            throw runtime_error("Mcts.MemoryMB must be positive");
+
+        s.hint = get_bool(config, "Hint", "Enabled", s.hint);
+        s.hint_level = get_unsigned(config, "Hint", "Level", s.hint_level, max_bot_level);
+
+        s.max_turns = get_unsigned(config, "Game", "MaxNumTurns", s.max_turns);
+        s.repetition_draw = get_unsigned(config, "Game", "RepetitionDraw", s.repetition_draw);
+        s.no_progress_turns = get_unsigned(config, "Game", "NoProgressTurns", s.no_progress_turns);
+        s.pdn_file = get_string(config, "Game", "PdnFile", s.pdn_file.c_str());
+
+        s.clock_base_ms = get_unsigned(config, "Clock", "BaseMS", s.clock_base_ms, 100000000);
+        s.clock_increment_ms = get_unsigned(config, "Clock", "IncrementMS", s.clock_increment_ms, 100000000);
+
+        s.solver = get_bool(config, "Solver", "Enabled", s.solver);
+        s.solver_max_pieces = get_unsigned(config, "Solver", "MaxPieces", s.solver_max_pieces, 24);
+        s.solver_threads = get_unsigned(config, "Solver", "Threads", s.solver_threads, 256);
+        if (!s.solver_threads)
+            throw runtime_error("Solver.Threads must be positive");
+        s.solver_memory_mb = get_unsigned(config, "Solver", "MemoryMB", s.solver_memory_mb, 65536);
+        if (!s.solver_memory_mb)
+            throw runtime_error("Solver.MemoryMB must be positive");
+        s.solver_nodes = get_unsigned(config, "Solver", "Nodes", s.solver_nodes, 4000000000u);
+
+        s.tt_size_mb = get_unsigned(config, "TranspositionTable", "SizeMB", s.tt_size_mb, 65536);
+        s.tt_file = get_string(config, "TranspositionTable", "File", s.tt_file.c_str());
+
+        s.cache_file = get_string(config, "AnalysisCache", "File", s.cache_file.c_str());
+        s.cache_min_depth = get_unsigned(config, "AnalysisCache", "MinDepth", s.cache_min_depth, 64);
+
+        s.telemetry_file = get_string(config, "Telemetry", "File", s.telemetry_file.c_str());
+
+        s.trace_file = get_string(config, "Trace", "File", s.trace_file.c_str());
+        s.trace_sample_rate = get_unsigned(config, "Trace", "SampleRate", s.trace_sample_rate, 1 << 20);
+        if (!s.trace_sample_rate)
+            throw runtime_error("Trace.SampleRate must be positive");
+        return s;
+    }
+
+    // Значение параметра или nullptr, если его нет в файле
+    static const json *find(const json &config, const char *dir, const char *name)
+    {
+        if (!config.contains(dir) || !config[dir].contains(name))
+            return nullptr;
+        return &config[dir][name];
+    }
+
+    static unsigned int get_unsigned(const json &config, const char *dir, const char *name,
+                                     const unsigned int def, const unsigned int max_value = 1000000)
+    {
+        const json *value = find(config, dir, name);
+        if (!value)
+            return def;
+        if (!value->is_number_unsigned() || value->get<unsigned int>() > max_value)
+            throw runtime_error(string(dir) + "." + name + " must be an unsigned int not greater than " +
+                                     to_string(max_value));
+        return value->get<unsigned int>();
+    }
+
+    static double get_double(const json &config, const char *dir, const char *name, const double def)
+    {
+        const json *value = find(config, dir, name);
+        if (!value)
+            return def;
+        if (!value->is_number() || value->get<double>() < 0)
+            throw runtime_error(string(dir) + "." + name + " must be a non-negative number");
+        return value->get<double>();
+    }
+
+    static bool get_bool(const json &config, const char *dir, const char *name, const bool def)
+    {
+        const json *value = find(config, dir, name);
+        if (!value)
+            return def;
+        if (!value->is_boolean())
+            throw runtime_error(string(dir) + "." + name + " must be true or false");
+        return value->get<bool>();
+    }
+
+    static string get_string(const json &config, const char *dir, const char *name, const char *def)
+    {
+        const json *value = find(config, dir, name);
+        if (!value)
+            return def;
+        if (!value->is_string())
+            throw runtime_error(string(dir) + "." + name + " must be a string");
+        return value->get<string>();
+    }
+
+    // Попытка перезагрузки из фонового потока, ошибки пишутся в лог
+    void try_reload()
+    {
+        try
+        {
+            reload();
+            ++reloads;
+        }
+        catch (const exception &e)
+        {
+            ofstream fout(project_path + "log.txt", ios_base::app);
+            fout << "Error: settings.json is not reloaded. " << e.what() << endl;
+            fout.close();
+        }
+    }
+
+    void watch_loop()
+    {
+#ifdef __linux__
+        const int fd = inotify_init1(IN_NONBLOCK);
+        const string dir = project_path.empty() ? string(".") : project_path;
+        if (fd >= 0 && inotify_add_watch(fd, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) >= 0)
+        {
+            alignas(inotify_event) char buf[4096];
+            pollfd pfd{fd, POLLIN, 0};
+            while (is_watching)
+            {
+                // Таймаут нужен, чтобы поток мог заметить остановку
+                if (poll(&pfd, 1, 200) <= 0)
+                    continue;
+                bool changed = false;
+                ssize_t len;
+                while ((len = read(fd, buf, sizeof(buf))) > 0)
+                {
+                    for (char *ptr = buf; ptr < buf + len;)
+                    {
+                        const inotify_event *event = reinterpret_cast<const inotify_event *>(ptr);
+                        if (event->len && string(event->name) == "settings.json")
+                            changed = true;
+                        ptr += sizeof(inotify_event) + event->len;
+                    }
+                }
+                if (changed)
+                    try_reload();
+            }
+            close(fd);
+            return;
+        }
+        if (fd >= 0)
+            close(fd);
+#endif
+        // Запасной вариант: опрос времени изменения файла
+        namespace fs = filesystem;
+        const fs::path path = project_path + "settings.json";
+        error_code ec;
+        auto last_write = fs::last_write_time(path, ec);
+        while (is_watching)
+        {
+            this_thread::sleep_for(chrono::milliseconds(500));
+            const auto write_time = fs::last_write_time(path, ec);
+            if (!ec && write_time != last_write)
+            {
+                last_write = write_time;
+                try_reload();
+            }
+        }
+    }
+
+    // Максимальный уровень бота: глубина перебора растет экспоненциально
+    static constexpr unsigned int max_bot_level = 30;
+
+    shared_ptr<const Settings> settings; // Текущий снимок настроек
+    thread watcher;                      // Поток отслеживания изменений файла
+    atomic<bool> is_watching{false};
+    atomic<unsigned int> reloads{1};
 };
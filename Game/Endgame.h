@@ -0,0 +1,396 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "../Models/Move.h"
+#include "Rays.h"
+
+using namespace std;
+
+// Позиция с небольшим числом фигур в битовых досках (бит x * 8 + y), индекс массивов - цвет
+struct endgame_position
+{
+    uint64_t men[2] = {0, 0};
+    uint64_t kings[2] = {0, 0};
+
+    uint64_t pieces(const bool color) const
+    {
+        return men[color] | kings[color];
+    }
+
+    uint64_t occupied() const
+    {
+        return pieces(false) | pieces(true);
+    }
+};
+
+// Результат распознавателя эндшпиля
+struct endgame_result
+{
+    enum class kind
+    {
+        none, // окончание не распознано: позицию оценивает calc_score
+        draw, // теоретическая ничья, перебор дальше не нужен
+        eval  // оценка окончания для листа перебора (в том числе известный выигрыш с оценкой продвижения к нему)
+    };
+    kind type = kind::none;
+    double score = 0; // отношение сил белых к силам черных, как calc_score для бота за белых
+};
+
+/**
+ * Распознаватели эндшпиля для русских шашек. Окончание определяется по соотношению материала
+ * (простые и дамки каждой стороны), таблица по соотношению выбирает оценщик окончания:
+ *  - только дамки: 1 против 1 - ничья; 2 или 3 против 1 - ничья, если одинокая дамка держит большую
+ *    дорогу (a1-h8); 3 и больше против 1, когда одинокая дамка не держит большую дорогу, - выигрыш
+ *    (треугольник Петрова); при двух и больше дамках у каждой стороны окончание не распознается
+ *    (исход зависит от расположения дамок);
+ *  - дамка и простая против дамки - ничья, если одинокая дамка держит большую дорогу (простая станет
+ *    дамкой, а 2 дамки не выигрывают у дамки на большой дороге);
+ *  - только простые, которые разошлись и больше не встретятся, - гонка: сторона, которая первой проведет
+ *    простую в дамки, получает дамку.
+ * Одинокая дамка держит большую дорогу, если стоит на ней, а у сильной стороны на ней фигур нет.
+ * Ничья признается, только если взятий нет у обеих сторон и сильная сторона не выигрывает жертвой
+ * ближайшим ходом (фигура отдается под вынужденное взятие, после которого одинокая дамка снимается,
+ * как в W:WKa1,Kd2:BKh8 после d2-c3). Остальные позиции со взятием у стороны,
+ * которая ходит, решает перебор; только оценщик дамок учитывает взятие сам, чтобы оценка
+ * известного выигрыша не сменялась в листьях обычной оценкой другого масштаба
+ */
+class Endgame
+{
+  public:
+    // Распознаются позиции, где фигур не больше
+    static constexpr int max_pieces = 8;
+    // Оценка известного выигрыша: больше любого соотношения материала, меньше победы INF
+    static constexpr double known_win = 1000;
+
+    /**
+     * Перевод доски в битовые доски
+     * @return false - фигур больше max_pieces (окончания не распознаются)
+     */
+    static bool collect(const vector<vector<POS_T>> &mtx, endgame_position &pos)
+    {
+        int count = 0;
+        for (POS_T i = 0; i < board_size; ++i)
+        {
+            // Фигуры стоят только на темных клетках
+            for (POS_T j = 1 - i % 2; j < board_size; j += 2)
+            {
+                const POS_T type = mtx[i][j];
+                if (!type)
+                    continue;
+                if (++count > max_pieces)
+                    return false;
+                const uint64_t b = uint64_t(1) << (i * 8 + j);
+                (type > 2 ? pos.kings : pos.men)[(type - 1) % 2] |= b;
+            }
+        }
+        return true;
+    }
+
+    // Соотношение материала: по 3 бита на число простых и дамок каждой стороны
+    static uint32_t signature(const endgame_position &pos)
+    {
+        return uint32_t(__builtin_popcountll(pos.men[0])) | uint32_t(__builtin_popcountll(pos.kings[0])) << 3 |
+               uint32_t(__builtin_popcountll(pos.men[1])) << 6 | uint32_t(__builtin_popcountll(pos.kings[1])) << 9;
+    }
+
+    // Есть ли оценщик для соотношения материала позиции
+    static bool recognizes(const endgame_position &pos)
+    {
+        return table()[signature(pos)] != nullptr;
+    }
+
+    /**
+     * Оценка окончания
+     * @param color сторона, которая ходит
+     */
+    static endgame_result probe(const endgame_position &pos, const bool color)
+    {
+        const evaluator eval = table()[signature(pos)];
+        return eval ? eval(pos, color) : endgame_result();
+    }
+
+    // Теоретическая ничья в позиции на доске (для досрочного окончания партий ботов)
+    static bool is_known_draw(const vector<vector<POS_T>> &mtx, const bool color)
+    {
+        endgame_position pos;
+        return collect(mtx, pos) && probe(pos, color).type == endgame_result::kind::draw;
+    }
+
+    // Есть ли взятие у стороны color
+    static bool has_capture(const endgame_position &pos, const bool color)
+    {
+        const uint64_t occ = pos.occupied(), enemy = pos.pieces(!color);
+        for (uint64_t b = pos.pieces(color); b; b &= b - 1)
+        {
+            const int sq = lowest_bit(b);
+            const bool king = (pos.kings[color] >> sq) & 1;
+            for (int d = 0; d < 4; ++d)
+            {
+                // Простая бьет соседнюю фигуру (в том числе назад), дамка - первую на диагонали
+                const uint64_t blockers = rays.ray[sq][d] & (king ? occ : ~uint64_t(0));
+                if (!blockers)
+                    continue;
+                const int target = first_on_ray(d, blockers);
+                if (!((enemy >> target) & 1) || !rays.ray[target][d])
+                    continue;
+                if (!((occ >> first_on_ray(d, rays.ray[target][d])) & 1))
+                    return true;
+            }
+        }
+        return false;
+    }
+
+  private:
+    typedef endgame_result (*evaluator)(const endgame_position &pos, const bool color);
+
+    // Большая дорога a1-h8: клетки x + y = 7
+    static constexpr uint64_t main_road = 0x0102040810204080ULL;
+    // Двойники g1-a7 (x - y = 1) и h2-b8 (y - x = 1): на них строится треугольник Петрова
+    static constexpr uint64_t double_roads[2] = {0x4020100804020100ULL, 0x0080402010080402ULL};
+
+    // Ничья, если ни у одной стороны нет взятия
+    static endgame_result quiet_draw(const endgame_position &pos)
+    {
+        if (has_capture(pos, false) || has_capture(pos, true))
+            return endgame_result();
+        return draw();
+    }
+
+    static endgame_result draw()
+    {
+        endgame_result res;
+        res.type = endgame_result::kind::draw;
+        res.score = 1;
+        return res;
+    }
+
+    // Оценка для белых по отношению сил white / black
+    static endgame_result eval(const double white, const double black)
+    {
+        endgame_result res;
+        res.type = endgame_result::kind::eval;
+        res.score = white / black;
+        return res;
+    }
+
+    // Одинокая дамка стороны !strong стоит на большой дороге, фигур сильной стороны на ней нет
+    static bool holds_road(const endgame_position &pos, const bool strong)
+    {
+        return (pos.kings[!strong] & main_road) && !(pos.pieces(strong) & main_road);
+    }
+
+    // Поля для хода без взятия фигуры стороны color с клетки sq
+    static uint64_t quiet_targets(const endgame_position &pos, const bool color, const int sq)
+    {
+        const uint64_t occ = pos.occupied();
+        if ((pos.kings[color] >> sq) & 1)
+            return king_attacks(sq, occ) & ~occ;
+        // Простая ходит на соседнее поле вперед: белые к x = 0 (лучи 0 и 1), черные к x = 7 (лучи 2 и 3)
+        uint64_t res = 0;
+        for (int d = color ? 2 : 0; d < (color ? 4 : 2); ++d)
+        {
+            if (rays.ray[sq][d])
+                res |= uint64_t(1) << first_on_ray(d, rays.ray[sq][d]);
+        }
+        return res & ~occ;
+    }
+
+    // Позиция после хода без взятия фигуры стороны color с клетки from на клетку to
+    static endgame_position moved(const endgame_position &pos, const bool color, const int from, const int to)
+    {
+        const uint64_t from_bit = uint64_t(1) << from;
+        const bool king = (pos.kings[color] & from_bit) || to / board_size == (color ? board_size - 1 : 0);
+        endgame_position next = pos;
+        next.men[color] &= ~from_bit;
+        next.kings[color] &= ~from_bit;
+        (king ? next.kings : next.men)[color] |= uint64_t(1) << to;
+        return next;
+    }
+
+    /**
+     * Есть ли у одинокой дамки стороны weak взятие, после которого серия заканчивается и сильная
+     * сторона не может взять дамку. Взятия, которые продолжаются серией, не учитываются
+     */
+    static bool escapes(const endgame_position &pos, const bool weak)
+    {
+        const int sq = lowest_bit(pos.kings[weak]);
+        const uint64_t occ = pos.occupied();
+        for (int d = 0; d < 4; ++d)
+        {
+            const uint64_t blockers = rays.ray[sq][d] & occ;
+            if (!blockers)
+                continue;
+            const int target = first_on_ray(d, blockers);
+            if (!((pos.pieces(!weak) >> target) & 1))
+                continue;
+            // Поля за взятой фигурой до следующей занятой клетки
+            const uint64_t beyond = rays.ray[target][d], behind = beyond & occ;
+            const uint64_t landing = beyond & ~occ & ~(behind ? rays.ray[first_on_ray(d, behind)][d] : 0);
+            bool continues = false, escape = false;
+            for (uint64_t l = landing; l; l &= l - 1)
+            {
+                endgame_position next = pos;
+                next.men[!weak] &= ~(uint64_t(1) << target);
+                next.kings[!weak] &= ~(uint64_t(1) << target);
+                next.kings[weak] = l & (~l + 1);
+                if (has_capture(next, weak))
+                    continues = true;
+                else if (!next.pieces(!weak) || !has_capture(next, !weak))
+                    escape = true;
+            }
+            // Если серия может продолжиться, остановиться на поле без продолжения нельзя
+            if (escape && !continues)
+                return true;
+        }
+        return false;
+    }
+
+    /**
+     * Жертва: сторона strong ходом без взятия отдает фигуру под взятие одинокой дамке так, что после
+     * любого ее взятия дамку снимают
+     */
+    static bool has_sacrifice(const endgame_position &pos, const bool strong)
+    {
+        for (uint64_t b = pos.pieces(strong); b; b &= b - 1)
+        {
+            const int from = lowest_bit(b);
+            for (uint64_t t = quiet_targets(pos, strong, from); t; t &= t - 1)
+            {
+                const endgame_position next = moved(pos, strong, from, lowest_bit(t));
+                if (has_capture(next, !strong) && !escapes(next, !strong))
+                    return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * Одинокая дамка держит ничью ближайшим ходом: у сильной стороны, если она ходит, нет жертвы;
+     * если ходит одинокая дамка, у нее есть ход по большой дороге на поле, где ее нельзя взять
+     * и где у сильной стороны нет жертвы
+     */
+    static bool holds_draw(const endgame_position &pos, const bool color, const bool strong)
+    {
+        if (color == strong)
+            return !has_sacrifice(pos, strong);
+        const int sq = lowest_bit(pos.kings[!strong]);
+        for (uint64_t t = quiet_targets(pos, !strong, sq) & main_road; t; t &= t - 1)
+        {
+            const endgame_position next = moved(pos, !strong, sq, lowest_bit(t));
+            if (!has_capture(next, strong) && !has_sacrifice(next, strong))
+                return true;
+        }
+        return false;
+    }
+
+    // Ничья одинокой дамки на большой дороге против сильной стороны strong, ход стороны color
+    static endgame_result road_draw(const endgame_position &pos, const bool color, const bool strong)
+    {
+        if (has_capture(pos, !color))
+            return eval(1, 1);
+        return holds_draw(pos, color, strong) ? draw() : endgame_result();
+    }
+
+    // Только дамки у обеих сторон
+    static endgame_result kings_only(const endgame_position &pos, const bool color)
+    {
+        const int count[2] = {__builtin_popcountll(pos.kings[0]), __builtin_popcountll(pos.kings[1])};
+        if (min(count[0], count[1]) != 1)
+            return endgame_result();
+        if (max(count[0], count[1]) == 1)
+            return quiet_draw(pos);
+        const bool strong = count[1] > count[0];
+        if (has_capture(pos, color))
+        {
+            // Сильная сторона снимает одинокую дамку; одинокая дамка снимает одну из дамок,
+            // и 2 или 3 против 1 становится 1 против 1 или 2 против 1
+            if (color != strong && count[strong] <= 3)
+                return eval(1, 1);
+            return win(pos, strong);
+        }
+        if (holds_road(pos, strong))
+            return count[strong] <= 3 ? road_draw(pos, color, strong) : endgame_result();
+        // 2 против 1 без большой дороги решает перебор
+        return count[strong] == 2 ? endgame_result() : win(pos, strong);
+    }
+
+    // Известный выигрыш дамок стороны strong против одинокой дамки
+    static endgame_result win(const endgame_position &pos, const bool strong)
+    {
+        // Продвижение к выигрышу: большая дорога и двойники заняты сильной стороной, у одинокой дамки мало
+        // безопасных полей (полей, где ее нельзя сразу взять), и она ближе к краю
+        const int sq = lowest_bit(pos.kings[!strong]), x = sq / 8, y = sq % 8;
+        const int to_edge = min(min(x, board_size - 1 - x), min(y, board_size - 1 - y));
+        int safe = 0;
+        for (uint64_t b = king_attacks(sq, pos.occupied()) & ~pos.occupied(); b; b &= b - 1)
+        {
+            endgame_position next = pos;
+            next.kings[!strong] = b & (~b + 1);
+            safe += !has_capture(next, strong);
+        }
+        double progress = (13 - safe) * 0.5 + (3 - to_edge);
+        for (const uint64_t road : {main_road, double_roads[0], double_roads[1]})
+            progress += pos.kings[strong] & road ? 3 : 0;
+        return strong ? eval(1, known_win + progress) : eval(known_win + progress, 1);
+    }
+
+    // Дамка и простая против одинокой дамки
+    static endgame_result king_and_man_vs_king(const endgame_position &pos, const bool color)
+    {
+        const bool strong = pos.men[1] != 0;
+        if (!holds_road(pos, strong) || has_capture(pos, color))
+            return endgame_result();
+        return road_draw(pos, color, strong);
+    }
+
+    /**
+     * Гонка простых: все белые простые прошли все черные (белые идут к x = 0, черные к x = 7),
+     * взятий больше не будет. Первой в дамки проходит сторона, чья передняя простая ближе
+     * к последнему ряду; при равенстве - сторона, которая ходит. Ее передняя простая считается дамкой
+     */
+    static endgame_result men_race(const endgame_position &pos, const bool color)
+    {
+        if (has_capture(pos, color))
+            return endgame_result();
+        const int white_back = highest_bit(pos.men[0]) / 8, black_back = lowest_bit(pos.men[1]) / 8;
+        if (white_back >= black_back)
+            return endgame_result();
+        const int white_turns = lowest_bit(pos.men[0]) / 8;
+        const int black_turns = board_size - 1 - highest_bit(pos.men[1]) / 8;
+        const bool white_first = color ? white_turns < black_turns : white_turns <= black_turns;
+        const double white = __builtin_popcountll(pos.men[0]) + (white_first ? 4 : 0);
+        const double black = __builtin_popcountll(pos.men[1]) + (white_first ? 0 : 4);
+        return eval(white, black);
+    }
+
+    // Оценщики по соотношению материала; nullptr - окончание не распознается
+    static const array<evaluator, 4096> &table()
+    {
+        static const array<evaluator, 4096> res = [] {
+            array<evaluator, 4096> t{};
+            for (uint32_t s = 0; s < t.size(); ++s)
+            {
+                const int men[2] = {int(s & 7), int(s >> 6 & 7)}, kings[2] = {int(s >> 3 & 7), int(s >> 9 & 7)};
+                if (men[0] + kings[0] == 0 || men[1] + kings[1] == 0)
+                    continue;
+                if (!men[0] && !men[1])
+                    t[s] = kings_only;
+                else if (!kings[0] && !kings[1])
+                    t[s] = men_race;
+                else
+                {
+                    for (int c = 0; c < 2; ++c)
+                    {
+                        if (men[c] == 1 && kings[c] == 1 && !men[!c] && kings[!c] == 1)
+                            t[s] = king_and_man_vs_king;
+                    }
+                }
+            }
+            return t;
+        }();
+        return res;
+    }
+};
@@ -0,0 +1,469 @@
+#pragma once
+#include <atomic>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include "../Models/Settings.h"
+#include "Bench.h"
+#include "History.h"
+#include "Levels.h"
+#include "Logic.h"
+#include "Mcts.h"
+#include "Notation.h"
+#include "Solver.h"
+
+// Текстовый протокол движка через stdin/stdout (одна команда на строку).
+// Позволяет запускать движок без окна из сторонних программ; описание команд - в README
+class Engine
+{
+  public:
+    Engine() : settings(default_settings()), logic(settings)
+    {
+        new_game();
+    }
+
+    ~Engine()
+    {
+        stop_search();
+    }
+
+    // Чтение команд до "quit" или конца ввода
+    int run(istream &in = cin)
+    {
+        string line;
+        while (getline(in, line))
+        {
+            if (!command(line))
+                break;
+        }
+        stop_search();
+        return 0;
+    }
+
+    // Выполнение одной команды, false - команда "quit"
+    bool command(const string &line)
+    {
+        stringstream in(line);
+        string cmd;
+        if (!(in >> cmd))
+            return true;
+        if (cmd == "quit")
+            return false;
+        if (cmd == "engine")
+            handshake();
+        else if (cmd == "isready")
+            send("readyok");
+        else if (cmd == "stop")
+            stop_search();
+        else if (cmd == "newgame")
+        {
+            stop_search();
+            new_game();
+        }
+        else if (cmd == "setoption")
+        {
+            stop_search();
+            set_option(in);
+        }
+        else if (cmd == "position")
+        {
+            stop_search();
+            set_position(in);
+        }
+        else if (cmd == "go")
+        {
+            stop_search();
+            go(in);
+        }
+        else if (cmd == "solve")
+        {
+            stop_search();
+            solve(in);
+        }
+        else if (cmd == "fen")
+            send("fen " + notation::to_fen(mtx, color));
+        else if (cmd == "bench")
+        {
+            stop_search();
+            bench(in);
+        }
+        else
+            send("info string unknown command " + cmd);
+        return true;
+    }
+
+  private:
+    void handshake()
+    {
+        send("id name Checkers");
+        send("option name WhiteBotLevel type spin default " + to_string(settings.bot_level[0]) + " min 0 max 30");
+        send("option name BlackBotLevel type spin default " + to_string(settings.bot_level[1]) + " min 0 max 30");
+        send("option name BotScoringType type combo default NumberAndPotential var NumberOnly var NumberAndPotential var NumberAndStructure");
+        send("option name Optimization type combo default O1 var O0 var O1 var O2");
+        send("option name NoRandom type check default false");
+        send("option name Endgame type check default true");
+        send("option name NoProgressTurns type spin default " + to_string(settings.no_progress_turns) +
+             " min 0 max 1000");
+        send("option name Engine type combo default AlphaBeta var AlphaBeta var Mcts");
+        send("option name Difficulty type combo default Depth var Depth var Budget");
+        send("option name MctsThreads type spin default " + to_string(settings.mcts_threads) + " min 1 max 256");
+        send("option name Hash type spin default " + to_string(settings.tt_size_mb) + " min 0 max 65536");
+        send("option name HashFile type string default <empty>");
+        send("option name CacheFile type string default <empty>");
+        send("engineok");
+    }
+
+    // Оба цвета по умолчанию ищут на уровне 5, как в примере settings.json
+    static Settings default_settings()
+    {
+        Settings s;
+        s.bot_level[0] = s.bot_level[1] = 5;
+        return s;
+    }
+
+    void new_game()
+    {
+        mtx = notation::start_position();
+        color = false;
+        history.reset(mtx, color);
+    }
+
+    // setoption name <имя> value <значение>
+    void set_option(stringstream &in)
+    {
+        string word, name, value;
+        in >> word >> name >> word >> value;
+        bool ok = true;
+        if (name == "WhiteBotLevel" || name == "BlackBotLevel")
+        {
+            const int level = atoi(value.c_str());
+            ok = level >= 0 && level <= (settings.difficulty == Difficulty::Budget ? max_budget_level : 30);
+            if (ok)
+                settings.bot_level[name == "BlackBotLevel"] = level;
+        }
+        else if (name == "BotScoringType")
+        {
+            ok = value == "NumberOnly" || value == "NumberAndPotential" || value == "NumberAndStructure";
+            if (ok)
+                settings.scoring = value == "NumberOnly"           ? ScoringType::NumberOnly
+                                   : value == "NumberAndPotential" ? ScoringType::NumberAndPotential
+                                                                   : ScoringType::NumberAndStructure;
+        }
+        else if (name == "Optimization")
+        {
+            ok = value == "O0" || value == "O1" || value == "O2";
+            if (ok)
+                settings.optimization = Optimization(value[1] - '0');
+        }
+        else if (name == "NoRandom")
+        {
+            ok = value == "true" || value == "false";
+            if (ok)
+                settings.no_random = value == "true";
+        }
+        else if (name == "Endgame")
+        {
+            ok = value == "true" || value == "false";
+            if (ok)
+                settings.endgame = value == "true";
+        }
+        else if (name == "NoProgressTurns")
+        {
+            const int turns = atoi(value.c_str());
+            ok = turns >= 0;
+            if (ok)
+                settings.no_progress_turns = turns;
+        }
+        else if (name == "Engine")
+        {
+            ok = value == "AlphaBeta" || value == "Mcts";
+            if (ok)
+                settings.engine = value == "Mcts" ? EngineType::Mcts : EngineType::AlphaBeta;
+        }
+        else if (name == "Difficulty")
+        {
+            // Уровни бюджета - от 0 до max_budget_level
+            ok = value == "Depth" ||
+                 (value == "Budget" && max(settings.bot_level[0], settings.bot_level[1]) <= max_budget_level);
+            if (ok)
+                settings.difficulty = value == "Budget" ? Difficulty::Budget : Difficulty::Depth;
+        }
+        else if (name == "MctsThreads")
+        {
+            const int threads = atoi(value.c_str());
+            ok = threads >= 1 && threads <= 256;
+            if (ok)
+                settings.mcts_threads = threads;
+        }
+        else if (name == "Hash")
+        {
+            const int size_mb = atoi(value.c_str());
+            ok = size_mb >= 0 && size_mb <= 65536;
+            if (ok)
+                settings.tt_size_mb = size_mb;
+        }
+        else if (name == "HashFile")
+            settings.tt_file = value == "<empty>" ? "" : value;
+        else if (name == "CacheFile")
+            settings.cache_file = value == "<empty>" ? "" : value;
+        else
+        {
+            send("info string unknown option " + name);
+            return;
+        }
+        if (!ok)
+        {
+            send("info string invalid value " + value + " for option " + name);
+            return;
+        }
+        logic = Logic(settings);
+    }
+
+    // position startpos|fen <FEN> [moves <ход> ...]
+    void set_position(stringstream &in)
+    {
+        string word;
+        in >> word;
+        vector<vector<POS_T>> new_mtx;
+        bool new_color = false;
+        if (word == "startpos")
+            new_mtx = notation::start_position();
+        else if (word == "fen")
+        {
+            string fen;
+            in >> fen;
+            if (!notation::parse_fen(fen, new_mtx, new_color))
+            {
+                send("info string invalid fen " + fen);
+                return;
+            }
+        }
+        else
+        {
+            send("info string invalid position");
+            return;
+        }
+        History new_history;
+        new_history.reset(new_mtx, new_color);
+        if (in >> word && word == "moves")
+        {
+            while (in >> word)
+            {
+                const auto chain = notation::parse_chain(logic, new_mtx, new_color, word);
+                if (chain.empty())
+                {
+                    send("info string illegal move " + word);
+                    return;
+                }
+                notation::apply_chain(new_mtx, new_history, chain);
+                new_color = !new_color;
+            }
+        }
+        mtx = new_mtx;
+        color = new_color;
+        history = new_history;
+    }
+
+    // go [depth N] [movetime MS] [nodes N] [multipv K] [infinite]
+    void go(stringstream &in)
+    {
+        search_limits limits;
+        bool infinite = false;
+        size_t multi_pv = 1;
+        string word;
+        while (in >> word)
+        {
+            if (word == "depth")
+            {
+                int depth = 1;
+                in >> depth;
+                limits.depth = max(depth, 1) - 1;
+            }
+            else if (word == "movetime")
+                in >> limits.time_ms;
+            else if (word == "nodes")
+                in >> limits.nodes;
+            else if (word == "multipv")
+                in >> multi_pv;
+            else if (word == "infinite")
+                infinite = true;
+        }
+        // Без ограничений глубина (или бюджет позиций и шум оценки) берется из уровня бота стороны, которая ходит
+        logic.eval_noise = 0;
+        if (limits.depth < 0)
+        {
+            const bool unbounded = infinite || limits.time_ms > 0 || limits.nodes > 0;
+            limits.depth = unbounded ? max_level : settings.bot_level[color];
+            if (!unbounded && settings.difficulty == Difficulty::Budget)
+            {
+                limits.depth = max_level;
+                limits.nodes = budget_levels[settings.bot_level[color]].nodes;
+                logic.eval_noise = budget_levels[settings.bot_level[color]].noise;
+            }
+        }
+        stop = false;
+        limits.stop = &stop;
+        if (settings.engine == EngineType::Mcts)
+            searcher = thread(&Engine::search_mcts, this, limits, infinite);
+        else if (multi_pv > 1)
+            searcher = thread(&Engine::search_lines, this, limits, multi_pv);
+        else
+            searcher = thread(&Engine::search, this, limits);
+    }
+
+    // Поиск в отдельном потоке, чтобы движок принимал "stop" и "isready"
+    void search(search_limits limits)
+    {
+        auto best = logic.search(mtx, history, color, limits,
+                                 [this](const search_stats &stats, const vector<move_pos> &) {
+                                     send_info(stats, stats.score, logic.principal_variation());
+                                 });
+        send("bestmove " + (best.empty() ? string("none") : notation::chain_to_string(best)));
+    }
+
+    // Поиск по дереву Монте-Карло: nodes - число симуляций, глубина не используется.
+    // Без ограничений время и число симуляций берутся из настроек Mcts, infinite - поиск до "stop"
+    void search_mcts(search_limits limits, const bool infinite)
+    {
+        if (infinite && limits.time_ms <= 0 && !limits.nodes)
+            limits.time_ms = numeric_limits<double>::max();
+        Mcts mcts(settings);
+        auto best = mcts.search(mtx, history, color, limits);
+        send_info(mcts.stats, mcts.stats.score, mcts.principal_variation());
+        send("info string playouts " + to_string(mcts.playout_count()));
+        send("bestmove " + (best.empty() ? string("none") : notation::chain_to_string(best)));
+    }
+
+    // Анализ count лучших ходов: после каждого уровня по строке info на вариант
+    void search_lines(search_limits limits, size_t count)
+    {
+        auto lines = logic.search_lines(mtx, history, color, count, limits,
+                                        [this](const search_stats &stats, const vector<pv_line> &lines) {
+                                            for (size_t i = 0; i < lines.size(); ++i)
+                                                send_info(stats, lines[i].score, lines[i].moves, i + 1);
+                                        });
+        send("bestmove " + (lines.empty() ? string("none") : notation::chain_to_string(lines.front().turn())));
+    }
+
+    // solve [nodes N] [movetime MS] [threads N] [turns N] - решение позиции до конца партии
+    void solve(stringstream &in)
+    {
+        search_limits limits;
+        Settings solver_settings = settings;
+        int turns_left = 0;
+        string word;
+        while (in >> word)
+        {
+            if (word == "nodes")
+                in >> limits.nodes;
+            else if (word == "movetime")
+                in >> limits.time_ms;
+            else if (word == "threads")
+            {
+                int threads = 1;
+                in >> threads;
+                solver_settings.solver_threads = unsigned(min(max(threads, 1), 256));
+            }
+            else if (word == "turns")
+                in >> turns_left;
+        }
+        stop = false;
+        limits.stop = &stop;
+        searcher = thread(&Engine::search_solver, this, solver_settings, limits, turns_left);
+    }
+
+    void search_solver(const Settings solver_settings, const search_limits limits, const int turns_left)
+    {
+        Solver solver(solver_settings);
+        const auto res = solver.solve(mtx, color, limits, turns_left, history.reversible_turns());
+        static const char *outcomes[] = {"unknown", "win", "loss", "draw"};
+        ostringstream out;
+        out << "solution " << outcomes[int(res.outcome)] << " turns " << res.turns << " nodes " << res.stats.nodes
+            << " nps " << uint64_t(res.stats.nps()) << " time " << uint64_t(res.stats.time_ms) << " pv "
+            << notation::line_to_string(res.line);
+        send(out.str());
+    }
+
+    // bench [depth N] [json FILE] [trace FILE] - замер скорости на встроенном наборе позиций
+    void bench(stringstream &in)
+    {
+        int level = Bench::default_level;
+        string word, json_path, trace_path;
+        while (in >> word)
+        {
+            if (word == "depth")
+            {
+                int depth = 1;
+                in >> depth;
+                level = max(depth, 1) - 1;
+            }
+            else if (word == "json")
+                in >> json_path;
+            else if (word == "trace")
+                in >> trace_path;
+        }
+        if (!trace_path.empty())
+            TRACE_START(trace_path, settings.trace_sample_rate);
+        ostringstream out;
+        const auto results = Bench::run(level, out);
+        TRACE_STOP();
+        string line;
+        for (istringstream lines(out.str()); getline(lines, line);)
+            send("info string " + line);
+        if (!json_path.empty())
+        {
+            ofstream fout(json_path);
+            if (!fout)
+            {
+                send("info string can't open " + json_path);
+                return;
+            }
+            fout << Bench::to_json(level, results).dump(2) << endl;
+        }
+    }
+
+    // multi_pv - номер варианта при анализе нескольких ходов (0 - обычный поиск)
+    void send_info(const search_stats &stats, const double score, const vector<move_pos> &line,
+                   const size_t multi_pv = 0)
+    {
+        ostringstream out;
+        out << "info depth " << stats.depth;
+        if (multi_pv)
+            out << " multipv " << multi_pv;
+        out << " score " << fixed << setprecision(3) << score << " nodes " << stats.nodes << " nps "
+            << uint64_t(stats.nps()) << " time " << uint64_t(stats.time_ms) << " pv " << notation::line_to_string(line);
+        send(out.str());
+    }
+
+    void stop_search()
+    {
+        stop = true;
+        if (searcher.joinable())
+            searcher.join();
+    }
+
+    // Вывод строки целиком, чтобы строки из разных потоков не перемешивались
+    void send(const string &line)
+    {
+        lock_guard<mutex> lock(out_mutex);
+        cout << line << '\n' << flush;
+    }
+
+    // Глубина для поиска без ограничения по глубине
+    static constexpr int max_level = 63;
+
+    Settings settings;                // Параметры бота
+    Logic logic;                      // Поиск (используется только потоком поиска во время "go")
+    vector<vector<POS_T>> mtx;        // Текущая позиция
+    bool color = false;               // Очередь хода (false - белые)
+    History history;                  // История для поиска повторений
+    atomic<bool> stop{false};         // Флаг остановки поиска
+    thread searcher;                  // Поток поиска
+    mutex out_mutex;                  // Защита вывода
+};
@@ -0,0 +1,72 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+using namespace std;
+
+/**
+ * Кэш оценки простых в листьях перебора (BotScoringType "NumberAndPotential" и "NumberAndStructure"):
+ * число простых каждой стороны и их позиционная часть. Записи одного режима оценки, при смене режима
+ * кэш очищается. Ключ - расположение простых обеих сторон: битовые доски белых и черных простых,
+ * бит x * 8 + y; перебор ведет их вместе с ходами, поэтому лист с попаданием не обходит доску.
+ * Дамки в ключ не входят: ходы дамок не меняют расположения простых, поэтому в переборе
+ * одна и та же структура оценивается во многих листьях. Ключ точный, ложных попаданий нет.
+ * Таблица с прямой адресацией: новая структура вытесняет запись с тем же индексом.
+ * Память выделяется при первом обращении, объект не потокобезопасен (свой у каждого Logic)
+ */
+class EvalCache
+{
+    struct entry
+    {
+        uint64_t men[2]; // простые белых и черных
+        double score[2]; // оценка простых белых и черных
+    };
+
+  public:
+    // Записей в таблице (степень двойки): 4096 * 32 байта = 128 КБ, помещается в L2
+    static constexpr size_t entries = 4096;
+
+    // Поиск структуры; при попадании оценки записываются в score
+    bool probe(const uint64_t white, const uint64_t black, double score[2])
+    {
+        if (table.empty())
+        {
+            // Обе стороны не могут занимать все поля, поэтому пустая запись не совпадет ни с одним ключом
+            table.assign(entries, entry{{~uint64_t(0), ~uint64_t(0)}, {0, 0}});
+        }
+        const entry &e = table[index(white, black)];
+        if (e.men[0] != white || e.men[1] != black)
+        {
+            ++misses;
+            return false;
+        }
+        ++hits;
+        score[0] = e.score[0];
+        score[1] = e.score[1];
+        return true;
+    }
+
+    void store(const uint64_t white, const uint64_t black, const double score[2])
+    {
+        table[index(white, black)] = entry{{white, black}, {score[0], score[1]}};
+    }
+
+    // Удаление всех записей (счетчики сохраняются)
+    void clear()
+    {
+        table.clear();
+    }
+
+    // Счетчики за все время жизни кэша
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+
+  private:
+    static size_t index(const uint64_t white, const uint64_t black)
+    {
+        const uint64_t h = (white ^ (black * 0x9e3779b97f4a7c15ULL)) * 0xbf58476d1ce4e5b9ULL;
+        return size_t(h >> 52) & (entries - 1);
+    }
+
+    vector<entry> table;
+};
@@ -1,33 +1,53 @@
 #pragma once
 #include <chrono>
+#include <future>
 #include <thread>
 
 #include "../Models/Project_path.h"
 #include "Board.h"
+#include "Clock.h"
 #include "Config.h"
+#include "Endgame.h"
 #include "Hand.h"
+#include "Hint.h"
 #include "Logic.h"
+#include "Mcts.h"
+#include "Pdn.h"
+#include "Solver.h"
+#include "Telemetry.h"
 
 class Game
 {
   public:
-      // :  ,     
-    Game() : board(config("WindowSize", "Width"), config("WindowSize", "Hight")), hand(&board), logic(&board, &config)
+      // Конструктор: инициализирует доску, обработчик ввода и логику игры
+    Game()
+        : board(config.snapshot()->width, config.snapshot()->height), hand(&board), logic(&config),
+          telemetry(config.snapshot()->telemetry_file.empty() ? "" : project_path + config.snapshot()->telemetry_file)
     {
-        //      
+        // Очистка файла логов при создании игры
         ofstream fout(project_path + "log.txt", ios_base::trunc);
         fout.close();
+        // Настройки перечитываются при изменении settings.json без перезапуска
+        config.watch();
+        if (!config.snapshot()->trace_file.empty())
+            TRACE_START(project_path + config.snapshot()->trace_file, config.snapshot()->trace_sample_rate);
     }
 
-    //   
+    // Трассировка поиска записывается в файл при выходе из игры
+    ~Game()
+    {
+        TRACE_STOP();
+    }
+
+    // Основная функция игры
     int play()
     {
         auto start = chrono::steady_clock::now();
-        //    
+        // Обработка режима повтора игры
         if (is_replay)
         {
-            logic = Logic(&board, &config);
             config.reload();
+            logic = Logic(&config);
             board.redraw();
         }
         else
@@ -38,22 +58,50 @@ class Game
 
         int turn_num = -1;
         bool is_quit = false;
-        const int Max_turns = config("Game", "MaxNumTurns");
-        //   
+        bool is_draw = false;
+        const int Max_turns = config.snapshot()->max_turns;
+        clock.reset(config.snapshot()->clock_base_ms, config.snapshot()->clock_increment_ms);
+        show_clock();
+        // Главный игровой цикл
         while (++turn_num < Max_turns)
         {
             beat_series = 0;
-            //      
-            logic.find_turns(turn_num % 2);
-            //    -  
+            // Снимок настроек на этот ход (файл мог измениться)
+            const auto settings = config.snapshot();
+            const bool color = turn_num % 2;
+            // Ничья по повторению позиции или по правилу ходов без прогресса
+            if (is_draw_position(*settings))
+            {
+                is_draw = true;
+                break;
+            }
+            // Партия ботов заканчивается, как только на доске теоретическая ничья (Endgame.h)
+            if (settings->endgame && settings->is_bot[0] && settings->is_bot[1] &&
+                Endgame::is_known_draw(board.get_board(), color))
+            {
+                is_draw = true;
+                break;
+            }
+            // Поиск возможных ходов для текущего игрока
+            logic.find_turns(color, board.get_board());
+            // Если ходов нет - игра окончена
             if (logic.turns.empty())
                 break;
-            //    
-            logic.Max_depth = config("Bot", string((turn_num % 2) ? "Black" : "White") + string("BotLevel"));
-            //    
-            if (!config("Bot", string("Is") + string((turn_num % 2) ? "Black" : "White") + string("Bot")))
+            // Установка уровня сложности бота
+            logic.Max_depth = settings->bot_level[color];
+            logic.eval_noise =
+                settings->difficulty == Difficulty::Budget ? budget_levels[settings->bot_level[color]].noise : 0;
+            board.set_animation(settings->animation_fps, settings->animation_move_ms);
+            clock.start(color);
+            show_clock();
+            // Ход игрока или бота
+            if (!settings->is_bot[color])
             {
-                auto resp = player_turn(turn_num % 2);
+                auto resp = player_turn(color, *settings);
+                clock.stop();
+                // Время игрока истекло: он проигрывает, как и при отсутствии ходов
+                if (resp == Response::TIMEOUT)
+                    break;
                 if (resp == Response::QUIT)
                 {
                     is_quit = true;
@@ -66,9 +114,9 @@ class Game
                 }
                 else if (resp == Response::BACK)
                 {
-                    //   ( )
-                    if (config("Bot", string("Is") + string((1 - turn_num % 2) ? "Black" : "White") + string("Bot")) &&
-                        !beat_series && board.history_mtx.size() > 2)
+                    // Отмена хода (если возможно)
+                    if (settings->is_bot[!color] &&
+                        !beat_series && board.history.size() > 1)
                     {
                         board.rollback();
                         --turn_num;
@@ -82,22 +130,29 @@ class Game
                 }
             }
             else
-                bot_turn(turn_num % 2);
+                bot_turn(color, *settings, turn_num);
+            clock.stop();
         }
-        //     
+        clock.stop();
+        board.finish_animation();
+        show_clock();
+        // Запись времени игры в лог
         auto end = chrono::steady_clock::now();
         ofstream fout(project_path + "log.txt", ios_base::app);
         fout << "Game time: " << (int)chrono::duration<double, milli>(end - start).count() << " millisec\n";
+        if (clock.enabled())
+            fout << "Clock: white " << GameClock::format(clock.remaining_ms(false)) << ", black "
+                 << GameClock::format(clock.remaining_ms(true)) << " left\n";
         fout.close();
 
-        //   
+        // Обработка повторной игры
         if (is_replay)
             return play();
         if (is_quit)
             return 0;
-        //   
+        // Определение результата игры
         int res = 2;
-        if (turn_num == Max_turns)
+        if (turn_num == Max_turns || is_draw)
         {
             res = 0;
         }
@@ -105,7 +160,8 @@ class Game
         {
             res = 1;
         }
-        //      
+        save_game(res, *config.snapshot());
+        // Отображение результата и ожидание реакции игрока
         board.show_final(res);
         auto resp = hand.wait();
         if (resp == Response::REPLAY)
@@ -117,42 +173,263 @@ class Game
     }
 
   private:
-      //    
-    void bot_turn(const bool color)
+      // Проверка ничьей: позиция повторилась RepetitionDraw раз
+      // или NoProgressTurns ходов подряд сделаны дамками без взятий (0 - правило отключено)
+    bool is_draw_position(const Settings &settings) const
     {
-        auto start = chrono::steady_clock::now();
+        if (settings.no_progress_turns && board.history.reversible_turns() >= settings.no_progress_turns)
+            return true;
+        return settings.repetition_draw && board.history.repetitions() >= settings.repetition_draw;
+    }
 
-        //     
-        auto delay_ms = config("Bot", "BotDelayMS");
-        // new thread for equal delay for each turn
-        thread th(SDL_Delay, delay_ms);
-        //   
-        auto turns = logic.find_best_turns(color);
-        th.join();
-        bool is_first = true;
-        //   
-        for (auto turn : turns)
+    // Обновление часов в окне (без часов строки пустые, и часы не рисуются)
+    void show_clock()
+    {
+        if (!clock.enabled())
+            return board.show_clock("", "", -1);
+        board.show_clock(GameClock::format(clock.remaining_ms(false)), GameClock::format(clock.remaining_ms(true)),
+                         clock.running_color());
+        last_clock_draw = chrono::steady_clock::now();
+    }
+
+    // Проверка часов игрока во время ожидания ввода: показ раз в clock_period_ms и флажок
+    Response tick_clock(const bool color)
+    {
+        if (!clock.enabled())
+            return Response::OK;
+        if (clock.is_flagged(color))
+        {
+            show_clock();
+            return Response::TIMEOUT;
+        }
+        if (chrono::steady_clock::now() - last_clock_draw >= chrono::milliseconds(clock_period_ms))
+            show_clock();
+        return Response::OK;
+    }
+
+    // Дописывание законченной партии в PDN-файл (res: 0 - ничья, 1 - победа белых, 2 - победа черных)
+    void save_game(const int res, const Settings &settings) const
+    {
+        if (settings.pdn_file.empty())
+            return;
+        auto player = [&settings](const bool color) {
+            return settings.is_bot[color] ? "Bot level " + to_string(settings.bot_level[color]) : string("Player");
+        };
+        pdn::game_record game;
+        game.set_tag("Event", "Checkers");
+        game.set_tag("Date", pdn::today());
+        game.set_tag("White", player(false));
+        game.set_tag("Black", player(true));
+        game.set_tag("GameType", pdn::game_type);
+        game.result = res == 0 ? "1-1" : res == 1 ? "2-0" : "0-2";
+        game.set_tag("Result", game.result);
+        for (const auto &move : pdn::history_moves(board.history))
+            game.add_move(move);
+        ofstream fout(project_path + settings.pdn_file, ios_base::app);
+        pdn::write(fout, game);
+    }
+
+      // Функция выполнения хода бота
+    void bot_turn(const bool color, const Settings &settings, const int turn_num)
+    {
+        // Искусственная задержка для визуализации хода
+        const unsigned int delay_ms = settings.bot_delay_ms;
+        auto start = chrono::steady_clock::now();
+        vector<move_pos> turns;
+        // Время на ход по часам партии: единственный ход делается без поиска
+        const auto chains = clock.enabled() ? logic.turn_chains(color, board.get_board()) : vector<vector<move_pos>>();
+        const TimeManager time_manager = make_time_manager(color, settings, turn_num, chains);
+        if (chains.size() == 1)
+        {
+            turns = chains.front();
+            logic.stats = search_stats();
+        }
+        else if (!settings.hint || settings.engine == EngineType::Mcts || clock.enabled() ||
+                 settings.difficulty == Difficulty::Budget ||
+                 // Игрок сделал подсказанный ход: ответ бота уже найден поиском подсказки
+                 !hint.reply(board.history, settings.bot_level[color], turns, logic.stats))
+        {
+            // Поиск лучших ходов идет в отдельном потоке, главный поток в это время
+            // обновляет статистику поиска поверх доски
+            search_progress progress;
+            logic.progress = settings.search_overlay ? &progress : nullptr;
+            auto search = async(launch::async, [this, color, &settings, &time_manager, turn_num] {
+                vector<move_pos> solved;
+                if (solve_ending(color, settings, turn_num, time_manager, solved))
+                    return solved;
+                if (settings.engine != EngineType::Mcts && !clock.enabled())
+                    return settings.difficulty == Difficulty::Budget
+                               ? budget_search(color, settings)
+                               : logic.find_best_turns(board.get_board(), board.history, color);
+                if (settings.engine != EngineType::Mcts)
+                    return timed_search(color, settings, time_manager);
+                Mcts mcts(settings);
+                mcts.progress = logic.progress;
+                search_limits limits;
+                if (clock.enabled())
+                {
+                    limits.time_ms = time_manager.soft_ms();
+                    limits.nodes = settings.mcts_playouts;
+                }
+                auto res = clock.enabled() ? mcts.search(board.get_board(), board.history, color, limits)
+                                           : mcts.find_best_turns(board.get_board(), board.history, color);
+                logic.stats = mcts.stats;
+                return res;
+            });
+            auto last_draw = start;
+            // Пока идет поиск, доигрывается анимация предыдущего хода
+            while (search.wait_for(chrono::milliseconds(board.is_animating() ? 1 : 10)) != future_status::ready)
+            {
+                board.animate_frame();
+                auto now = chrono::steady_clock::now();
+                if (logic.progress && now - last_draw >= chrono::milliseconds(overlay_period_ms))
+                {
+                    board.show_search_info(progress.info(start));
+                    last_draw = now;
+                }
+                if (clock.enabled() && now - last_clock_draw >= chrono::milliseconds(clock_period_ms))
+                    show_clock();
+            }
+            turns = search.get();
+            logic.progress = nullptr;
+            board.clear_search_info();
+        }
+        // Задержка и анимация хода не расходуют время бота
+        clock.stop();
+        show_clock();
+        // equal delay for each turn (кадры анимации рисуются и во время задержки)
+        while (chrono::steady_clock::now() - start < chrono::milliseconds(delay_ms))
+        {
+            board.animate_frame();
+            SDL_Delay(1);
+        }
+        // Телеметрия поиска (запись в файл выполняется в фоновом потоке)
+        if (telemetry.enabled())
         {
-            if (!is_first)
+            turn_telemetry record;
+            record.turn = turn_num;
+            record.color = color;
+            record.stats = logic.stats;
+            for (auto turn : turns)
             {
-                SDL_Delay(delay_ms);
+                if (record.move_count < turn_telemetry::max_moves)
+                    record.moves[record.move_count++] = turn;
             }
-            is_first = false;
+            telemetry.push(record);
+        }
+        // Ход ставится в очередь анимации, когда показан предыдущий; следующий поиск начинается сразу,
+        // а прыжки этого хода рисуются кадрами, пока он идет
+        board.finish_animation();
+        for (auto turn : turns)
+        {
             beat_series += (turn.xb != -1);
-            board.move_piece(turn, beat_series);
+            board.move_piece(turn, beat_series, true);
         }
+    }
 
-        //     
-        auto end = chrono::steady_clock::now();
-        ofstream fout(project_path + "log.txt", ios_base::app);
-        fout << "Bot turn time: " << (int)chrono::duration<double, milli>(end - start).count() << " millisec\n";
-        fout.close();
+    /**
+     * Решение эндшпиля до конца партии (Solver), если фигур не больше Solver.MaxPieces.
+     * @param turns доказанный выигрыш: первый ход варианта; доказанное поражение - самая долгая защита
+     * @return false - позиция не решена или это ничья, ход выбирает обычный поиск
+     */
+    bool solve_ending(const bool color, const Settings &settings, const int turn_num, const TimeManager &time_manager,
+                      vector<move_pos> &turns)
+    {
+        if (!settings.solver)
+            return false;
+        const auto &mtx = board.get_board();
+        unsigned int pieces = 0;
+        for (const auto &row : mtx)
+            pieces += unsigned(count_if(row.begin(), row.end(), [](const POS_T type) { return type != 0; }));
+        if (pieces > settings.solver_max_pieces)
+            return false;
+        Solver solver(settings);
+        search_limits limits;
+        // С часами решатель получает половину времени на ход, остальное - обычному поиску
+        if (clock.enabled())
+            limits.time_ms = time_manager.soft_ms() / 2;
+        const auto res = solver.solve(mtx, color, limits, settings.max_turns - turn_num,
+                                      board.history.reversible_turns());
+        if (res.outcome != SolveOutcome::Win && res.outcome != SolveOutcome::Loss)
+            return false;
+        turns = res.turn();
+        logic.stats = res.stats;
+        return !turns.empty();
     }
 
-    //    
-    Response player_turn(const bool color)
+    // Распределение времени бота на этот ход по остатку на часах
+    TimeManager make_time_manager(const bool color, const Settings &settings, const int turn_num,
+                                  const vector<vector<move_pos>> &chains) const
     {
-        //    
+        const bool captures = !chains.empty() && chains.front().front().xb != -1;
+        const int turns_left = (int(settings.max_turns) - turn_num + 1) / 2;
+        return TimeManager(clock.remaining_ms(color), clock.increment_ms(), turns_left, chains.size(), captures);
+    }
+
+    // Ограничения поиска для уровня бота в режиме Bot.Difficulty = "Budget": глубина не ограничена,
+    // поиск останавливается ровно на бюджете позиций уровня
+    search_limits budget_limits(const bool color, const Settings &settings) const
+    {
+        search_limits limits;
+        if (settings.difficulty == Difficulty::Budget)
+        {
+            limits.depth = max_budget_depth;
+            limits.nodes = budget_levels[settings.bot_level[color]].nodes;
+        }
+        return limits;
+    }
+
+    vector<move_pos> budget_search(const bool color, const Settings &settings)
+    {
+        return logic.search(board.get_board(), board.history, color, budget_limits(color, settings));
+    }
+
+    /**
+     * Перебор с итеративным углублением до уровня бота (или до бюджета позиций) в пределах времени по часам.
+     * После каждого уровня TimeManager решает, начинать ли следующий: учитывается, сменился ли лучший ход
+     */
+    vector<move_pos> timed_search(const bool color, const Settings &settings, const TimeManager &time_manager)
+    {
+        TimeManager manager = time_manager;
+        atomic<bool> stop{false};
+        search_limits limits = budget_limits(color, settings);
+        limits.time_ms = manager.hard_ms();
+        limits.stop = &stop;
+        vector<move_pos> last_best;
+        return logic.search(board.get_board(), board.history, color, limits,
+                            [&](const search_stats &stats, const vector<move_pos> &best) {
+                                const bool best_changed = !last_best.empty() && best != last_best;
+                                last_best = best;
+                                if (manager.should_stop(stats.time_ms, best_changed))
+                                    stop = true;
+                            });
+    }
+
+    // Функция выполнения хода игрока
+    Response player_turn(const bool color, const Settings &settings)
+    {
+        // Подсказка ищется в фоне, пока игрок выбирает ход
+        if (settings.hint)
+        {
+            const int level = settings.hint_level ? settings.hint_level : settings.bot_level[!color] + 1;
+            hint.start(settings, board.get_board(), board.history, color, level);
+        }
+        bool is_hint_shown = !settings.hint;
+        // Пока игрок думает, показывается подсказка, когда она готова, и идут часы
+        auto on_idle = [this, color, &is_hint_shown] {
+            if (!is_hint_shown)
+            {
+                const auto best = hint.best();
+                if (!best.empty())
+                {
+                    board.show_hint(best);
+                    is_hint_shown = true;
+                }
+            }
+            return tick_clock(color);
+        };
+        const bool is_idle = settings.hint || clock.enabled();
+        // Подсветка возможных начальных позиций
         vector<pair<POS_T, POS_T>> cells;
         for (auto turn : logic.turns)
         {
@@ -161,16 +438,27 @@ class Game
         board.highlight_cells(cells);
         move_pos pos = {-1, -1, -1, -1};
         POS_T x = -1, y = -1;
-        //    
+        // Выбор начальной позиции фигуры
         while (true)
         {
-            auto resp = hand.get_cell();
+            auto resp = is_idle ? hand.get_cell(on_idle) : hand.get_cell();
+            // Поиск подсказки останавливается при любом действии игрока;
+            // после BACK и REPLAY позиция меняется, и результат подсказки сбрасывается
+            if (settings.hint)
+            {
+                if (get<0>(resp) == Response::CELL)
+                    hint.cancel();
+                else
+                    hint.reset();
+                board.clear_hint();
+                is_hint_shown = true;
+            }
             if (get<0>(resp) != Response::CELL)
                 return get<0>(resp);
             pair<POS_T, POS_T> cell{get<1>(resp), get<2>(resp)};
 
             bool is_correct = false;
-            //    
+            // Проверка корректности выбранной клетки
             for (auto turn : logic.turns)
             {
                 if (turn.x == cell.first && turn.y == cell.second)
@@ -198,7 +486,7 @@ class Game
                 y = -1;
                 continue;
             }
-            //      
+            // Подсветка возможных ходов для выбранной фигуры
             x = cell.first;
             y = cell.second;
             board.clear_highlight();
@@ -213,21 +501,22 @@ class Game
             }
             board.highlight_cells(cells2);
         }
-        //  
+        // Выполнение хода
         board.clear_highlight();
         board.clear_active();
         board.move_piece(pos, pos.xb != -1);
         if (pos.xb == -1)
             return Response::OK;
-        //   
+        // Обработка серии взятий
         beat_series = 1;
+        uint64_t captured = Logic::cell_bit(pos.xb, pos.yb); // Взятые в серии фигуры
         while (true)
         {
-            logic.find_turns(pos.x2, pos.y2);
+            logic.find_turns(pos.x2, pos.y2, board.get_board(), captured);
             if (!logic.have_beats)
                 break;
 
-            //    
+            // Подсветка возможных продолжений взятия
             vector<pair<POS_T, POS_T>> cells;
             for (auto turn : logic.turns)
             {
@@ -235,10 +524,10 @@ class Game
             }
             board.highlight_cells(cells);
             board.set_active(pos.x2, pos.y2);
-            //   
+            // Выбор продолжения хода
             while (true)
             {
-                auto resp = hand.get_cell();
+                auto resp = is_idle ? hand.get_cell(on_idle) : hand.get_cell();
                 if (get<0>(resp) != Response::CELL)
                     return get<0>(resp);
                 pair<POS_T, POS_T> cell{get<1>(resp), get<2>(resp)};
@@ -256,10 +545,11 @@ class Game
                 if (!is_correct)
                     continue;
 
-                //   
+                // Выполнение продолжения хода
                 board.clear_highlight();
                 board.clear_active();
                 beat_series += 1;
+                captured |= Logic::cell_bit(pos.xb, pos.yb);
                 board.move_piece(pos, beat_series);
                 break;
             }
@@ -269,10 +559,18 @@ class Game
     }
 
   private:
-      Config config;       //  
-      Board board;         //  
-      Hand hand;           //  
-      Logic logic;         //  
-      int beat_series;     //   
-      bool is_replay = false; //    
+      Config config;       // Конфигурация игры
+      Board board;         // Игровая доска
+      Hand hand;           // Обработчик ввода
+      Logic logic;         // Игровая логика
+      Telemetry telemetry; // Телеметрия ходов бота
+      Hint hint;           // Подсказка хода игроку
+      GameClock clock;     // Часы партии
+      chrono::steady_clock::time_point last_clock_draw; // Последнее обновление часов в окне
+      int beat_series;     // Счетчик серии взятий
+      bool is_replay = false; // Флаг режима повтора игры
+      // Период обновления статистики поиска поверх доски
+      static constexpr int overlay_period_ms = 200;
+      // Период обновления часов в окне
+      static constexpr int clock_period_ms = 100;
 };
@@ -1,23 +1,26 @@
 #pragma once
+#include <functional>
 #include <tuple>
 
 #include "../Models/Move.h"
 #include "../Models/Response.h"
 #include "Board.h"
 
-//      (, )
+// Класс для обработки пользовательского ввода (мышь, окно)
 class Hand
 {
   public:
-      // ,    
+      // Конструктор, принимает указатель на доску
     Hand(Board *board) : board(board)
     {
     }
-    //     -   :
-    // 1.   (Response)
-    // 2. X-  (  CELL)
-    // 3. Y-  (  CELL)
-    tuple<Response, POS_T, POS_T> get_cell() const
+    // Основной метод обработки ввода - возвращает кортеж из:
+    // 1. Тип действия (Response)
+    // 2. X-координата клетки (если действие CELL)
+    // 3. Y-координата клетки (если действие CELL)
+    // on_idle вызывается, пока событий нет (например, для показа результата фонового поиска или часов);
+    // ответ on_idle, отличный от OK, прерывает ожидание и возвращается
+    tuple<Response, POS_T, POS_T> get_cell(const function<Response()> &on_idle = nullptr) const
     {
         SDL_Event windowEvent;
         Response resp = Response::OK;
@@ -29,40 +32,40 @@ class Hand
             {
                 switch (windowEvent.type)
                 {
-                    //   
+                    // Обработка закрытия окна
                 case SDL_QUIT:
                     resp = Response::QUIT;
                     break;
-                    //   
+                    // Обработка клика мыши
                 case SDL_MOUSEBUTTONDOWN:
                     x = windowEvent.motion.x;
                     y = windowEvent.motion.y;
-                    //      
-                    xc = int(y / (board->H / 10) - 1);
-                    yc = int(x / (board->W / 10) - 1);
-                    //   "" (  )
-                    if (xc == -1 && yc == -1 && board->history_mtx.size() > 1)
+                    // Преобразование координат экрана в координаты доски
+                    xc = int(y / (board->H / Board::cells) - 1);
+                    yc = int(x / (board->W / Board::cells) - 1);
+                    // Обработка кнопки "Назад" (левый верхний угол)
+                    if (xc == -1 && yc == -1 && board->history.size() > 0)
                     {
                         resp = Response::BACK;
                     }
-                    //   "" (  )
-                    else if (xc == -1 && yc == 8)
+                    // Обработка кнопки "Повторить" (правый верхний угол)
+                    else if (xc == -1 && yc == board_size)
                     {
                         resp = Response::REPLAY;
                     }
-                    //     
-                    else if (xc >= 0 && xc < 8 && yc >= 0 && yc < 8)
+                    // Обработка клика по клетке доски
+                    else if (xc >= 0 && xc < board_size && yc >= 0 && yc < board_size)
                     {
                         resp = Response::CELL;
                     }
-                    //    
+                    // Клик вне значимых областей
                     else 
                     {
                         xc = -1;
                         yc = -1;
                     }
                     break;
-                    //    //    
+                    // Обработка изменения размера окна// Обработка изменения размера окна
                 case SDL_WINDOWEVENT:
                     if (windowEvent.window.event == SDL_WINDOWEVENT_SIZE_CHANGED)
                     {
@@ -70,15 +73,27 @@ class Hand
                         break;
                     }
                 }
-                //      
+                // Выход из цикла при значимом событии
                 if (resp != Response::OK)
                     break;
             }
+            else
+            {
+                // Кадры анимации хода бота рисуются, пока игрок выбирает ход
+                board->animate_frame();
+                if (!on_idle)
+                    continue;
+                resp = on_idle();
+                if (resp != Response::OK)
+                    break;
+                // Время процессора остается фоновому поиску
+                SDL_Delay(1);
+            }
         }
         return {resp, xc, yc};
     }
 
-    //     (   )
+    // Метод ожидания действия пользователя (используется после окончания игры)
     Response wait() const
     {
         SDL_Event windowEvent;
@@ -89,27 +104,27 @@ class Hand
             {
                 switch (windowEvent.type)
                 {
-                    //  
+                    // Закрытие окна
                 case SDL_QUIT:
                     resp = Response::QUIT;
                     break;
-                    //   
+                    // Изменение размера окна
                 case SDL_WINDOWEVENT_SIZE_CHANGED:
                     board->reset_window_size();
                     break;
-                    //  
+                    // Клик мыши
                 case SDL_MOUSEBUTTONDOWN: {
                     int x = windowEvent.motion.x;
                     int y = windowEvent.motion.y;
-                    int xc = int(y / (board->H / 10) - 1);
-                    int yc = int(x / (board->W / 10) - 1);
-                    //    ""
-                    if (xc == -1 && yc == 8)
+                    int xc = int(y / (board->H / Board::cells) - 1);
+                    int yc = int(x / (board->W / Board::cells) - 1);
+                    // Обработка только кнопки "Повторить"
+                    if (xc == -1 && yc == board_size)
                         resp = Response::REPLAY;
                 }
                 break;
                 }
-                //    QUIT  REPLAY
+                // Выход при получении QUIT или REPLAY
                 if (resp != Response::OK)
                     break;
             }
@@ -118,6 +133,6 @@ class Hand
     }
 
   private:
-      //    
+      // Указатель на игровую доску
     Board *board;
 };
@@ -0,0 +1,144 @@
+#pragma once
+#include <atomic>
+#include <mutex>
+#include <thread>
+#ifdef _WIN32
+    #ifndef NOMINMAX
+        #define NOMINMAX
+    #endif
+    #include <windows.h>
+#elif defined(__linux__)
+    #include <sys/resource.h>
+    #include <sys/syscall.h>
+    #include <unistd.h>
+#endif
+
+#include "../Models/Settings.h"
+#include "History.h"
+#include "Logic.h"
+#include "Notation.h"
+
+// Подсказка игроку: пока игрок выбирает ход, поиск с пониженным приоритетом
+// находит лучший ход на заданную глубину. Главный вариант подсказки содержит и ответ бота,
+// поэтому, если игрок сделал подсказанный ход, бот может взять ответ из него без нового поиска
+class Hint
+{
+  public:
+    ~Hint()
+    {
+        cancel();
+    }
+
+    /**
+     * Запуск поиска подсказки (предыдущий поиск отменяется)
+     * @param level уровень поиска (глубина - 1)
+     */
+    void start(const Settings &settings, const vector<vector<POS_T>> &mtx, const History &history, const bool color,
+               const int level)
+    {
+        cancel();
+        {
+            lock_guard<mutex> lock(result_mutex);
+            is_ready = false;
+            line.clear();
+        }
+        stop = false;
+        worker = thread(&Hint::search, this, settings, mtx, history, color, level);
+    }
+
+    // Остановка поиска; готовый результат сохраняется
+    void cancel()
+    {
+        stop = true;
+        if (worker.joinable())
+            worker.join();
+    }
+
+    // Отмена поиска и сброс результата (позиция изменилась не ходом игрока)
+    void reset()
+    {
+        cancel();
+        lock_guard<mutex> lock(result_mutex);
+        is_ready = false;
+        line.clear();
+    }
+
+    // Подсказанный ход, пустой вектор - поиск еще не дошел до заданной глубины
+    vector<move_pos> best() const
+    {
+        lock_guard<mutex> lock(result_mutex);
+        return is_ready ? split_turns(line).front() : vector<move_pos>();
+    }
+
+    /**
+     * Ответ бота из главного варианта подсказки
+     * @param history история партии после хода игрока
+     * @param level уровень бота: ответ берется, только если подсказка искала на ту же глубину
+     * @param turns ход бота
+     * @param stats счетчики поиска подсказки
+     * @return false - игрок сделал другой ход или глубина подсказки не совпадает
+     */
+    bool reply(const History &history, const int level, vector<move_pos> &turns, search_stats &stats) const
+    {
+        lock_guard<mutex> lock(result_mutex);
+        if (!is_ready || hint_level != level + 1 || history.size() != played_size || history.hash() != played_hash)
+            return false;
+        const auto line_turns = split_turns(line);
+        if (line_turns.size() < 2)
+            return false;
+        turns = line_turns[1];
+        stats = hint_stats;
+        return true;
+    }
+
+  private:
+    // Поиск в отдельном потоке с пониженным приоритетом
+    void search(const Settings settings, const vector<vector<POS_T>> mtx, const History history, const bool color,
+                const int level)
+    {
+        lower_priority();
+        Logic logic(settings);
+        logic.Max_depth = level;
+        search_limits limits;
+        limits.depth = level;
+        limits.stop = &stop;
+        logic.search(mtx, history, color, limits);
+        // Прерванный поиск не дошел до заданной глубины
+        if (logic.stats.depth != level + 1 || logic.principal_variation().empty())
+            return;
+
+        // Позиция после подсказанного хода: по ней проверяется, что игрок сделал этот ход
+        const auto result = logic.principal_variation();
+        vector<vector<POS_T>> next = mtx;
+        History next_history = history;
+        notation::apply_chain(next, next_history, split_turns(result).front());
+
+        lock_guard<mutex> lock(result_mutex);
+        line = result;
+        hint_stats = logic.stats;
+        hint_level = level;
+        played_size = next_history.size();
+        played_hash = next_history.hash();
+        is_ready = true;
+    }
+
+    // Поиск подсказки не должен отнимать время у обработки ввода
+    static void lower_priority()
+    {
+#ifdef _WIN32
+        SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_LOWEST);
+#elif defined(__linux__)
+        setpriority(PRIO_PROCESS, id_t(syscall(SYS_gettid)), 19);
+#endif
+    }
+
+    thread worker;
+    atomic<bool> stop{false};
+    mutable mutex result_mutex;
+    bool is_ready = false;     // поиск дошел до заданной глубины
+    vector<move_pos> line;     // главный вариант подсказки
+    search_stats hint_stats;   // счетчики поиска подсказки
+    int hint_level = 0;        // уровень поиска подсказки
+    size_t played_size = 0;    // длина истории после подсказанного хода
+    uint64_t played_hash = 0;  // хеш позиции после подсказанного хода
+};
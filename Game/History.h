@@ -0,0 +1,218 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+#include <vector>
+
+#include "../Models/Move.h"
+#include "Variant.h"
+
+using namespace std;
+
+// Номер клетки в журнале и ключах Зобриста - x * 8 + y
+static_assert(board_size == 8, "History stores cells of an 8x8 board");
+
+// Генератор псевдослучайных ключей (splitmix64), вычисляется на этапе компиляции,
+// поэтому хеши позиций совпадают между запусками и процессами
+constexpr uint64_t splitmix64(uint64_t &state)
+{
+    uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+// Ключи Зобриста: [тип фигуры 1..4][клетка 0..63], последний ключ - очередь хода черных
+struct zobrist_keys
+{
+    array<array<uint64_t, 64>, 5> piece{};
+    uint64_t black_turn = 0;
+};
+
+constexpr zobrist_keys make_zobrist_keys()
+{
+    zobrist_keys keys;
+    uint64_t state = 0x436865636B657273ULL;
+    for (int type = 1; type < 5; ++type)
+        for (int cell = 0; cell < 64; ++cell)
+            keys.piece[type][cell] = splitmix64(state);
+    keys.black_turn = splitmix64(state);
+    return keys;
+}
+
+inline constexpr zobrist_keys zobrist = make_zobrist_keys();
+
+// Хеш позиции без учета очереди хода
+inline uint64_t position_hash(const vector<vector<POS_T>> &mtx)
+{
+    uint64_t hash = 0;
+    for (POS_T i = 0; i < 8; ++i)
+    {
+        for (POS_T j = 0; j < 8; ++j)
+        {
+            if (mtx[i][j])
+                hash ^= zobrist.piece[mtx[i][j]][i * 8 + j];
+        }
+    }
+    return hash;
+}
+
+// Изменение хеша позиции mtx при ходе turn (без учета очереди хода)
+inline uint64_t turn_hash(const vector<vector<POS_T>> &mtx, const move_pos &turn)
+{
+    POS_T type = mtx[turn.x][turn.y];
+    uint64_t delta = zobrist.piece[type][turn.x * 8 + turn.y];
+    if (turn.xb != -1)
+        delta ^= zobrist.piece[mtx[turn.xb][turn.yb]][turn.xb * 8 + turn.yb];
+    if ((type == 1 && turn.x2 == 0) || (type == 2 && turn.x2 == board_size - 1))
+        type += 2;
+    return delta ^ zobrist.piece[type][turn.x2 * 8 + turn.y2];
+}
+
+// История партии: журнал компактных ходов и хешей позиций после каждого хода.
+// Отмена и повтор хода выполняются за O(1) и не выделяют память
+class History
+{
+  public:
+    History()
+    {
+        records.reserve(reserved_turns);
+        hashes.reserve(reserved_turns + 1);
+    }
+
+    // Начало новой партии с позиции mtx, color - чья очередь хода
+    void reset(const vector<vector<POS_T>> &mtx, const bool color = false)
+    {
+        records.clear();
+        hashes.clear();
+        hashes.push_back(position_hash(mtx) ^ (color ? zobrist.black_turn : 0));
+        cursor = 0;
+    }
+
+    // Выполнение хода на доске mtx и запись его в историю
+    void apply(vector<vector<POS_T>> &mtx, const move_pos &turn, const int beat_series = 0)
+    {
+        turn_record rec;
+        rec.from = uint8_t(turn.x * 8 + turn.y);
+        rec.to = uint8_t(turn.x2 * 8 + turn.y2);
+        rec.beaten = turn_record::no_cell;
+        rec.beaten_type = 0;
+        if (turn.xb != -1)
+        {
+            rec.beaten = uint8_t(turn.xb * 8 + turn.yb);
+            rec.beaten_type = uint8_t(mtx[turn.xb][turn.yb]);
+        }
+        const POS_T type = mtx[turn.x][turn.y];
+        const bool promotion = (type == 1 && turn.x2 == 0) || (type == 2 && turn.x2 == board_size - 1);
+        const bool reversible = type > 2 && turn.xb == -1;
+        rec.flags = uint8_t((min(beat_series, 63) << 2) | (reversible << 1) | promotion);
+
+        // Ходы, отмененные ранее, больше нельзя повторить
+        records.resize(cursor);
+        hashes.resize(cursor + 1);
+        records.push_back(rec);
+        hashes.push_back(hashes.back() ^ do_turn(mtx, rec));
+        ++cursor;
+    }
+
+    // Отмена последнего хода на доске mtx
+    void undo(vector<vector<POS_T>> &mtx)
+    {
+        if (!cursor)
+            throw runtime_error("history is empty, can't undo");
+        const turn_record &rec = records[--cursor];
+        const POS_T type = mtx[rec.to / 8][rec.to % 8];
+        mtx[rec.from / 8][rec.from % 8] = rec.is_promotion() ? type - 2 : type;
+        mtx[rec.to / 8][rec.to % 8] = 0;
+        if (rec.beaten != turn_record::no_cell)
+            mtx[rec.beaten / 8][rec.beaten % 8] = rec.beaten_type;
+    }
+
+    // Повтор последнего отмененного хода на доске mtx
+    bool redo(vector<vector<POS_T>> &mtx)
+    {
+        if (cursor == records.size())
+            return false;
+        do_turn(mtx, records[cursor++]);
+        return true;
+    }
+
+    // Количество сделанных ходов (переходов фигуры)
+    size_t size() const
+    {
+        return cursor;
+    }
+
+    // Номер в серии взятий последнего хода (0 - если ходов не было)
+    int last_beat_series() const
+    {
+        return cursor ? records[cursor - 1].beat_series() : 0;
+    }
+
+    const turn_record &operator[](const size_t i) const
+    {
+        return records[i];
+    }
+
+    // Количество последних ходов подряд без взятий и без ходов простыми
+    size_t reversible_turns() const
+    {
+        size_t count = 0;
+        while (count < cursor && records[cursor - count - 1].is_reversible())
+            ++count;
+        return count;
+    }
+
+    // Сколько раз текущая позиция встречалась в партии (включая текущую).
+    // Повториться позиция может только после обратимых ходов
+    int repetitions() const
+    {
+        const size_t reversible = reversible_turns();
+        int count = 1;
+        for (size_t back = 2; back <= reversible; back += 2)
+            count += (hashes[cursor - back] == hashes[cursor]);
+        return count;
+    }
+
+    // Хеш текущей позиции с учетом очереди хода
+    uint64_t hash() const
+    {
+        return hashes[cursor];
+    }
+
+    // Хеши позиций: 0 - начальная, i - после i-го хода
+    const vector<uint64_t> &position_hashes() const
+    {
+        return hashes;
+    }
+
+  private:
+    // Перенос фигуры по записи rec, возвращает изменение хеша позиции
+    uint64_t do_turn(vector<vector<POS_T>> &mtx, const turn_record &rec) const
+    {
+        uint64_t delta = 0;
+        POS_T type = mtx[rec.from / 8][rec.from % 8];
+        if (rec.beaten != turn_record::no_cell)
+        {
+            delta ^= zobrist.piece[rec.beaten_type][rec.beaten];
+            mtx[rec.beaten / 8][rec.beaten % 8] = 0;
+        }
+        delta ^= zobrist.piece[type][rec.from];
+        mtx[rec.from / 8][rec.from % 8] = 0;
+        if (rec.is_promotion())
+            type += 2;
+        delta ^= zobrist.piece[type][rec.to];
+        mtx[rec.to / 8][rec.to % 8] = type;
+        // Продолжение серии взятий не передает очередь хода
+        if (rec.beat_series() <= 1)
+            delta ^= zobrist.black_turn;
+        return delta;
+    }
+
+    // Сколько ходов резервируется заранее, чтобы партия не вызывала перевыделений
+    static constexpr size_t reserved_turns = 512;
+
+    vector<turn_record> records;
+    vector<uint64_t> hashes;
+    size_t cursor = 0;
+};
@@ -0,0 +1,21 @@
+#pragma once
+#include <cstdint>
+
+// Уровень бота в режиме Bot.Difficulty = "Budget": сила задается числом позиций на ход и шумом оценки,
+// а не глубиной перебора, поэтому время хода не зависит от позиции и не превышает бюджета
+struct budget_level
+{
+    uint64_t nodes; // позиций на ход, поиск останавливается ровно на этом числе
+    double noise;   // шум оценки листьев: оценка умножается на 1 + noise * u, u равномерно от -1 до 1
+};
+
+constexpr int max_budget_level = 15;
+
+// Бюджет удваивается с каждым уровнем, шум убывает и исчезает с уровня 12
+inline constexpr budget_level budget_levels[max_budget_level + 1] = {
+    {100, 0.5},     {200, 0.4},     {400, 0.32},     {800, 0.25},     {1600, 0.2},     {3200, 0.15},
+    {6400, 0.1},    {12800, 0.07},  {25600, 0.05},   {51200, 0.03},   {102400, 0.02},  {204800, 0.01},
+    {409600, 0},    {819200, 0},    {1638400, 0},    {3276800, 0}};
+
+// Предел глубины итеративного углубления при поиске с бюджетом позиций
+constexpr int max_budget_depth = 63;
@@ -1,191 +1,1071 @@
 #pragma once
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <memory>
 #include <random>
 #include <vector>
 
 #include "../Models/Move.h"
-#include "Board.h"
+#include "../Models/Search_stats.h"
+#include "AnalysisCache.h"
 #include "Config.h"
+#include "Endgame.h"
+#include "EvalCache.h"
+#include "History.h"
+#include "PvTable.h"
+#include "Rays.h"
+#include "Trace.h"
+#include "TransTable.h"
+#include "Variant.h"
 
 const int INF = 1e9;
+// Оценка ничейной позиции: силы сторон равны
+const double DRAW_SCORE = 1;
+// Битовые доски Logic (бит x * board_size + y) помещаются в 64 бита только для доски 8x8
+static_assert(board_size == 8, "Logic bitboards are built for an 8x8 board");
+
+// Константы стороны, которая ходит (false - белые, true - черные).
+// Генератор, выполнение хода, оценка и поиск специализируются по стороне при компиляции
+template <bool Color> struct side
+{
+    static constexpr POS_T man = Color ? 2 : 1;
+    static constexpr POS_T king = man + 2;
+    static constexpr POS_T forward = Color ? 1 : -1;      // направление хода простой
+    static constexpr POS_T promotion_row = Color ? board_size - 1 : 0; // ряд превращения в дамку
+
+    static constexpr bool is_own(const POS_T type)
+    {
+        return type == man || type == king;
+    }
+
+    static constexpr bool is_enemy(const POS_T type)
+    {
+        return side<!Color>::is_own(type);
+    }
+};
 
 class Logic {
 public:
+    // Конструктор: параметры бота читаются из конфигурации перед каждым поиском
+    Logic(Config *config) : config(config)
+    {
+        load_settings();
+        rand_eng = std::default_random_engine(
+            !settings->no_random ? unsigned(time(0)) : 0);
+    }
+
+    // Конструктор с фиксированными параметрами (без файла настроек)
+    Logic(const Settings &fixed_settings) : settings(make_shared<const Settings>(fixed_settings)), config(nullptr)
+    {
+        load_settings();
+        rand_eng = std::default_random_engine(
+            !settings->no_random ? unsigned(time(0)) : 0);
+    }
+
     /**
-     *       
-     * @param color   (true - , false - )
-     * @return   
+     * Находит лучшую последовательность ходов для заданного цвета на глубину Max_depth
+     * @param mtx состояние доски
+     * @param history история партии (для поиска повторений позиции)
+     * @param color цвет игрока (false - белые, true - черные)
+     * @return вектор лучших ходов
      */
-    vector<move_pos> find_best_turns(const bool color) {
-        next_best_state.clear();
-        next_move.clear();
+    vector<move_pos> find_best_turns(const vector<vector<POS_T>> &mtx, const History &history, const bool color) {
+        start_search(mtx, history);
+        find_turns(color, mtx);
+        vector<move_pos> best;
+        if (probe_cache(history, Max_depth + 1, best)) return best;
+
+        // Начинаем поиск с корневой позиции
+        stats.score = color ? find_first_best_turn<true>(mtx, -1, -1, 0) : find_first_best_turn<false>(mtx, -1, -1, 0);
+        line = pv.line();
+        finish_search();
+        best = best_chain();
+        record_cache(history, best);
+        return best;
+    }
+
+    /**
+     * Поиск с итеративным углублением: уровни 0, 1, ... до limits.depth
+     * или до исчерпания времени, числа позиций или внешней остановки.
+     * Результат прерванного уровня отбрасывается (уровень 0 не прерывается).
+     * Позиция, проанализированная в кэше анализа не мельче limits.depth, не ищется, результат поиска записывается в кэш
+     * @param on_iteration вызывается после каждого завершенного уровня
+     * @return вектор лучших ходов последнего завершенного уровня
+     */
+    vector<move_pos> search(const vector<vector<POS_T>> &mtx, const History &history, const bool color,
+        const search_limits &search_limits,
+        const function<void(const search_stats &, const vector<move_pos> &)> &on_iteration = nullptr) {
+        start_search(mtx, history);
+        limits = &search_limits;
+        node_budget = search_limits.nodes;
+        const int saved_depth = Max_depth;
+        const int max_level = search_limits.depth >= 0 ? search_limits.depth : Max_depth;
+
+        find_turns(color, mtx);
+        vector<move_pos> root_turns = turns;
+        const bool root_beats = have_beats;
+        vector<move_pos> best;
+        if (probe_cache(history, max_level + 1, best)) {
+            if (on_iteration) on_iteration(stats, best);
+            limits = nullptr;
+            node_budget = 0;
+            return best;
+        }
+        search_stats result = stats;
+        bool completed = false;
+        for (int level = 0; level <= max_level && !root_turns.empty(); ++level) {
+            TRACE_SCOPE_ARG("iteration", "depth", level + 1);
+            Max_depth = level;
+            can_abort = level > 0;
+            if (progress) progress->depth.store(level + 1, memory_order_relaxed);
+            turns = root_turns;
+            have_beats = root_beats;
+            const double score =
+                color ? find_first_best_turn<true>(mtx, -1, -1, 0) : find_first_best_turn<false>(mtx, -1, -1, 0);
+            if (aborted) break;
+
+            best = best_chain();
+            line = pv.line();
+            stats.depth = level + 1;
+            stats.score = score;
+            stats.time_ms = elapsed_ms();
+            result = stats;
+            completed = true;
+            if (on_iteration) on_iteration(stats, best);
+            // Лучший ход проверяется первым на следующем уровне
+            auto it = find(root_turns.begin(), root_turns.end(), best.front());
+            rotate(root_turns.begin(), it, it + 1);
+            if (limit_reached()) break;
+        }
+        // Бюджет позиций кончился на первом уровне: лучший из полностью оцененных ходов, иначе первый ход
+        if (best.empty() && !root_turns.empty()) {
+            best = best_chain();
+            if (best.empty()) best = turn_chains(color, mtx).front();
+            line = best;
+        }
+
+        Max_depth = saved_depth;
+        limits = nullptr;
+        node_budget = 0;
+        can_abort = false;
+        // В статистике остаются счетчики всего поиска и оценка последнего завершенного уровня
+        result.nodes = stats.nodes;
+        result.leaves = stats.leaves;
+        result.cutoffs = stats.cutoffs;
+        result.tt_hits = stats.tt_hits;
+        result.expanded = stats.expanded;
+        result.generated = stats.generated;
+        result.endgame_hits = stats.endgame_hits;
+        stats = result;
+        finish_search();
+        if (completed) record_cache(history, best);
+        return best;
+    }
+
+    /**
+     * Анализ нескольких лучших ходов (multi-PV) с итеративным углублением.
+     * Ходы из корня - полные серии взятий; граница отсечения в корне - оценка count-го
+     * лучшего хода, поэтому точные оценки получают все ходы, попавшие в первые count
+     * @param count число вариантов
+     * @param on_iteration вызывается после каждого завершенного уровня
+     * @return до count вариантов по убыванию оценки (последний завершенный уровень)
+     */
+    vector<pv_line> search_lines(const vector<vector<POS_T>> &mtx, const History &history, const bool color,
+        const size_t count, const search_limits &search_limits,
+        const function<void(const search_stats &, const vector<pv_line> &)> &on_iteration = nullptr) {
+        start_search(mtx, history);
+        limits = &search_limits;
+        node_budget = search_limits.nodes;
+        const int saved_depth = Max_depth;
+        const int max_level = search_limits.depth >= 0 ? search_limits.depth : Max_depth;
+
+        find_turns(color, mtx);
+        vector<vector<move_pos>> root_chains;
+        vector<move_pos> chain;
+        if (color) add_turn_chains<true>(mtx, chain, root_chains);
+        else add_turn_chains<false>(mtx, chain, root_chains);
+        vector<pv_line> best;
+        search_stats result = stats;
+        for (int level = 0; level <= max_level && !root_chains.empty() && count > 0; ++level) {
+            TRACE_SCOPE_ARG("iteration", "depth", level + 1);
+            Max_depth = level;
+            can_abort = level > 0;
+            if (progress) progress->depth.store(level + 1, memory_order_relaxed);
+            auto lines = color ? find_root_lines<true>(mtx, root_chains, count)
+                               : find_root_lines<false>(mtx, root_chains, count);
+            if (aborted) {
+                // Бюджет позиций кончился на первом уровне: оцененные ходы, иначе первый ход
+                if (best.empty() && lines.empty()) {
+                    pv_line first;
+                    first.turn_length = root_chains.front().size();
+                    first.moves = root_chains.front();
+                    lines.push_back(first);
+                }
+                if (best.empty()) best = move(lines);
+                break;
+            }
+
+            best = move(lines);
+            line = best.front().moves;
+            stats.depth = level + 1;
+            stats.score = best.front().score;
+            stats.time_ms = elapsed_ms();
+            result = stats;
+            if (on_iteration) on_iteration(stats, best);
+            // Лучшие ходы проверяются первыми на следующем уровне
+            stable_partition(root_chains.begin(), root_chains.end(), [&](const vector<move_pos> &c) {
+                return any_of(best.begin(), best.end(), [&](const pv_line &l) { return l.turn() == c; });
+            });
+            stable_sort(root_chains.begin(), root_chains.begin() + best.size(),
+                [&](const vector<move_pos> &a, const vector<move_pos> &b) {
+                    auto rank = [&](const vector<move_pos> &c) {
+                        return find_if(best.begin(), best.end(), [&](const pv_line &l) { return l.turn() == c; }) -
+                               best.begin();
+                    };
+                    return rank(a) < rank(b);
+                });
+            if (limit_reached()) break;
+        }
+
+        Max_depth = saved_depth;
+        limits = nullptr;
+        node_budget = 0;
+        can_abort = false;
+        result.nodes = stats.nodes;
+        result.leaves = stats.leaves;
+        result.cutoffs = stats.cutoffs;
+        result.tt_hits = stats.tt_hits;
+        result.expanded = stats.expanded;
+        result.generated = stats.generated;
+        result.endgame_hits = stats.endgame_hits;
+        stats = result;
+        finish_search();
+        return best;
+    }
+
+    // Главный вариант последнего поиска: ход бота и ожидаемое продолжение (каждый прыжок - отдельный элемент)
+    const vector<move_pos> &principal_variation() const
+    {
+        return line;
+    }
+
+    /**
+     * Выполняет ход на копии доски
+     * @param mtx состояние доски
+     * @param turn ход
+     * @return состояние доски после хода
+     */
+    vector<vector<POS_T>> make_turn(vector<vector<POS_T>> mtx, move_pos turn) const
+    {
+        return mtx[turn.x][turn.y] % 2 ? make_turn<false>(move(mtx), turn) : make_turn<true>(move(mtx), turn);
+    }
+
+    // Выполнение хода фигурой стороны Color
+    template <bool Color> vector<vector<POS_T>> make_turn(vector<vector<POS_T>> mtx, const move_pos &turn) const
+    {
+        if (turn.xb != -1)
+            mtx[turn.xb][turn.yb] = 0;
+        POS_T type = mtx[turn.x][turn.y];
+        if (type == side<Color>::man && turn.x2 == side<Color>::promotion_row)
+            type = side<Color>::king;
+        mtx[turn.x2][turn.y2] = type;
+        mtx[turn.x][turn.y] = 0;
+        return mtx;
+    }
+
+    /**
+     * Оценивает позицию с точки зрения бота
+     * @param mtx состояние доски
+     * @param first_bot_color true - бот играет черными
+     * @return отношение сил бота к силам противника (INF - победа бота, 0 - поражение)
+     */
+    double calc_score(const vector<vector<POS_T>> &mtx, const bool first_bot_color) const
+    {
+        return first_bot_color ? calc_score<true>(mtx) : calc_score<false>(mtx);
+    }
+
+    // Оценка позиции для бота, играющего стороной Bot
+    template <bool Bot> double calc_score(const vector<vector<POS_T>> &mtx) const
+    {
+        TRACE_SAMPLED_SCOPE("eval");
+        if (scoring_mode == ScoringType::NumberAndStructure)
+        {
+            const material_state material = material_of(mtx);
+            const double men[2] = {men_score<false>(material.men[0]), men_score<true>(material.men[1])};
+            return material_score<Bot>(men, material.kings);
+        }
+        double w = 0, wq = 0, b = 0, bq = 0;
+        for (POS_T i = 0; i < board_size; ++i)
+        {
+            for (POS_T j = 0; j < board_size; ++j)
+            {
+                w += (mtx[i][j] == 1);
+                wq += (mtx[i][j] == 3);
+                b += (mtx[i][j] == 2);
+                bq += (mtx[i][j] == 4);
+                if (scoring_mode == ScoringType::NumberAndPotential)
+                {
+                    w += 0.05 * (mtx[i][j] == 1) * (board_size - 1 - i);
+                    b += 0.05 * (mtx[i][j] == 2) * (i);
+                }
+            }
+        }
+        if (!Bot)
+        {
+            swap(b, w);
+            swap(bq, wq);
+        }
+        if (w + wq == 0)
+            return INF;
+        if (b + bq == 0)
+            return 0;
+        int q_coef = 4;
+        if (scoring_mode == ScoringType::NumberAndPotential)
+        {
+            q_coef = 5;
+        }
+        return (b + bq * q_coef) / (w + wq * q_coef);
+    }
 
-        //     
-        find_first_best_turn(board->get_board(), color, -1, -1, 0);
+    /**
+     * Структурная оценка простых стороны (бит x * 8 + y): продвижение (0.05 за ряд, как в NumberAndPotential),
+     * охрана своего последнего ряда (0.1 за простую) и связки (0.03 за простую, прикрытую сзади своей простой)
+     * @tparam Color false - белые (идут к x = 0), true - черные
+     */
+    template <bool Color> static double men_structure(const uint64_t men)
+    {
+        constexpr uint64_t left_edge = 0x0101010101010101ULL;  // y = 0
+        constexpr uint64_t right_edge = 0x8080808080808080ULL; // y = 7
+        constexpr int home_row = Color ? 0 : board_size - 1;
+        // Поля перед простыми: простая на поле (x - forward, y +- 1) прикрывает простую на (x, y)
+        const uint64_t covered = Color ? ((men & ~left_edge) << 7) | ((men & ~right_edge) << 9)
+                                       : ((men & ~right_edge) >> 7) | ((men & ~left_edge) >> 9);
+        double res = 0;
+        for (uint64_t b = men; b; b &= b - 1)
+        {
+            const int x = lowest_bit(b) / 8;
+            res += 0.05 * (Color ? x : board_size - 1 - x);
+            res += 0.1 * (x == home_row);
+        }
+        return res + 0.03 * __builtin_popcountll(men & covered);
+    }
 
-        //    
-        vector<move_pos> result;
-        int current_state = 0;
-        while (current_state != -1 && next_move[current_state].x != -1) {
-            result.push_back(next_move[current_state]);
-            current_state = next_best_state[current_state];
+    /**
+     * Число простых стороны и их продвижение (0.05 за ряд) в порядке обхода доски в calc_score,
+     * поэтому сумма совпадает с оценкой NumberAndPotential до последнего бита
+     */
+    template <bool Color> static double men_potential(const uint64_t men)
+    {
+        double res = 0;
+        for (uint64_t b = men; b; b &= b - 1)
+        {
+            const int x = lowest_bit(b) / board_size;
+            res += 1;
+            res += 0.05 * (Color ? x : board_size - 1 - x);
         }
-        return result;
+        return res;
     }
 
 private:
+    // Материал позиции: простые сторон (бит x * board_size + y) и число дамок
+    struct material_state
+    {
+        uint64_t men[2] = {0, 0};
+        int kings[2] = {0, 0};
+    };
+
+    static material_state material_of(const vector<vector<POS_T>> &mtx)
+    {
+        material_state res;
+        for (POS_T i = 0; i < board_size; ++i)
+        {
+            for (POS_T j = 1 - i % 2; j < board_size; j += 2)
+            {
+                const POS_T type = mtx[i][j];
+                if (type == 1 || type == 2)
+                    res.men[type - 1] |= uint64_t(1) << (i * board_size + j);
+                else if (type)
+                    ++res.kings[type - 3];
+            }
+        }
+        return res;
+    }
+
+    // Изменение cur_material ходом turn стороны Color; mtx - позиция до хода
+    template <bool Color> void update_material(const vector<vector<POS_T>> &mtx, const move_pos &turn)
+    {
+        if (turn.xb != -1)
+        {
+            if (mtx[turn.xb][turn.yb] > 2)
+                --cur_material.kings[!Color];
+            else
+                cur_material.men[!Color] &= ~(uint64_t(1) << (turn.xb * board_size + turn.yb));
+        }
+        if (mtx[turn.x][turn.y] != side<Color>::man)
+            return;
+        cur_material.men[Color] &= ~(uint64_t(1) << (turn.x * board_size + turn.y));
+        if (turn.x2 == side<Color>::promotion_row)
+            ++cur_material.kings[Color];
+        else
+            cur_material.men[Color] |= uint64_t(1) << (turn.x2 * board_size + turn.y2);
+    }
+
+    // Оценка простых стороны Color в режиме scoring_mode: число простых и их позиционная часть
+    template <bool Color> double men_score(const uint64_t men) const
+    {
+        if (scoring_mode == ScoringType::NumberAndStructure)
+            return __builtin_popcountll(men) + men_structure<Color>(men);
+        return men_potential<Color>(men);
+    }
+
+    // Отношение сил бота к силам противника по оценкам простых сторон и числу дамок (дамка - 5 простых)
+    template <bool Bot> static double material_score(const double men[2], const int kings[2])
+    {
+        double w = men[0], wq = kings[0], b = men[1], bq = kings[1];
+        if (!Bot)
+        {
+            swap(b, w);
+            swap(bq, wq);
+        }
+        if (w + wq == 0)
+            return INF;
+        if (b + bq == 0)
+            return 0;
+        return (b + bq * 5) / (w + wq * 5);
+    }
+
+    /**
+     * Оценка листа перебора. В режимах NumberAndPotential и NumberAndStructure с кэшем оценки простых
+     * доска не обходится: материал пути (cur_material) обновляется ходами, оценка простых берется
+     * из кэша (EvalCache) по расположению простых. Результат совпадает с calc_score
+     */
+    template <bool Bot> double leaf_score(const vector<vector<POS_T>> &mtx) const
+    {
+        if (!use_eval_cache || scoring_mode == ScoringType::NumberOnly)
+            return calc_score<Bot>(mtx);
+        TRACE_SAMPLED_SCOPE("eval");
+        double men[2];
+        if (!eval_cache.probe(cur_material.men[0], cur_material.men[1], men))
+        {
+            men[0] = men_score<false>(cur_material.men[0]);
+            men[1] = men_score<true>(cur_material.men[1]);
+            eval_cache.store(cur_material.men[0], cur_material.men[1], men);
+        }
+        return material_score<Bot>(men, cur_material.kings);
+    }
+
+    // Подготовка к поиску: снимок настроек, сброс счетчиков, позиции для поиска повторений
+    void start_search(const vector<vector<POS_T>> &mtx, const History &history) {
+        ply = 0;
+        line.clear();
+        // Настройки фиксируются на время поиска
+        load_settings();
+        // Шумная оценка зависит от поиска, поэтому не записывается в общую таблицу и кэш анализа
+        if (eval_noise > 0) {
+            tt = nullptr;
+            cache = nullptr;
+        }
+        noise_seed = eval_noise > 0 && !settings->no_random ? uint64_t(rand_eng()) : 0;
+        stats = search_stats();
+        endgame_material = true;
+        eval_hits_base = eval_cache.hits;
+        eval_misses_base = eval_cache.misses;
+        stats.depth = Max_depth + 1;
+        aborted = false;
+        if (tt) tt->new_search();
+        start_time = chrono::steady_clock::now();
+        if (progress)
+        {
+            progress->depth.store(stats.depth, memory_order_relaxed);
+            progress->nodes.store(0, memory_order_relaxed);
+        }
+
+        // Позиции после последнего необратимого хода партии
+        const size_t reversible = history.reversible_turns();
+        const auto &hashes = history.position_hashes();
+        rep_stack.assign(hashes.begin() + (history.size() - reversible), hashes.begin() + (history.size() + 1));
+        rep_base = 0;
+        cur_hash = history.hash();
+        cur_material = material_of(mtx);
+    }
+
+    void finish_search() {
+        stats.time_ms = elapsed_ms();
+        stats.eval_cache_hits = eval_cache.hits - eval_hits_base;
+        stats.eval_cache_misses = eval_cache.misses - eval_misses_base;
+        if (progress) progress->nodes.store(stats.nodes, memory_order_relaxed);
+    }
+
+    double elapsed_ms() const {
+        return chrono::duration<double, milli>(chrono::steady_clock::now() - start_time).count();
+    }
+
+    // Проверка ограничений поиска (только при поиске с итеративным углублением)
+    bool limit_reached() const {
+        if (!limits) return false;
+        if (limits->stop && limits->stop->load(memory_order_relaxed)) return true;
+        if (limits->nodes && stats.nodes >= limits->nodes) return true;
+        return limits->time_ms > 0 && elapsed_ms() >= limits->time_ms;
+    }
+
+    // Бюджет позиций исчерпан: поиск прерывается до входа в следующую позицию, поэтому
+    // число позиций никогда не превышает бюджета (проверка на каждой позиции, на любом уровне)
+    bool budget_spent() {
+        if (node_budget && stats.nodes >= node_budget) aborted = true;
+        return aborted && node_budget;
+    }
+
     /**
-     *     ( )
-     * @param mtx   
-     * @param color  
-     * @param x,y   (  )
-     * @param state  
-     * @param alpha   - 
-     * @return  
+     * Оценка с шумом: множитель 1 + eval_noise * u, где u от -1 до 1 зависит от позиции и поиска,
+     * поэтому повторная оценка той же позиции в одном поиске совпадает. Победа и поражение не искажаются
      */
-    double find_first_best_turn(vector<vector<POS_T>> mtx, const bool color,
+    double noisy_score(const double score) const {
+        if (score <= 0 || score >= INF) return score;
+        uint64_t state = cur_hash ^ noise_seed;
+        const double u = double(splitmix64(state) >> 11) / double(uint64_t(1) << 53) * 2 - 1;
+        return score * (1 + eval_noise * u);
+    }
+
+    // Ход бота из главного варианта (серия взятий целиком)
+    vector<move_pos> best_chain() const {
+        const auto line_turns = split_turns(pv.line());
+        return line_turns.empty() ? vector<move_pos>() : line_turns.front();
+    }
+
+    // Берет актуальный снимок настроек из конфигурации
+    void load_settings()
+    {
+        if (config) settings = config->snapshot();
+        // Кэш оценки простых хранит оценки одного режима
+        if (settings->scoring != scoring_mode) eval_cache.clear();
+        scoring_mode = settings->scoring;
+        use_eval_cache = settings->eval_cache;
+        use_endgame = settings->endgame;
+        optimization = settings->optimization;
+        no_progress_turns = settings->no_progress_turns;
+        tt = settings->tt_size_mb ? open_table(*settings) : nullptr;
+        cache = settings->cache_file.empty() ? nullptr : open_cache(*settings);
+    }
+
+    // Общий кэш анализа из настроек; при ошибке поиск идет без кэша, ошибка пишется в лог
+    static shared_ptr<AnalysisCache> open_cache(const Settings &s)
+    {
+        const string path =
+            filesystem::path(s.cache_file).is_absolute() ? s.cache_file : project_path + s.cache_file;
+        try
+        {
+            return AnalysisCache::shared(path);
+        }
+        catch (const exception &e)
+        {
+            ofstream fout(project_path + "log.txt", ios_base::app);
+            fout << "Error: analysis cache is disabled. " << e.what() << endl;
+            return nullptr;
+        }
+    }
+
+    // Ключ кэша анализа: позиция, ходы без прогресса подряд и функция оценки
+    uint64_t cache_key(const History &history) const
+    {
+        uint64_t state = history.reversible_turns();
+        return history.hash() ^ splitmix64(state) ^ scoring_key();
+    }
+
+    // Ответ из кэша анализа, если позиция проанализирована не меньше чем на depth уровней
+    bool probe_cache(const History &history, const int depth, vector<move_pos> &best)
+    {
+        cached_analysis res;
+        if (!cache || !cache->lookup(cache_key(history), depth, res) || !res.turn_length) return false;
+        best = res.turn();
+        line = res.line;
+        stats.depth = res.depth;
+        stats.score = res.score;
+        finish_search();
+        return true;
+    }
+
+    // Запись поиска в кэш анализа (не мельче AnalysisCache.MinDepth)
+    void record_cache(const History &history, const vector<move_pos> &best)
+    {
+        if (!cache || best.empty() || stats.depth < int(settings->cache_min_depth)) return;
+        cached_analysis res;
+        res.depth = stats.depth;
+        res.score = stats.score;
+        res.nodes = stats.nodes;
+        res.turn_length = best.size();
+        res.line = line.size() >= best.size() && equal(best.begin(), best.end(), line.begin()) ? line : best;
+        try
+        {
+            cache->store(cache_key(history), res);
+        }
+        catch (const exception &e)
+        {
+            ofstream fout(project_path + "log.txt", ios_base::app);
+            fout << "Error: " << e.what() << endl;
+        }
+    }
+
+    // Общая таблица транспозиций из настроек; при ошибке поиск идет без таблицы, ошибка пишется в лог
+    static shared_ptr<TransTable> open_table(const Settings &s)
+    {
+        const string path = s.tt_file.empty() || filesystem::path(s.tt_file).is_absolute()
+                                ? s.tt_file : project_path + s.tt_file;
+        try
+        {
+            return TransTable::shared(path, s.tt_size_mb);
+        }
+        catch (const exception &e)
+        {
+            ofstream fout(project_path + "log.txt", ios_base::app);
+            fout << "Error: transposition table is disabled. " << e.what() << endl;
+            return nullptr;
+        }
+    }
+
+    /**
+     * Ключ позиции в таблице транспозиций: оценка зависит от стороны бота и функции оценки,
+     * поэтому они входят в ключ вместе с хешем позиции и стороны, которая ходит
+     */
+    template <bool Bot> uint64_t table_key() const {
+        return cur_hash ^ (Bot ? tt_bot_key : 0) ^ scoring_key();
+    }
+
+    // Добавка функции оценки к ключам таблицы и кэша анализа (NumberAndPotential - без добавки)
+    uint64_t scoring_key() const {
+        switch (scoring_mode) {
+        case ScoringType::NumberOnly: return tt_scoring_key;
+        case ScoringType::NumberAndStructure: return tt_structure_key;
+        default: return 0;
+        }
+    }
+
+    /**
+     * Сохранение результата узла с окном (alpha, beta) на входе.
+     * Отсечение срабатывает только при alpha == beta, поэтому при alpha > beta поддерево
+     * перебирается полностью и оценка точная. Оценки за границами обычного окна сохраняются
+     * как границы (alpha или beta), а не как сама оценка: при отсечении поиск возвращает оценку, сдвинутую за окно
+     */
+    void store_result(const uint64_t key, const int draft, const double alpha, const double beta, const double score,
+        const move_pos &best) {
+        if (alpha == beta) return;
+        if (alpha > beta) tt->store(key, draft, tt_bound::exact, score, best);
+        else if (score <= alpha) tt->store(key, draft, tt_bound::upper, alpha, best);
+        else if (score >= beta) tt->store(key, draft, tt_bound::lower, beta, best);
+        else tt->store(key, draft, tt_bound::exact, score, best);
+    }
+
+    /**
+     * Находит первый лучший ход (начало рекурсии)
+     * Color - цвет бота, который ходит в корне
+     * @param mtx текущее состояние доски
+     * @param x,y координаты фигуры (если есть взятие)
+     * @param state 0 - корень, иначе продолжение серии взятий (номер прыжка ply)
+     * @param alpha значение для альфа-бета отсечения
+     * @param captured клетки фигур, уже взятых в серии
+     * @return оценка позиции
+     */
+    template <bool Color>
+    double find_first_best_turn(const vector<vector<POS_T>> &mtx,
         const POS_T x, const POS_T y, size_t state,
-        double alpha = -1) {
-        // 
-        next_best_state.push_back(-1);
-        next_move.emplace_back(-1, -1, -1, -1);
+        double alpha = -1, const uint64_t captured = 0) {
+        // Инициализация
+        pv.clear(ply);
         double best_score = -1;
+        if (budget_spent()) return best_score;
+        ++stats.nodes;
 
-        //   
-        if (state != 0) find_turns(x, y, mtx);
+        // Поиск возможных ходов
+        if (state != 0) find_piece_turns<Color>(x, y, mtx, captured);
         auto current_turns = turns;
         bool has_captures = have_beats;
+        ++stats.expanded;
+        stats.generated += current_turns.size();
 
-        //    -    
+        // Если нет взятий - переходим к обычному поиску
         if (!has_captures && state != 0) {
-            return find_best_turns_rec(mtx, !color, 0, alpha);
+            return finish_turn<!Color, Color>(mtx, 0, alpha, INF + 1, false);
         }
 
-        //    
+        // Перебор всех возможных ходов
         for (auto& turn : current_turns) {
-            size_t next_state = next_move.size();
+            // Размер поддерева каждого хода из корня
+            TRACE_SCOPE_COUNTER("root_move", state == 0, "nodes", stats.nodes,
+                cell_name(turn.x, turn.y) + (turn.xb != -1 ? ":" : "-") + cell_name(turn.x2, turn.y2));
             double score;
+            const uint64_t saved_hash = cur_hash;
+            const material_state saved_pieces = cur_material;
+            cur_hash ^= turn_hash(mtx, turn) ^ (state == 0 ? zobrist.black_turn : 0);
+            update_material<Color>(mtx, turn);
 
+            ++ply;
             if (has_captures) {
-                score = find_first_best_turn(make_turn(mtx, turn), color,
-                    turn.x2, turn.y2, next_state, best_score);
+                score = find_first_best_turn<Color>(make_turn<Color>(mtx, turn),
+                    turn.x2, turn.y2, ply, best_score, captured | cell_bit(turn.xb, turn.yb));
             }
             else {
-                score = find_best_turns_rec(make_turn(mtx, turn), !color, 0, best_score);
+                score = finish_turn<!Color, Color>(make_turn<Color>(mtx, turn), 0, best_score, INF + 1,
+                    mtx[turn.x][turn.y] > 2);
             }
+            --ply;
+            cur_hash = saved_hash;
+            cur_material = saved_pieces;
+            if (aborted) return best_score;
 
-            //   
+            // Обновление лучшего хода
             if (score > best_score) {
                 best_score = score;
-                next_best_state[state] = has_captures ? next_state : -1;
-                next_move[state] = turn;
+                pv.update(ply, turn);
+                if (progress && state == 0) progress->set_pv(best_chain());
             }
         }
 
         return best_score;
     }
 
+    // Все ходы из позиции mtx в виде полных серий взятий (ходы стороны Color уже найдены в turns);
+    // captured - клетки фигур, уже взятых в серии
+    template <bool Color>
+    void add_turn_chains(const vector<vector<POS_T>> &mtx, vector<move_pos> &chain, vector<vector<move_pos>> &res,
+        const uint64_t captured = 0) {
+        const auto current_turns = turns;
+        const bool has_captures = have_beats;
+        for (const auto &turn : current_turns) {
+            chain.push_back(turn);
+            if (has_captures) {
+                const auto next = make_turn<Color>(mtx, turn);
+                const uint64_t next_captured = captured | cell_bit(turn.xb, turn.yb);
+                find_piece_turns<Color>(turn.x2, turn.y2, next, next_captured);
+                if (have_beats) add_turn_chains<Color>(next, chain, res, next_captured);
+                else res.push_back(chain);
+            }
+            else res.push_back(chain);
+            chain.pop_back();
+        }
+    }
+
+    /**
+     * Один уровень анализа нескольких ходов: каждая серия из chains оценивается
+     * с границей отсечения, равной оценке count-го лучшего хода
+     * @return до count вариантов по убыванию оценки
+     */
+    template <bool Color>
+    vector<pv_line> find_root_lines(const vector<vector<POS_T>> &mtx, const vector<vector<move_pos>> &chains,
+        const size_t count) {
+        vector<pv_line> lines;
+        if (budget_spent()) return lines;
+        ++stats.nodes;
+        ++stats.expanded;
+        stats.generated += chains.size();
+        for (const auto &chain : chains) {
+            TRACE_SCOPE_COUNTER("root_move", true, "nodes", stats.nodes,
+                cell_name(chain.front().x, chain.front().y) + (chain.front().xb != -1 ? ":" : "-") +
+                    cell_name(chain.back().x2, chain.back().y2));
+            const double bound = lines.size() < count ? -1 : lines.back().score;
+            // Позиция и хеш после серии
+            vector<vector<POS_T>> next = mtx;
+            const uint64_t saved_hash = cur_hash;
+            const material_state saved_pieces = cur_material;
+            cur_hash ^= zobrist.black_turn;
+            for (const auto &turn : chain) {
+                cur_hash ^= turn_hash(next, turn);
+                update_material<Color>(next, turn);
+                next = make_turn<Color>(move(next), turn);
+            }
+            const bool reversible = chain.front().xb == -1 && mtx[chain.front().x][chain.front().y] > 2;
+            ply = chain.size();
+            const double score = finish_turn<!Color, Color>(next, 0, bound, INF + 1, reversible);
+            ply = 0;
+            cur_hash = saved_hash;
+            cur_material = saved_pieces;
+            if (aborted) return lines;
+            // Оценка не выше границы - только верхняя оценка хода, он не входит в первые count
+            if (score <= bound) continue;
+
+            pv_line res;
+            res.score = score;
+            res.turn_length = chain.size();
+            res.moves = chain;
+            const auto continuation = pv.line(chain.size());
+            res.moves.insert(res.moves.end(), continuation.begin(), continuation.end());
+            auto pos = upper_bound(lines.begin(), lines.end(), score,
+                [](const double value, const pv_line &l) { return value > l.score; });
+            lines.insert(pos, move(res));
+            if (lines.size() > count) lines.pop_back();
+            if (progress) progress->set_pv(lines.front().turn());
+        }
+        return lines;
+    }
+
     /**
-     *    - 
-     * @param mtx  
-     * @param color  
-     * @param depth  
-     * @param alpha,beta  
-     * @param x,y   (  )
-     * @return  
+     * Рекурсивный поиск с альфа-бета отсечением.
+     * Color - сторона, которая ходит, Bot - сторона бота (ход бота - нечетные уровни depth)
+     * @param mtx состояние доски
+     * @param depth глубина рекурсии
+     * @param alpha,beta параметры отсечения
+     * @param x,y координаты фигуры (если есть взятие)
+     * @param captured клетки фигур, уже взятых в серии
+     * @return оценка позиции
      */
-    double find_best_turns_rec(vector<vector<POS_T>> mtx, const bool color,
+    template <bool Color, bool Bot>
+    double find_best_turns_rec(const vector<vector<POS_T>> &mtx,
         const size_t depth, double alpha = -1,
         double beta = INF + 1, const POS_T x = -1,
-        const POS_T y = -1) {
-        //   -   
-        if (depth == Max_depth) {
-            return calc_score(mtx, depth % 2 == color);
+        const POS_T y = -1, const uint64_t captured = 0) {
+        if (budget_spent()) return 0;
+        ++stats.nodes;
+        if (!(stats.nodes & 1023)) {
+            if (progress) progress->nodes.store(stats.nodes, memory_order_relaxed);
+            if (can_abort && limit_reached()) aborted = true;
+        }
+        if (aborted) return 0;
+        pv.clear(ply);
+        // Распознанное окончание: ничья завершает ветку на любой глубине, оценка окончания заменяет calc_score.
+        // Материал меняется только необратимыми ходами, поэтому после неудачной проверки
+        // он не проверяется до следующего необратимого хода (finish_turn)
+        endgame_position ending;
+        if (use_endgame && endgame_material && x == -1) {
+            endgame_material = Endgame::collect(mtx, ending) && Endgame::recognizes(ending);
+        }
+        if (use_endgame && endgame_material && x == -1) {
+            const endgame_result res = Endgame::probe(ending, Color);
+            if (res.type == endgame_result::kind::draw) {
+                ++stats.endgame_hits;
+                return DRAW_SCORE;
+            }
+            if (res.type == endgame_result::kind::eval && depth == size_t(Max_depth)) {
+                ++stats.leaves;
+                ++stats.endgame_hits;
+                const double score = Bot ? 1 / res.score : res.score;
+                return eval_noise > 0 ? noisy_score(score) : score;
+            }
+        }
+        // Базовый случай - достигнута максимальная глубина
+        if (depth == size_t(Max_depth)) {
+            ++stats.leaves;
+            return eval_noise > 0 ? noisy_score(leaf_score<Bot>(mtx)) : leaf_score<Bot>(mtx);
+        }
+
+        // Таблица транспозиций: позиции в начале хода (не в середине серии взятий)
+        const bool use_table = tt && x == -1;
+        const uint64_t key = use_table ? table_key<Bot>() : 0;
+        const int draft = int(Max_depth - depth);
+        const double alpha0 = alpha, beta0 = beta;
+        move_pos hash_turn;
+        tt_entry entry;
+        if (use_table && tt->probe(key, entry)) {
+            ++stats.tt_hits;
+            hash_turn = entry.turn;
+            // Границы годятся только для обычного окна: при alpha >= beta родитель ждет точную оценку
+            if (entry.draft >= draft && (entry.bound == tt_bound::exact || (alpha < beta &&
+                ((entry.bound == tt_bound::lower && entry.score >= beta) ||
+                (entry.bound == tt_bound::upper && entry.score <= alpha)))))
+                return entry.score;
         }
 
-        //   
-        if (x != -1) find_turns(x, y, mtx);
-        else find_turns(color, mtx);
+        // Поиск возможных ходов
+        if (x != -1) find_piece_turns<Color>(x, y, mtx, captured);
+        else find_side_turns<Color>(mtx);
 
         auto current_turns = turns;
         bool has_captures = have_beats;
+        ++stats.expanded;
+        stats.generated += current_turns.size();
 
-        //  ,   
+        // Обработка случая, когда нет взятий
         if (!has_captures && x != -1) {
-            return find_best_turns_rec(mtx, !color, depth + 1, alpha, beta);
+            return finish_turn<!Color, Bot>(mtx, depth + 1, alpha, beta, false);
         }
 
-        //    -  
-        if (turns.empty()) return (depth % 2 ? 0 : INF);
+        // Если нет ходов - терминальное состояние
+        if (turns.empty()) return (Color == Bot ? 0 : INF);
+
+        // Лучший ход из таблицы проверяется первым
+        if (hash_turn.x != -1) {
+            auto it = find_if(current_turns.begin(), current_turns.end(), [&hash_turn](const move_pos &turn) {
+                return turn.x == hash_turn.x && turn.y == hash_turn.y && turn.x2 == hash_turn.x2 &&
+                    turn.y2 == hash_turn.y2;
+            });
+            if (it != current_turns.end()) rotate(current_turns.begin(), it, it + 1);
+        }
 
-        //    
+        // Основной цикл оценки ходов
         double min_score = INF + 1;
         double max_score = -1;
+        move_pos best_turn;
 
         for (auto& turn : current_turns) {
             double score;
+            const uint64_t saved_hash = cur_hash;
+            const material_state saved_pieces = cur_material;
+            cur_hash ^= turn_hash(mtx, turn) ^ (x == -1 ? zobrist.black_turn : 0);
+            update_material<Color>(mtx, turn);
 
+            ++ply;
             if (!has_captures && x == -1) {
-                score = find_best_turns_rec(make_turn(mtx, turn), !color,
-                    depth + 1, alpha, beta);
+                score = finish_turn<!Color, Bot>(make_turn<Color>(mtx, turn),
+                    depth + 1, alpha, beta, mtx[turn.x][turn.y] > 2);
             }
             else {
-                score = find_best_turns_rec(make_turn(mtx, turn), color, depth,
-                    alpha, beta, turn.x2, turn.y2);
+                score = find_best_turns_rec<Color, Bot>(make_turn<Color>(mtx, turn), depth,
+                    alpha, beta, turn.x2, turn.y2, captured | cell_bit(turn.xb, turn.yb));
+            }
+            --ply;
+            cur_hash = saved_hash;
+            cur_material = saved_pieces;
+            if (aborted) return 0;
+
+            // Продолжение главного варианта
+            if (Color == Bot ? score > max_score : score < min_score) {
+                pv.update(ply, turn);
+                best_turn = turn;
             }
 
-            //  
+            // Обновление оценок
             min_score = min(min_score, score);
             max_score = max(max_score, score);
 
-            // - 
-            if (depth % 2) alpha = max(alpha, max_score);
+            // Альфа-бета отсечение
+            if (Color == Bot) alpha = max(alpha, max_score);
             else beta = min(beta, min_score);
 
-            if (optimization != "O0" && alpha == beta) {
-                return (depth % 2 ? max_score + 1 : min_score - 1);
+            if (optimization != Optimization::O0 && alpha == beta) {
+                ++stats.cutoffs;
+                if (use_table && alpha0 < beta0) {
+                    tt->store(key, draft, Color == Bot ? tt_bound::lower : tt_bound::upper,
+                        Color == Bot ? max_score : min_score, best_turn);
+                }
+                return (Color == Bot ? max_score + 1 : min_score - 1);
             }
         }
 
-        return (depth % 2 ? max_score : min_score);
+        if (use_table) store_result(key, draft, alpha0, beta0, Color == Bot ? max_score : min_score, best_turn);
+        return (Color == Bot ? max_score : min_score);
+    }
+
+    /**
+     * Завершает ход и продолжает поиск за соперника.
+     * Позиция после хода проверяется на ничью по повторению и по правилу ходов без прогресса
+     * @param mtx состояние доски после хода (Color - игрок, который ходит следующим)
+     * @param reversible true - ход дамкой без взятия
+     * @return оценка позиции
+     */
+    template <bool Color, bool Bot>
+    double finish_turn(const vector<vector<POS_T>> &mtx,
+        const size_t depth, double alpha, double beta, const bool reversible) {
+        const size_t saved_base = rep_base;
+        const bool saved_material = endgame_material;
+        if (!reversible) {
+            rep_base = rep_stack.size();
+            endgame_material = true;
+        }
+        rep_stack.push_back(cur_hash);
+
+        double score;
+        if (reversible && is_search_draw()) {
+            score = DRAW_SCORE;
+            pv.clear(ply);
+        }
+        else score = find_best_turns_rec<Color, Bot>(mtx, depth, alpha, beta);
+
+        rep_stack.pop_back();
+        rep_base = saved_base;
+        endgame_material = saved_material;
+        return score;
+    }
+
+    /**
+     * Проверяет, ничейна ли текущая позиция поиска.
+     * В поиске ничьей считается уже первое повторение позиции
+     */
+    bool is_search_draw() const {
+        TRACE_SAMPLED_SCOPE("repetition_probe");
+        const size_t reversible = rep_stack.size() - 1 - rep_base;
+        if (no_progress_turns && reversible >= no_progress_turns) return true;
+        for (size_t back = 2; back <= reversible; back += 2) {
+            if (rep_stack[rep_stack.size() - 1 - back] == rep_stack.back()) return true;
+        }
+        return false;
     }
 
 public:
  /*
-        
- @param color  ,    
+  Находит все возможные ходы для фигур указанного цвета на заданной доске
+  @param color цвет фигур
+  @param mtx состояние доски
  */
-    void find_turns(const bool color)
+    void find_turns(const bool color, const vector<vector<POS_T>> &mtx)
     {
-        find_turns(color, board->get_board());
+        if (color)
+            find_side_turns<true>(mtx);
+        else
+            find_side_turns<false>(mtx);
     }
 
- /*
-         
- @param x  X 
- @param y  Y 
- */
-    void find_turns(const POS_T x, const POS_T y)
+    /*
+      Находит все возможные ходы для фигуры в указанной позиции на заданной доске
+      @param x координата X фигуры
+      @param y координата Y фигуры
+      @param mtx состояние доски
+      @param captured клетки фигур, уже взятых в текущей серии (см. cell_bit)
+     */
+    void find_turns(const POS_T x, const POS_T y, const vector<vector<POS_T>> &mtx, const uint64_t captured = 0)
     {
-        find_turns(x, y, board->get_board());
+        if (mtx[x][y] % 2)
+            find_piece_turns<false>(x, y, mtx, captured);
+        else
+            find_piece_turns<true>(x, y, mtx, captured);
+    }
+
+    // Все ходы стороны color в виде полных серий взятий
+    vector<vector<move_pos>> turn_chains(const bool color, const vector<vector<POS_T>> &mtx)
+    {
+        find_turns(color, mtx);
+        vector<vector<move_pos>> res;
+        vector<move_pos> chain;
+        if (color)
+            add_turn_chains<true>(mtx, chain, res);
+        else
+            add_turn_chains<false>(mtx, chain, res);
+        return res;
+    }
+
+    // Занятые клетки доски (бит x * board_size + y)
+    static uint64_t occupancy(const vector<vector<POS_T>> &mtx)
+    {
+        uint64_t occ = 0;
+        for (POS_T i = 0; i < board_size; ++i)
+        {
+            for (POS_T j = 1 - i % 2; j < board_size; j += 2)
+                occ |= uint64_t(mtx[i][j] != 0) << (i * board_size + j);
+        }
+        return occ;
+    }
+
+    // Бит клетки (x, y) в битовых досках
+    static uint64_t cell_bit(const POS_T x, const POS_T y)
+    {
+        return uint64_t(1) << (x * board_size + y);
     }
 
 private:
- /*
-            
-  @param color  
-  @param mtx  
- */
-    void find_turns(const bool color, const vector<vector<POS_T>> &mtx)
+    // Ходы всех фигур стороны Color
+    template <bool Color> void find_side_turns(const vector<vector<POS_T>> &mtx)
     {
+        TRACE_SAMPLED_SCOPE("generate");
         vector<move_pos> res_turns;
         bool have_beats_before = false;
-        for (POS_T i = 0; i < 8; ++i)
+        const uint64_t occ = occupancy(mtx);
+        for (POS_T i = 0; i < board_size; ++i)
         {
-            for (POS_T j = 0; j < 8; ++j)
+            for (POS_T j = 0; j < board_size; ++j)
             {
-                if (mtx[i][j] && mtx[i][j] % 2 != color)
+                if (side<Color>::is_own(mtx[i][j]))
                 {
-                    find_turns(i, j, mtx);
+                    find_piece_turns<Color>(i, j, mtx, occ, 0);
                     if (have_beats && !have_beats_before)
                     {
                         have_beats_before = true;
@@ -199,127 +1079,197 @@ private:
             }
         }
         turns = res_turns;
-        shuffle(turns.begin(), turns.end(), rand_eng);
+        // Без случайности порядок ходов фиксирован и не зависит от предыдущих поисков
+        if (!settings->no_random)
+            shuffle(turns.begin(), turns.end(), rand_eng);
         have_beats = have_beats_before;
     }
 
-    /*
-                 
-      @param x  X 
-      @param y  Y 
-      @param mtx  
-     */
-    void find_turns(const POS_T x, const POS_T y, const vector<vector<POS_T>> &mtx)
+    // Ходы фигуры стороны Color с клетки (x, y); занятость доски считается только для дамки.
+    // captured - клетки фигур, уже взятых в серии: make_turn снимает их сразу, но по правилам
+    // они остаются на доске до конца хода и закрывают путь
+    template <bool Color>
+    void find_piece_turns(const POS_T x, const POS_T y, const vector<vector<POS_T>> &mtx, const uint64_t captured = 0)
+    {
+        find_piece_turns<Color>(x, y, mtx, mtx[x][y] == side<Color>::king ? occupancy(mtx) | captured : 0, captured);
+    }
+
+    // Ходы фигуры стороны Color с клетки (x, y); occ - занятые клетки вместе с captured (нужны только для дамки)
+    template <bool Color>
+    void find_piece_turns(const POS_T x, const POS_T y, const vector<vector<POS_T>> &mtx, const uint64_t occ,
+        const uint64_t captured)
     {
         turns.clear();
         have_beats = false;
-        POS_T type = mtx[x][y];
-        // check beats
-        switch (type)
+        if (mtx[x][y] == side<Color>::man)
         {
-        case 1:
-        case 2:
-            // check pieces
+            // check beats
             for (POS_T i = x - 2; i <= x + 2; i += 4)
             {
                 for (POS_T j = y - 2; j <= y + 2; j += 4)
                 {
-                    if (i < 0 || i > 7 || j < 0 || j > 7)
+                    if (i < 0 || i >= board_size || j < 0 || j >= board_size)
                         continue;
                     POS_T xb = (x + i) / 2, yb = (y + j) / 2;
-                    if (mtx[i][j] || !mtx[xb][yb] || mtx[xb][yb] % 2 == type % 2)
+                    if (mtx[i][j] || (captured & cell_bit(i, j)) || !side<Color>::is_enemy(mtx[xb][yb]))
                         continue;
                     turns.emplace_back(x, y, i, j, xb, yb);
                 }
             }
-            break;
-        default:
-            // check queens
-            for (POS_T i = -1; i <= 1; i += 2)
+            if (!turns.empty())
+            {
+                have_beats = true;
+                return;
+            }
+            // check other turns
+            const POS_T i = x + side<Color>::forward;
+            if (i < 0 || i >= board_size)
+                return;
+            for (POS_T j = y - 1; j <= y + 1; j += 2)
+            {
+                if (j < 0 || j >= board_size || mtx[i][j])
+                    continue;
+                turns.emplace_back(x, y, i, j);
+            }
+            return;
+        }
+        // check queens: первая фигура на каждом луче должна быть чужой (взятая в серии закрывает луч),
+        // поля для остановки - пустые клетки за ней до следующей фигуры; если с части из них
+        // взятие продолжается, остановиться можно только на них
+        for (int d = 0; d < 4; ++d)
+        {
+            const uint64_t blockers = occ & rays.ray[x * board_size + y][d];
+            if (!blockers)
+                continue;
+            const int b = first_on_ray(d, blockers);
+            const POS_T xb = POS_T(b / board_size), yb = POS_T(b % board_size);
+            if (!side<Color>::is_enemy(mtx[xb][yb]))
+                continue;
+            uint64_t cells = king_attacks(b, occ) & rays.ray[b][d] & ~occ;
+            if (cells & (cells - 1))
             {
-                for (POS_T j = -1; j <= 1; j += 2)
+                const uint64_t after = occ & ~cell_bit(x, y);
+                uint64_t continuing = 0;
+                for (uint64_t rest = cells; rest; rest &= rest - 1)
                 {
-                    POS_T xb = -1, yb = -1;
-                    for (POS_T i2 = x + i, j2 = y + j; i2 != 8 && j2 != 8 && i2 != -1 && j2 != -1; i2 += i, j2 += j)
-                    {
-                        if (mtx[i2][j2])
-                        {
-                            if (mtx[i2][j2] % 2 == type % 2 || (mtx[i2][j2] % 2 != type % 2 && xb != -1))
-                            {
-                                break;
-                            }
-                            xb = i2;
-                            yb = j2;
-                        }
-                        if (xb != -1 && xb != i2)
-                        {
-                            turns.emplace_back(x, y, i2, j2, xb, yb);
-                        }
-                    }
+                    const int sq = lowest_bit(rest);
+                    if (king_can_capture<Color>(sq, mtx, after, captured | (uint64_t(1) << b)))
+                        continuing |= uint64_t(1) << sq;
                 }
+                if (continuing)
+                    cells = continuing;
             }
-            break;
+            add_ray_turns(x, y, d, cells, xb, yb);
         }
-        // check other turns
         if (!turns.empty())
         {
             have_beats = true;
             return;
         }
-        switch (type)
+        const uint64_t free_cells = king_attacks(x * board_size + y, occ) & ~occ;
+        for (int d = 0; d < 4; ++d)
+            add_ray_turns(x, y, d, free_cells & rays.ray[x * board_size + y][d], -1, -1);
+    }
+
+    // Может ли дамка стороны Color с клетки sq продолжить взятие; occ - занятые клетки,
+    // captured - клетки взятых в серии фигур (их нельзя брать повторно)
+    template <bool Color>
+    bool king_can_capture(const int sq, const vector<vector<POS_T>> &mtx, const uint64_t occ, const uint64_t captured) const
+    {
+        for (int d = 0; d < 4; ++d)
         {
-        case 1:
-        case 2:
-            // check pieces
-            {
-                POS_T i = ((type % 2) ? x - 1 : x + 1);
-                for (POS_T j = y - 1; j <= y + 1; j += 2)
-                {
-                    if (i < 0 || i > 7 || j < 0 || j > 7 || mtx[i][j])
-                        continue;
-                    turns.emplace_back(x, y, i, j);
-                }
-                break;
-            }
-        default:
-            // check queens
-            for (POS_T i = -1; i <= 1; i += 2)
-            {
-                for (POS_T j = -1; j <= 1; j += 2)
-                {
-                    for (POS_T i2 = x + i, j2 = y + j; i2 != 8 && j2 != 8 && i2 != -1 && j2 != -1; i2 += i, j2 += j)
-                    {
-                        if (mtx[i2][j2])
-                            break;
-                        turns.emplace_back(x, y, i2, j2);
-                    }
-                }
-            }
-            break;
+            const uint64_t blockers = occ & rays.ray[sq][d];
+            if (!blockers)
+                continue;
+            const int b = first_on_ray(d, blockers);
+            if ((captured >> b & 1) || !side<Color>::is_enemy(mtx[b / board_size][b % board_size]))
+                continue;
+            if (king_attacks(b, occ) & rays.ray[b][d] & ~occ)
+                return true;
+        }
+        return false;
+    }
+
+    // Ходы с клетки (x, y) на клетки cells луча d в порядке удаления от начальной клетки
+    void add_ray_turns(const POS_T x, const POS_T y, const int d, uint64_t cells, const POS_T xb, const POS_T yb)
+    {
+        while (cells)
+        {
+            const int sq = first_on_ray(d, cells);
+            cells ^= uint64_t(1) << sq;
+            turns.emplace_back(x, y, POS_T(sq / board_size), POS_T(sq % board_size), xb, yb);
         }
     }
 
   public:
-    //   
+    // Список возможных ходов
     vector<move_pos> turns;
-    // ,       
+    // Флаг, указывающий есть ли взятия в списке ходов
     bool have_beats;
-    //      
+    // Максимальная глубина рекурсии при поиске ходов
     int Max_depth;
+    // Шум оценки листьев (уровни с бюджетом позиций, Levels.h), 0 - оценка без шума
+    double eval_noise = 0;
+    // Счетчики последнего поиска лучшего хода
+    search_stats stats;
+    // Публикация хода поиска для отображения (nullptr - отключена)
+    search_progress *progress = nullptr;
 
   private:
-    //      
+    // Генератор случайных чисел для перемешивания ходов
     default_random_engine rand_eng;
-    //    ("NumberAndPotential"  )
-    string scoring_mode;
-    //   ("O0"  )
-    string optimization;
-    //        
-    vector<move_pos> next_move;
-    //     
-    vector<int> next_best_state;
-    //    
-    Board *board;
-    //    
+    // Снимок настроек, с которыми идет текущий поиск
+    shared_ptr<const Settings> settings;
+    // Режим подсчета очков
+    ScoringType scoring_mode = ScoringType::NumberAndPotential;
+    // Уровень оптимизации
+    Optimization optimization;
+    // Число ходов без взятий и ходов простыми, после которого объявляется ничья (0 - не ограничено)
+    size_t no_progress_turns;
+    // Хеши позиций на пути поиска после последнего необратимого хода партии
+    vector<uint64_t> rep_stack;
+    // Индекс в rep_stack позиции после последнего необратимого хода
+    size_t rep_base = 0;
+    // Хеш текущей позиции поиска
+    uint64_t cur_hash = 0;
+    // Материал текущей позиции поиска: обновляется вместе с cur_hash, чтобы оценка листа не обходила доску
+    material_state cur_material;
+    // Главные варианты из каждой позиции текущего пути поиска
+    PvTable pv;
+    // Таблица транспозиций (nullptr - отключена)
+    shared_ptr<TransTable> tt;
+    // Добавки к ключу таблицы: бот играет черными, оценка только по числу шашек, оценка со структурой простых
+    static constexpr uint64_t tt_bot_key = 0x9e3779b97f4a7c15ULL;
+    static constexpr uint64_t tt_scoring_key = 0xc2b2ae3d27d4eb4fULL;
+    static constexpr uint64_t tt_structure_key = 0x165667b19e3779f9ULL;
+    // Кэш оценки простых (NumberAndPotential и NumberAndStructure) и его использование
+    mutable EvalCache eval_cache;
+    bool use_eval_cache = true;
+    // Распознаватели эндшпиля (Endgame.h) в переборе
+    bool use_endgame = true;
+    // Материал текущей позиции поиска может быть распознан (false - проверен, оценщика для него нет)
+    bool endgame_material = true;
+    // Счетчики кэша оценки в начале текущего поиска
+    uint64_t eval_hits_base = 0;
+    uint64_t eval_misses_base = 0;
+    // Кэш анализа позиций на диске (nullptr - отключен)
+    shared_ptr<AnalysisCache> cache;
+    // Число ходов (прыжков) от корня до текущей позиции поиска
+    size_t ply = 0;
+    // Главный вариант последнего завершенного поиска
+    vector<move_pos> line;
+    // Указатель на объект конфигурации (nullptr - настройки фиксированы)
     Config *config;
+    // Ограничения текущего поиска (nullptr - поиск на фиксированную глубину)
+    const search_limits *limits = nullptr;
+    // Бюджет позиций текущего поиска (0 - не ограничен), соблюдается точно
+    uint64_t node_budget = 0;
+    // Добавка к хешу позиции для шума оценки (своя у каждого поиска без NoRandom)
+    uint64_t noise_seed = 0;
+    // Можно ли прерывать текущий уровень поиска
+    bool can_abort = false;
+    // Поиск прерван по ограничению
+    bool aborted = false;
+    // Время начала поиска
+    chrono::steady_clock::time_point start_time;
 };
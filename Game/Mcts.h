@@ -0,0 +1,470 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <ctime>
+#include <memory>
+#include <new>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "../Models/Move.h"
+#include "../Models/Search_stats.h"
+#include "../Models/Settings.h"
+#include "History.h"
+#include "Logic.h"
+
+// Линейный распределитель памяти: выделение - атомарный сдвиг указателя,
+// освобождается только вся память сразу (reset). Безопасен для нескольких потоков
+class Arena
+{
+  public:
+    explicit Arena(const size_t bytes) : memory(new unsigned char[bytes]), capacity(bytes)
+    {
+    }
+
+    // Память под count объектов T, nullptr - память закончилась
+    template <class T> T *allocate(const size_t count)
+    {
+        static_assert(alignof(T) <= alignment, "Arena alignment is too small");
+        const size_t size = (count * sizeof(T) + alignment - 1) & ~(alignment - 1);
+        const size_t offset = used.fetch_add(size, memory_order_relaxed);
+        if (offset + size > capacity)
+            return nullptr;
+        T *res = reinterpret_cast<T *>(memory.get() + offset);
+        for (size_t i = 0; i < count; ++i)
+            new (res + i) T();
+        return res;
+    }
+
+    // Освобождение всей памяти (объекты должны не требовать деструктора)
+    void reset()
+    {
+        used.store(0, memory_order_relaxed);
+    }
+
+    size_t bytes_used() const
+    {
+        return min(used.load(memory_order_relaxed), capacity);
+    }
+
+  private:
+    static constexpr size_t alignment = 16;
+
+    unique_ptr<unsigned char[]> memory;
+    size_t capacity;
+    atomic<size_t> used{0};
+};
+
+// Узел дерева Монте-Карло. Результаты хранятся с точки зрения игрока, сделавшего ход в узел
+struct mcts_node
+{
+    static constexpr uint8_t unexpanded = 0; // ходы еще не найдены
+    static constexpr uint8_t expanding = 1;  // ходы ищет другой поток
+    static constexpr uint8_t expanded = 2;   // потомки созданы (0 потомков - ходов нет)
+    static constexpr uint8_t leaf_only = 3;  // не хватило памяти, узел остается листом
+
+    atomic<uint32_t> visits{0};
+    atomic<uint32_t> virtual_loss{0}; // потоки, которые сейчас проходят через узел
+    atomic<uint64_t> value{0};        // сумма результатов в единицах 1 / value_scale
+    atomic<uint8_t> state{unexpanded};
+    uint8_t turn_length = 0;          // число прыжков хода в узел
+    uint16_t child_count = 0;
+    float prior = 1;                  // априорная вероятность хода (для PUCT)
+    const move_pos *turn = nullptr;   // ход, ведущий в узел
+    mcts_node *children = nullptr;
+};
+
+/**
+ * Поиск по дереву Монте-Карло (UCT или PUCT) - альтернатива перебору Logic.
+ * Все потоки строят одно дерево; виртуальная потеря уводит потоки на разные ветви.
+ * Ход в дереве - полная серия взятий. Симуляция идет случайными ходами или ходами,
+ * лучшими по calc_score, не более RolloutTurns ходов, затем позиция оценивается calc_score
+ */
+class Mcts
+{
+  public:
+    Mcts(const Settings &settings)
+        : settings(settings), arena(size_t(settings.mcts_memory_mb) << 20), is_random(!settings.no_random)
+    {
+        // Порядок ходов в генераторе не перемешивается: случайность - в выборе ходов симуляции
+        this->settings.no_random = true;
+    }
+
+    // Ход бота с ограничениями из настроек (Mcts.TimeMS, Mcts.Playouts)
+    vector<move_pos> find_best_turns(const vector<vector<POS_T>> &mtx, const History &history, const bool color)
+    {
+        return search(mtx, history, color, search_limits());
+    }
+
+    /**
+     * Поиск хода. Ограничения limits (время, число симуляций в поле nodes, флаг остановки)
+     * заменяют ограничения из настроек; глубина не используется
+     * @return ход бота (серия взятий целиком), пустой вектор - ходов нет
+     */
+    vector<move_pos> search(const vector<vector<POS_T>> &mtx, const History &history, const bool color,
+                            const search_limits &limits)
+    {
+        start_time = chrono::steady_clock::now();
+        stats = search_stats();
+        line.clear();
+        arena.reset();
+        root_mtx = mtx;
+        root_color = color;
+        root_reversible = history.reversible_turns();
+        time_ms = limits.time_ms > 0 ? limits.time_ms : limits.nodes ? 0 : settings.mcts_time_ms;
+        max_playouts = limits.nodes ? limits.nodes : limits.time_ms > 0 ? 0 : settings.mcts_playouts;
+        stop = limits.stop;
+        playouts = 0;
+        positions = 0;
+        expanded = 0;
+        generated = 0;
+        max_depth = 0;
+
+        Logic logic(settings);
+        root = arena.allocate<mcts_node>(1);
+        if (root)
+        {
+            root->state = mcts_node::expanding;
+            expand(root, logic, root_mtx, root_color);
+        }
+        if (!root || root->state != mcts_node::expanded)
+            throw runtime_error("Mcts.MemoryMB is too small for the root position");
+        if (root->child_count == 0)
+            return finish();
+        // Единственный ход делается без поиска
+        if (root->child_count > 1)
+        {
+            vector<thread> workers;
+            for (unsigned int i = 1; i < settings.mcts_threads; ++i)
+                workers.emplace_back(&Mcts::work, this, i);
+            work(0);
+            for (auto &worker : workers)
+                worker.join();
+        }
+        return finish();
+    }
+
+    // Главный вариант: ходы по наиболее посещаемым узлам (каждый прыжок - отдельный элемент)
+    const vector<move_pos> &principal_variation() const
+    {
+        return line;
+    }
+
+    // Число симуляций последнего поиска
+    uint64_t playout_count() const
+    {
+        return playouts.load(memory_order_relaxed);
+    }
+
+    // Счетчики последнего поиска: nodes - все позиции (в дереве и в симуляциях), leaves - симуляции
+    search_stats stats;
+    // Публикация хода поиска для отображения (nullptr - отключена)
+    search_progress *progress = nullptr;
+
+  private:
+    static constexpr double value_scale = 1 << 16;
+    // Температура априорных вероятностей PUCT: вероятность хода пропорциональна score^(1/T)
+    static constexpr double prior_temperature = 0.05;
+    // Доля случайных ходов в симуляциях по calc_score
+    static constexpr double rollout_epsilon = 0.1;
+
+    // Цикл симуляций одного потока
+    void work(const unsigned int index)
+    {
+        Logic logic(settings);
+        mt19937 rng(settings.mcts_threads * 7919u + index + (is_random ? unsigned(time(0)) : 0));
+        vector<mcts_node *> path;
+        uint64_t local_positions = 0;
+        while (!limit_reached())
+        {
+            playout(logic, rng, path, local_positions);
+            const uint64_t done = playouts.fetch_add(1, memory_order_relaxed) + 1;
+            if (index == 0 && progress && !(done & 255))
+            {
+                progress->nodes.store(positions.load(memory_order_relaxed) + local_positions, memory_order_relaxed);
+                progress->depth.store(max_depth.load(memory_order_relaxed), memory_order_relaxed);
+                progress->set_pv(best_child(root) ? turn_of(best_child(root)) : vector<move_pos>());
+            }
+        }
+        positions.fetch_add(local_positions, memory_order_relaxed);
+    }
+
+    bool limit_reached() const
+    {
+        if (stop && stop->load(memory_order_relaxed))
+            return true;
+        if (max_playouts && playouts.load(memory_order_relaxed) >= max_playouts)
+            return true;
+        return time_ms > 0 &&
+               chrono::duration<double, milli>(chrono::steady_clock::now() - start_time).count() >= time_ms;
+    }
+
+    /**
+     * Одна симуляция: спуск по дереву, расширение, симуляция и обновление результатов
+     * @param path узлы пути (буфер потока)
+     */
+    void playout(Logic &logic, mt19937 &rng, vector<mcts_node *> &path, uint64_t &local_positions)
+    {
+        vector<vector<POS_T>> mtx = root_mtx;
+        bool color = root_color; // сторона, которая ходит в позиции узла
+        size_t reversible = root_reversible;
+        mcts_node *node = root;
+        path.clear();
+        path.push_back(node);
+        // Результат для игрока, сделавшего ход в последний узел пути (-1 - нужна симуляция)
+        double result = -1;
+        while (true)
+        {
+            if (settings.no_progress_turns && reversible >= settings.no_progress_turns)
+            {
+                result = 0.5;
+                break;
+            }
+            uint8_t state = node->state.load(memory_order_acquire);
+            // Узел расширяется при втором посещении, первое - только симуляция
+            if (state == mcts_node::unexpanded && (node == root || node->visits.load(memory_order_relaxed) > 0) &&
+                node->state.compare_exchange_strong(state, mcts_node::expanding, memory_order_acq_rel))
+            {
+                expand(node, logic, mtx, color);
+                state = node->state.load(memory_order_acquire);
+            }
+            if (state != mcts_node::expanded)
+                break;
+            if (node->child_count == 0)
+            {
+                // У стороны, которая ходит, нет ходов - она проиграла
+                result = 1;
+                break;
+            }
+            mcts_node *child = select(node);
+            child->virtual_loss.fetch_add(1, memory_order_relaxed);
+            for (uint8_t i = 0; i < child->turn_length; ++i)
+            {
+                const move_pos &turn = child->turn[i];
+                reversible = turn.xb == -1 && mtx[turn.x][turn.y] > 2 ? reversible + 1 : 0;
+                mtx = logic.make_turn(move(mtx), turn);
+            }
+            color = !color;
+            node = child;
+            path.push_back(node);
+            ++local_positions;
+        }
+        if (result < 0)
+            result = 1 - rollout(logic, rng, mtx, color, reversible, local_positions);
+
+        size_t depth = path.size() - 1;
+        size_t known = max_depth.load(memory_order_relaxed);
+        while (depth > known && !max_depth.compare_exchange_weak(known, depth, memory_order_relaxed))
+        {
+        }
+        for (size_t i = path.size(); i-- > 0;)
+        {
+            path[i]->visits.fetch_add(1, memory_order_relaxed);
+            path[i]->value.fetch_add(uint64_t(result * value_scale), memory_order_relaxed);
+            if (i > 0)
+                path[i]->virtual_loss.fetch_sub(1, memory_order_relaxed);
+            result = 1 - result;
+        }
+    }
+
+    // Выбор потомка по UCT или PUCT; виртуальные потери считаются проигрышами
+    mcts_node *select(mcts_node *node) const
+    {
+        const double parent_visits = max<double>(1, node->visits.load(memory_order_relaxed));
+        const double log_visits = log(parent_visits), sqrt_visits = sqrt(parent_visits);
+        const double c = settings.mcts_exploration;
+        mcts_node *best = node->children;
+        double best_score = -1;
+        for (uint16_t i = 0; i < node->child_count; ++i)
+        {
+            mcts_node *child = node->children + i;
+            const double n =
+                double(child->visits.load(memory_order_relaxed) + child->virtual_loss.load(memory_order_relaxed));
+            const double w = double(child->value.load(memory_order_relaxed)) / value_scale;
+            double score;
+            if (settings.mcts_policy == MctsPolicy::PUCT)
+                score = (n > 0 ? w / n : 0.5) + c * child->prior * sqrt_visits / (1 + n);
+            else
+                score = n > 0 ? w / n + c * sqrt(log_visits / n) : INF + double(child->prior);
+            if (score > best_score)
+            {
+                best_score = score;
+                best = child;
+            }
+        }
+        return best;
+    }
+
+    // Создание потомков узла (state узла - expanding)
+    void expand(mcts_node *node, Logic &logic, const vector<vector<POS_T>> &mtx, const bool color)
+    {
+        const auto chains = logic.turn_chains(color, mtx);
+        size_t moves = 0;
+        for (const auto &chain : chains)
+            moves += chain.size();
+        mcts_node *children = chains.empty() ? nullptr : arena.allocate<mcts_node>(chains.size());
+        move_pos *turns = chains.empty() ? nullptr : arena.allocate<move_pos>(moves);
+        if (!chains.empty() && (!children || !turns))
+        {
+            node->state.store(mcts_node::leaf_only, memory_order_release);
+            return;
+        }
+        vector<double> scores(chains.size(), 1);
+        if (settings.mcts_policy == MctsPolicy::PUCT)
+        {
+            for (size_t i = 0; i < chains.size(); ++i)
+            {
+                auto next = mtx;
+                for (const auto &turn : chains[i])
+                    next = logic.make_turn(move(next), turn);
+                scores[i] = min(max(logic.calc_score(next, color), 1e-3), 1e3);
+            }
+        }
+        const double best_score = chains.empty() ? 1 : *max_element(scores.begin(), scores.end());
+        double total = 0;
+        for (auto &score : scores)
+            total += score = pow(score / best_score, 1 / prior_temperature);
+        for (size_t i = 0; i < chains.size(); ++i)
+        {
+            children[i].turn = turns;
+            children[i].turn_length = uint8_t(chains[i].size());
+            children[i].prior = float(scores[i] / total);
+            turns = copy(chains[i].begin(), chains[i].end(), turns);
+        }
+        node->children = children;
+        node->child_count = uint16_t(chains.size());
+        expanded.fetch_add(1, memory_order_relaxed);
+        generated.fetch_add(chains.size(), memory_order_relaxed);
+        node->state.store(mcts_node::expanded, memory_order_release);
+    }
+
+    /**
+     * Симуляция партии из позиции mtx
+     * @return результат для стороны color: 1 - победа, 0 - поражение, иначе по calc_score
+     */
+    double rollout(Logic &logic, mt19937 &rng, vector<vector<POS_T>> mtx, bool color, size_t reversible,
+                   uint64_t &local_positions) const
+    {
+        const bool start_color = color;
+        uniform_real_distribution<double> chance(0, 1);
+        for (unsigned int t = 0; t < settings.mcts_rollout_turns; ++t)
+        {
+            if (settings.no_progress_turns && reversible >= settings.no_progress_turns)
+                return 0.5;
+            logic.find_turns(color, mtx);
+            if (logic.turns.empty())
+                return color == start_color ? 0 : 1;
+            if (settings.mcts_eval_rollouts && chance(rng) >= rollout_epsilon)
+            {
+                // Лучший по calc_score ход стороны, которая ходит
+                const auto chains = logic.turn_chains(color, mtx);
+                vector<vector<POS_T>> best_mtx;
+                double best_score = -1;
+                bool is_reversible = false;
+                for (const auto &chain : chains)
+                {
+                    auto next = mtx;
+                    for (const auto &turn : chain)
+                        next = logic.make_turn(move(next), turn);
+                    const double score = logic.calc_score(next, color);
+                    if (score > best_score)
+                    {
+                        best_score = score;
+                        best_mtx = move(next);
+                        is_reversible = chain.front().xb == -1 && mtx[chain.front().x][chain.front().y] > 2;
+                    }
+                }
+                reversible = is_reversible ? reversible + 1 : 0;
+                mtx = move(best_mtx);
+            }
+            else
+            {
+                // Случайный ход; серия взятий продолжается случайными прыжками
+                move_pos turn = logic.turns[rng() % logic.turns.size()];
+                reversible = turn.xb == -1 && mtx[turn.x][turn.y] > 2 ? reversible + 1 : 0;
+                mtx = logic.make_turn(move(mtx), turn);
+                uint64_t captured = 0;
+                while (turn.xb != -1)
+                {
+                    captured |= Logic::cell_bit(turn.xb, turn.yb);
+                    logic.find_turns(turn.x2, turn.y2, mtx, captured);
+                    if (!logic.have_beats)
+                        break;
+                    turn = logic.turns[rng() % logic.turns.size()];
+                    mtx = logic.make_turn(move(mtx), turn);
+                }
+            }
+            color = !color;
+            ++local_positions;
+        }
+        const double score = logic.calc_score(mtx, start_color);
+        return score >= INF ? 1 : score / (1 + score);
+    }
+
+    // Наиболее посещаемый потомок (nullptr - потомков нет)
+    static mcts_node *best_child(mcts_node *node)
+    {
+        if (node->state.load(memory_order_acquire) != mcts_node::expanded)
+            return nullptr;
+        mcts_node *best = nullptr;
+        for (uint16_t i = 0; i < node->child_count; ++i)
+        {
+            mcts_node *child = node->children + i;
+            if (!best || child->visits.load(memory_order_relaxed) > best->visits.load(memory_order_relaxed))
+                best = child;
+        }
+        return best;
+    }
+
+    static vector<move_pos> turn_of(const mcts_node *node)
+    {
+        return vector<move_pos>(node->turn, node->turn + node->turn_length);
+    }
+
+    // Итог поиска: ход, главный вариант и счетчики
+    vector<move_pos> finish()
+    {
+        for (mcts_node *node = best_child(root); node && node->visits.load(memory_order_relaxed) > 0;
+             node = best_child(node))
+        {
+            line.insert(line.end(), node->turn, node->turn + node->turn_length);
+        }
+        mcts_node *best = best_child(root);
+        stats.nodes = positions.load(memory_order_relaxed);
+        stats.leaves = playouts.load(memory_order_relaxed);
+        stats.expanded = expanded.load(memory_order_relaxed);
+        stats.generated = generated.load(memory_order_relaxed);
+        stats.depth = int(max_depth.load(memory_order_relaxed));
+        // Доля побед переводится в отношение сил, как у calc_score
+        const double visits = best ? double(best->visits.load(memory_order_relaxed)) : 0;
+        const double q = visits > 0 ? double(best->value.load(memory_order_relaxed)) / value_scale / visits : 0.5;
+        stats.score = q >= 1 ? INF : q / (1 - q);
+        stats.time_ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start_time).count();
+        if (progress)
+            progress->nodes.store(stats.nodes, memory_order_relaxed);
+        return best ? turn_of(best) : vector<move_pos>();
+    }
+
+    Settings settings;
+    Arena arena;
+    bool is_random; // симуляции зависят от времени запуска (без NoRandom)
+    mcts_node *root = nullptr;
+    vector<vector<POS_T>> root_mtx;
+    bool root_color = false;
+    size_t root_reversible = 0;
+    // Ограничения текущего поиска
+    double time_ms = 0;
+    uint64_t max_playouts = 0;
+    const atomic<bool> *stop = nullptr;
+    chrono::steady_clock::time_point start_time;
+    // Счетчики текущего поиска
+    atomic<uint64_t> playouts{0};
+    atomic<uint64_t> positions{0};
+    atomic<uint64_t> expanded{0};
+    atomic<uint64_t> generated{0};
+    atomic<size_t> max_depth{0};
+    // Главный вариант последнего поиска
+    vector<move_pos> line;
+};
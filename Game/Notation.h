@@ -0,0 +1,196 @@
+#pragma once
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../Models/Move.h"
+#include "History.h"
+#include "Logic.h"
+
+using namespace std;
+
+// Текстовая запись позиций и ходов.
+// Клетки записываются как в шахматах: a1 - левый нижний угол со стороны белых.
+// Позиция (FEN): "W:Wa1,c1,Kd4:Bb8,h8" - очередь хода, затем белые и черные фигуры (K - дамка).
+// Ход: "c3-d4" - ход без взятия, "c3:e5:g3" - серия взятий
+namespace notation
+{
+
+// Разбор названия клетки ("c3"), false - если клетка не черная или не существует
+inline bool parse_cell(const string &name, POS_T &x, POS_T &y)
+{
+    if (name.size() != 2)
+        return false;
+    const int col = tolower(name[0]) - 'a', row = name[1] - '1';
+    if (col < 0 || col >= board_size || row < 0 || row >= board_size)
+        return false;
+    x = POS_T(board_size - 1 - row);
+    y = POS_T(col);
+    return (x + y) % 2 == 1;
+}
+
+// Начальная расстановка
+inline vector<vector<POS_T>> start_position()
+{
+    vector<vector<POS_T>> mtx(board_size, vector<POS_T>(board_size, 0));
+    for (POS_T i = 0; i < board_size; ++i)
+    {
+        for (POS_T j = 0; j < board_size; ++j)
+        {
+            if (i < game_variant::start_rows && (i + j) % 2 == 1)
+                mtx[i][j] = 2;
+            if (i >= board_size - game_variant::start_rows && (i + j) % 2 == 1)
+                mtx[i][j] = 1;
+        }
+    }
+    return mtx;
+}
+
+// Запись позиции, color - чья очередь хода (false - белые)
+inline string to_fen(const vector<vector<POS_T>> &mtx, const bool color)
+{
+    string fen = color ? "B" : "W";
+    for (POS_T side = 0; side < 2; ++side)
+    {
+        fen += side ? ":B" : ":W";
+        bool first = true;
+        // Клетки по возрастанию: a1, c1, ..., h8
+        for (POS_T row = 0; row < board_size; ++row)
+        {
+            for (POS_T y = 0; y < board_size; ++y)
+            {
+                const POS_T x = board_size - 1 - row, type = mtx[x][y];
+                if (!type || type % 2 == side)
+                    continue;
+                if (!first)
+                    fen += ',';
+                first = false;
+                if (type > 2)
+                    fen += 'K';
+                fen += cell_name(x, y);
+            }
+        }
+    }
+    return fen;
+}
+
+// Разбор позиции, false - если запись некорректна
+inline bool parse_fen(const string &fen, vector<vector<POS_T>> &mtx, bool &color)
+{
+    vector<vector<POS_T>> res(board_size, vector<POS_T>(board_size, 0));
+    stringstream in(fen);
+    string part;
+    if (!getline(in, part, ':') || (part != "W" && part != "B"))
+        return false;
+    const bool side_to_move = part == "B";
+    while (getline(in, part, ':'))
+    {
+        if (part.empty() || (part[0] != 'W' && part[0] != 'B'))
+            return false;
+        const bool is_black = part[0] == 'B';
+        stringstream pieces(part.substr(1));
+        string piece;
+        while (getline(pieces, piece, ','))
+        {
+            if (piece.empty())
+                continue;
+            const bool is_king = piece[0] == 'K';
+            POS_T x, y;
+            if (!parse_cell(piece.substr(is_king), x, y) || res[x][y])
+                return false;
+            res[x][y] = POS_T(1 + is_black + 2 * is_king);
+        }
+    }
+    mtx = res;
+    color = side_to_move;
+    return true;
+}
+
+// Запись цепочки ходов одного игрока
+inline string chain_to_string(const vector<move_pos> &chain)
+{
+    string res;
+    for (size_t i = 0; i < chain.size(); ++i)
+    {
+        if (i == 0)
+            res += cell_name(chain[i].x, chain[i].y);
+        res += (chain[i].xb != -1 ? ':' : '-') + cell_name(chain[i].x2, chain[i].y2);
+    }
+    return res;
+}
+
+// Запись варианта: ходы сторон через пробел ("c3-d4 f6-e5 d4:f6:d8")
+inline string line_to_string(const vector<move_pos> &line)
+{
+    string res;
+    for (const auto &turn : split_turns(line))
+        res += (res.empty() ? "" : " ") + chain_to_string(turn);
+    return res;
+}
+
+/**
+ * Разбор хода игрока color в позиции mtx с проверкой по правилам.
+ * Серия взятий должна быть записана полностью
+ * @return цепочка ходов или пустой вектор, если ход некорректен
+ */
+inline vector<move_pos> parse_chain(Logic &logic, vector<vector<POS_T>> mtx, const bool color, const string &text)
+{
+    vector<POS_T> cells;
+    for (size_t i = 0; i < text.size();)
+    {
+        POS_T x, y;
+        if (!parse_cell(text.substr(i, 2), x, y))
+            return {};
+        cells.push_back(x);
+        cells.push_back(y);
+        i += 2;
+        if (i < text.size() && text[i] != '-' && text[i] != ':' && text[i] != 'x')
+            return {};
+        i += (i < text.size());
+    }
+    if (cells.size() < 4)
+        return {};
+
+    vector<move_pos> chain;
+    uint64_t captured = 0;
+    logic.find_turns(color, mtx);
+    for (size_t k = 2; k < cells.size(); k += 2)
+    {
+        bool found = false;
+        for (const auto &turn : logic.turns)
+        {
+            if (turn.x == cells[k - 2] && turn.y == cells[k - 1] && turn.x2 == cells[k] && turn.y2 == cells[k + 1])
+            {
+                chain.push_back(turn);
+                found = true;
+                break;
+            }
+        }
+        if (!found || (chain.back().xb == -1 && k + 2 < cells.size()))
+            return {};
+        if (chain.back().xb == -1)
+            break;
+        mtx = logic.make_turn(mtx, chain.back());
+        captured |= Logic::cell_bit(chain.back().xb, chain.back().yb);
+        logic.find_turns(chain.back().x2, chain.back().y2, mtx, captured);
+        if (!logic.have_beats)
+            logic.turns.clear();
+    }
+    // Незавершенная серия взятий
+    if (chain.back().xb != -1 && !logic.turns.empty())
+        return {};
+    return chain;
+}
+
+// Выполнение цепочки ходов с записью в историю
+inline void apply_chain(vector<vector<POS_T>> &mtx, History &history, const vector<move_pos> &chain)
+{
+    int beat_series = 0;
+    for (const auto &turn : chain)
+    {
+        beat_series += (turn.xb != -1);
+        history.apply(mtx, turn, beat_series);
+    }
+}
+
+} // namespace notation
@@ -0,0 +1,269 @@
+#pragma once
+#include <cctype>
+#include <ctime>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "../Models/Move.h"
+#include "History.h"
+
+using namespace std;
+
+// Запись партий в формате PDN (Portable Draughts Notation).
+// Ходы записываются так же, как в Notation.h: "c3-d4", "c3:e5:g3".
+// Результат: "2-0" - победа белых, "0-2" - победа черных, "1-1" - ничья, "*" - партия не окончена
+namespace pdn
+{
+
+// Партия: теги, ходы и комментарии к ходам
+struct game_record
+{
+    vector<pair<string, string>> tags;
+    vector<string> moves;
+    vector<string> comments; // комментарий после каждого хода (пустая строка - нет комментария)
+    string result = "*";
+
+    // Значение тега или пустая строка, если тега нет
+    string tag(const string &name) const
+    {
+        for (const auto &t : tags)
+        {
+            if (t.first == name)
+                return t.second;
+        }
+        return "";
+    }
+
+    void set_tag(const string &name, const string &value)
+    {
+        for (auto &t : tags)
+        {
+            if (t.first == name)
+            {
+                t.second = value;
+                return;
+            }
+        }
+        tags.emplace_back(name, value);
+    }
+
+    void add_move(const string &move, const string &comment = "")
+    {
+        moves.push_back(move);
+        comments.push_back(comment);
+    }
+};
+
+// Тег GameType для русских шашек
+inline const char *const game_type = "25";
+
+inline bool is_result(const string &token)
+{
+    return token == "2-0" || token == "0-2" || token == "1-1" || token == "1-0" || token == "0-1" ||
+           token == "1/2-1/2" || token == "0-0" || token == "*";
+}
+
+// Ходы партии из истории: ходы серии взятий объединяются в один ход
+inline vector<string> history_moves(const History &history)
+{
+    vector<string> moves;
+    for (size_t i = 0; i < history.size(); ++i)
+    {
+        const turn_record &rec = history[i];
+        if (rec.beat_series() <= 1)
+            moves.push_back(cell_name(rec.from / 8, rec.from % 8));
+        moves.back() += (rec.beaten != turn_record::no_cell ? ':' : '-') + cell_name(rec.to / 8, rec.to % 8);
+    }
+    return moves;
+}
+
+// Дата для тега Date
+inline string today()
+{
+    const time_t now = time(nullptr);
+    char buf[16];
+    strftime(buf, sizeof(buf), "%Y.%m.%d", localtime(&now));
+    return buf;
+}
+
+// Запись партии; строки ходов переносятся после 80 символов
+inline void write(ostream &out, const game_record &game)
+{
+    for (const auto &t : game.tags)
+    {
+        out << '[' << t.first << " \"";
+        for (char c : t.second)
+        {
+            if (c == '"' || c == '\\')
+                out << '\\';
+            out << c;
+        }
+        out << "\"]\n";
+    }
+    string line;
+    auto put = [&out, &line](const string &token) {
+        if (!line.empty() && line.size() + token.size() + 1 > 80)
+        {
+            out << line << '\n';
+            line.clear();
+        }
+        if (!line.empty())
+            line += ' ';
+        line += token;
+    };
+    // Партия может начинаться с хода черных (тег FEN)
+    const string fen = game.tag("FEN");
+    const bool black_first = !fen.empty() && fen[0] == 'B';
+    for (size_t i = 0; i < game.moves.size(); ++i)
+    {
+        const size_t ply = i + black_first;
+        if (ply % 2 == 0)
+            put(to_string(ply / 2 + 1) + ".");
+        else if (i == 0)
+            put(to_string(ply / 2 + 1) + "...");
+        put(game.moves[i]);
+        if (i < game.comments.size() && !game.comments[i].empty())
+            put("{" + game.comments[i] + "}");
+    }
+    put(game.result);
+    out << line << "\n\n";
+}
+
+// Потоковое чтение партий: в памяти находится только текущая партия,
+// поэтому размер файла не ограничен
+class Reader
+{
+  public:
+    explicit Reader(istream &in) : in(in)
+    {
+    }
+
+    // Чтение следующей партии, false - партий больше нет
+    bool next(game_record &game)
+    {
+        game = game_record();
+        bool has_content = false;
+        int c;
+        while ((c = in.peek()) != EOF)
+        {
+            if (isspace(c))
+            {
+                in.get();
+                continue;
+            }
+            if (c == '[')
+            {
+                // Теги после ходов относятся к следующей партии
+                if (!game.moves.empty())
+                    return true;
+                in.get();
+                read_tag(game);
+                has_content = true;
+            }
+            else if (c == '{')
+            {
+                in.get();
+                const string comment = read_until('}');
+                if (!game.comments.empty())
+                {
+                    string &last = game.comments.back();
+                    last += (last.empty() ? "" : " ") + comment;
+                }
+            }
+            else if (c == ';')
+                read_until('\n');
+            else if (c == '(')
+                skip_variation();
+            else
+            {
+                const string token = read_token();
+                has_content = true;
+                if (is_result(token))
+                {
+                    game.result = token;
+                    return true;
+                }
+                // Номера ходов ("12." или "12...", в том числе слитно с ходом: "1.c3-d4")
+                // и оценки ("$1", "!?") пропускаются
+                string move = token;
+                if (isdigit((unsigned char)move[0]) && move.find('.') != string::npos)
+                    move = move.substr(move.find_last_of('.') + 1);
+                move = strip_suffix(move);
+                if (move.empty() || move[0] == '$')
+                    continue;
+                game.add_move(move);
+            }
+        }
+        return has_content;
+    }
+
+  private:
+    void read_tag(game_record &game)
+    {
+        string name, value;
+        int c;
+        while ((c = in.get()) != EOF && c != '"' && c != ']')
+        {
+            if (!isspace(c))
+                name += char(c);
+        }
+        if (c == '"')
+        {
+            while ((c = in.get()) != EOF && c != '"')
+            {
+                if (c == '\\')
+                    c = in.get();
+                value += char(c);
+            }
+            read_until(']');
+        }
+        game.tags.emplace_back(name, value);
+    }
+
+    string read_until(const char end)
+    {
+        string res;
+        int c;
+        while ((c = in.get()) != EOF && c != end)
+            res += char(c);
+        return res;
+    }
+
+    string read_token()
+    {
+        string res;
+        int c;
+        while ((c = in.peek()) != EOF && !isspace(c) && c != '{' && c != '(' && c != '[' && c != ';')
+            res += char(in.get());
+        return res;
+    }
+
+    void skip_variation()
+    {
+        int depth = 0, c;
+        while ((c = in.get()) != EOF)
+        {
+            if (c == '{')
+                read_until('}');
+            else if (c == '(')
+                ++depth;
+            else if (c == ')' && --depth == 0)
+                return;
+        }
+    }
+
+    // Удаление оценок хода: "c3-d4!" -> "c3-d4"
+    static string strip_suffix(string token)
+    {
+        while (!token.empty() && (token.back() == '!' || token.back() == '?'))
+            token.pop_back();
+        return token;
+    }
+
+    istream &in;
+};
+
+} // namespace pdn
@@ -0,0 +1,80 @@
+#pragma once
+#include <algorithm>
+#include <vector>
+
+#include "../Models/Move.h"
+
+using namespace std;
+
+/**
+ * Треугольная таблица главного варианта (PV).
+ * Строка ply хранит лучшее продолжение из позиции на расстоянии ply ходов (отдельных прыжков) от корня;
+ * длина строки ply не больше max_ply - ply, поэтому вся таблица выделяется один раз
+ */
+class PvTable
+{
+  public:
+    // Наибольшая длина варианта в отдельных ходах (каждый прыжок серии взятий - отдельный ход)
+    static constexpr size_t max_ply = 128;
+
+    PvTable() : moves(max_ply * (max_ply + 1) / 2), length(max_ply + 1, 0)
+    {
+    }
+
+    // Пустое продолжение из позиции ply (лист, ничья или нет ходов)
+    void clear(const size_t ply)
+    {
+        if (ply < max_ply)
+            length[ply] = 0;
+    }
+
+    // Новый лучший ход turn в позиции ply: вариант - turn и продолжение из строки ply + 1
+    void update(const size_t ply, const move_pos &turn)
+    {
+        if (ply >= max_ply)
+            return;
+        move_pos *row = moves.data() + offset(ply);
+        row[0] = turn;
+        const size_t count = min(length[ply + 1], max_ply - ply - 1);
+        copy(row + (max_ply - ply), row + (max_ply - ply) + count, row + 1);
+        length[ply] = count + 1;
+    }
+
+    // Вариант из позиции ply
+    vector<move_pos> line(const size_t ply = 0) const
+    {
+        if (ply >= max_ply)
+            return {};
+        const move_pos *row = moves.data() + offset(ply);
+        return vector<move_pos>(row, row + length[ply]);
+    }
+
+  private:
+    // Начало строки ply: строки 0..ply-1 занимают max_ply, max_ply - 1, ... ячеек
+    static size_t offset(const size_t ply)
+    {
+        return ply * max_ply - ply * (ply - 1) / 2;
+    }
+
+    vector<move_pos> moves;
+    vector<size_t> length;
+};
+
+/**
+ * Разбиение варианта на ходы сторон: серия взятий одной фигурой - один ход.
+ * Следующий прыжок серии начинается с клетки, где закончился предыдущий;
+ * ход соперника с этой клетки начаться не может - на ней стоит фигура
+ */
+inline vector<vector<move_pos>> split_turns(const vector<move_pos> &line)
+{
+    vector<vector<move_pos>> res;
+    for (size_t i = 0; i < line.size(); ++i)
+    {
+        const bool same_turn = i > 0 && line[i].xb != -1 && line[i - 1].xb != -1 && line[i].x == line[i - 1].x2 &&
+                               line[i].y == line[i - 1].y2;
+        if (!same_turn)
+            res.emplace_back();
+        res.back().push_back(line[i]);
+    }
+    return res;
+}
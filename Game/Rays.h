@@ -0,0 +1,157 @@
+#pragma once
+#include <stdint.h>
+#include <vector>
+
+#include "Variant.h"
+#ifdef __BMI2__
+    #include <immintrin.h>
+#endif
+#ifdef _MSC_VER
+    #include <intrin.h>
+#endif
+
+using namespace std;
+
+static_assert(board_size == 8, "ray tables are built for an 8x8 board");
+
+// Диагональные лучи для ходов дамки. Клетка доски - номер x * 8 + y (как в History).
+// Направления: 0 - (-1, -1), 1 - (-1, +1), 2 - (+1, -1), 3 - (+1, +1);
+// в направлениях 0 и 1 номера клеток убывают, в 2 и 3 - возрастают
+struct diagonal_rays
+{
+    uint64_t ray[64][4];   // клетки луча без начальной клетки
+    uint64_t inner[64];    // клетки всех диагоналей без крайних (от них зависит ход дамки)
+};
+
+constexpr diagonal_rays make_diagonal_rays()
+{
+    diagonal_rays res{};
+    const int dx[4] = {-1, -1, 1, 1}, dy[4] = {-1, 1, -1, 1};
+    for (int sq = 0; sq < 64; ++sq)
+    {
+        for (int d = 0; d < 4; ++d)
+        {
+            uint64_t mask = 0;
+            for (int i = sq / 8 + dx[d], j = sq % 8 + dy[d]; i >= 0 && i < 8 && j >= 0 && j < 8; i += dx[d], j += dy[d])
+            {
+                mask |= uint64_t(1) << (i * 8 + j);
+                // Последняя клетка луча не влияет на то, куда дамка может дойти
+                const int ni = i + dx[d], nj = j + dy[d];
+                if (ni >= 0 && ni < 8 && nj >= 0 && nj < 8)
+                    res.inner[sq] |= uint64_t(1) << (i * 8 + j);
+            }
+            res.ray[sq][d] = mask;
+        }
+    }
+    return res;
+}
+
+inline constexpr diagonal_rays rays = make_diagonal_rays();
+
+// Номер младшего установленного бита (b != 0)
+inline int lowest_bit(const uint64_t b)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctzll(b);
+#elif defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward64(&index, b);
+    return int(index);
+#else
+    int index = 0;
+    while (!((b >> index) & 1))
+        ++index;
+    return index;
+#endif
+}
+
+// Номер старшего установленного бита (b != 0)
+inline int highest_bit(const uint64_t b)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return 63 - __builtin_clzll(b);
+#elif defined(_MSC_VER)
+    unsigned long index;
+    _BitScanReverse64(&index, b);
+    return int(index);
+#else
+    int index = 63;
+    while (!((b >> index) & 1))
+        --index;
+    return index;
+#endif
+}
+
+// Первая по ходу луча d клетка из cells (cells - подмножество луча, не пустое)
+inline int first_on_ray(const int d, const uint64_t cells)
+{
+    return d >= 2 ? lowest_bit(cells) : highest_bit(cells);
+}
+
+#ifdef __BMI2__
+// Таблица ходов дамки, индексируемая занятостью диагоналей через PEXT
+struct king_attack_table
+{
+    uint32_t offset[64];
+    vector<uint64_t> attacks;
+
+    king_attack_table()
+    {
+        uint32_t size = 0;
+        for (int sq = 0; sq < 64; ++sq)
+        {
+            offset[sq] = size;
+            size += uint32_t(1) << __builtin_popcountll(rays.inner[sq]);
+        }
+        attacks.resize(size);
+        for (int sq = 0; sq < 64; ++sq)
+        {
+            // Перебор всех подмножеств занятых клеток диагоналей
+            const uint64_t mask = rays.inner[sq];
+            uint64_t occ = 0;
+            do
+            {
+                attacks[offset[sq] + _pext_u64(occ, mask)] = walk(sq, occ);
+                occ = (occ - mask) & mask;
+            } while (occ);
+        }
+    }
+
+    static uint64_t walk(const int sq, const uint64_t occ)
+    {
+        uint64_t res = 0;
+        for (int d = 0; d < 4; ++d)
+        {
+            const uint64_t blockers = rays.ray[sq][d] & occ;
+            res |= blockers ? rays.ray[sq][d] & ~rays.ray[first_on_ray(d, blockers)][d] : rays.ray[sq][d];
+        }
+        return res;
+    }
+};
+
+inline const king_attack_table &king_attacks_table()
+{
+    static const king_attack_table table;
+    return table;
+}
+#endif
+
+/**
+ * Клетки, до которых дамка с клетки sq доходит по диагоналям при занятых клетках occ,
+ * включая первую занятую клетку в каждом направлении
+ */
+inline uint64_t king_attacks(const int sq, const uint64_t occ)
+{
+#ifdef __BMI2__
+    const king_attack_table &table = king_attacks_table();
+    return table.attacks[table.offset[sq] + _pext_u64(occ, rays.inner[sq])];
+#else
+    uint64_t res = 0;
+    for (int d = 0; d < 4; ++d)
+    {
+        const uint64_t blockers = rays.ray[sq][d] & occ;
+        res |= blockers ? rays.ray[sq][d] & ~rays.ray[first_on_ray(d, blockers)][d] : rays.ray[sq][d];
+    }
+    return res;
+#endif
+}
@@ -0,0 +1,379 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <string>
+
+#include "Rays.h"
+#include "Variant.h"
+
+using namespace std;
+
+/**
+ * Правила варианта V на битовых досках темных клеток.
+ * Клетка - номер темной клетки: ряд * (size / 2) + номер в ряду; ряд 0 - верхний (сторона черных),
+ * как x в матрице доски игры. Для доски 10x10 это 50 клеток, для 8x8 - 32, позиция - четыре 64-битных числа.
+ * Взятые фигуры снимаются после окончания серии (турецкий удар запрещен): их нельзя бить второй раз,
+ * и они загораживают путь. Серии с одинаковыми началом, концом и взятыми фигурами - один ход,
+ * если V::path_moves не требует различать их пути
+ */
+template <class V> class Rules
+{
+  public:
+    // Позиция: простые и дамки каждой стороны (индекс 0 - белые), color - чья очередь хода
+    struct position
+    {
+        uint64_t men[2] = {0, 0};
+        uint64_t kings[2] = {0, 0};
+        bool color = false;
+    };
+
+    // Ход: откуда, куда и взятые фигуры (серия взятий целиком)
+    struct move
+    {
+        uint8_t from = 0, to = 0;
+        uint8_t count = 0;      // число взятых фигур
+        bool promotion = false; // простая становится дамкой
+        uint64_t captured = 0;
+    };
+
+    // Ходы одной позиции без выделения памяти
+    struct move_list
+    {
+        static constexpr int capacity = 256;
+        array<move, capacity> items;
+        int size = 0;
+
+        const move *begin() const
+        {
+            return items.data();
+        }
+        const move *end() const
+        {
+            return items.data() + size;
+        }
+    };
+
+    static constexpr int squares = V::squares;
+
+    // Ряд и столбец клетки
+    static constexpr int row(const int sq)
+    {
+        return sq / V::row_squares;
+    }
+    static constexpr int col(const int sq)
+    {
+        return 2 * (sq % V::row_squares) + (row(sq) % 2 == 0);
+    }
+
+    static position start_position()
+    {
+        position pos;
+        for (int sq = 0; sq < squares; ++sq)
+        {
+            if (row(sq) < V::start_rows)
+                pos.men[1] |= bit(sq);
+            else if (row(sq) >= V::size - V::start_rows)
+                pos.men[0] |= bit(sq);
+        }
+        return pos;
+    }
+
+    // Все ходы стороны, которая ходит; при наличии взятий - только взятия (с учетом правила большинства)
+    static void generate(const position &pos, move_list &moves)
+    {
+        if (pos.color)
+            generate<true>(pos, moves);
+        else
+            generate<false>(pos, moves);
+    }
+
+    template <bool Color> static void generate(const position &pos, move_list &moves)
+    {
+        moves.size = 0;
+        const uint64_t own = pos.men[Color] | pos.kings[Color];
+        const uint64_t enemies = pos.men[!Color] | pos.kings[!Color];
+        const uint64_t occupied = own | enemies;
+        int best_count = 0;
+        for (uint64_t b = own; b; b &= b - 1)
+        {
+            const int sq = lowest_bit(b);
+            const bool is_king = (pos.kings[Color] >> sq) & 1;
+            add_captures<Color>(moves, sq, sq, is_king, !is_king, 0, 0, occupied & ~bit(sq), enemies, best_count);
+        }
+        if (moves.size)
+            return;
+        for (uint64_t b = pos.men[Color]; b; b &= b - 1)
+        {
+            const int sq = lowest_bit(b);
+            for (int d = Color ? 2 : 0; d < (Color ? 4 : 2); ++d)
+            {
+                const int to = geometry.step[d][sq];
+                if (to >= 0 && !((occupied >> to) & 1))
+                    push(moves, sq, to, 0, 0, row(to) == promotion_row(Color));
+            }
+        }
+        for (uint64_t b = pos.kings[Color]; b; b &= b - 1)
+        {
+            const int sq = lowest_bit(b);
+            for (int d = 0; d < 4; ++d)
+            {
+                for (int to = geometry.step[d][sq]; to >= 0 && !((occupied >> to) & 1); to = geometry.step[d][to])
+                {
+                    push(moves, sq, to, 0, 0, false);
+                    if (!V::flying_kings)
+                        break;
+                }
+            }
+        }
+    }
+
+    // Позиция после хода m
+    static position apply(position pos, const move &m)
+    {
+        const bool color = pos.color;
+        const uint64_t from = bit(m.from), to = bit(m.to);
+        if (pos.men[color] & from)
+        {
+            pos.men[color] &= ~from;
+            (m.promotion ? pos.kings[color] : pos.men[color]) |= to;
+        }
+        else
+            pos.kings[color] = (pos.kings[color] & ~from) | to;
+        pos.men[!color] &= ~m.captured;
+        pos.kings[!color] &= ~m.captured;
+        pos.color = !color;
+        return pos;
+    }
+
+    // Число позиций на глубине depth (проверка и замер генератора ходов)
+    static uint64_t perft(const position &pos, const int depth)
+    {
+        if (depth == 0)
+            return 1;
+        move_list moves;
+        generate(pos, moves);
+        if (depth == 1)
+            return uint64_t(moves.size);
+        uint64_t res = 0;
+        for (const move &m : moves)
+            res += perft(apply(pos, m), depth - 1);
+        return res;
+    }
+
+    /**
+     * Оценка позиции для стороны, которая ходит: разность материала (простая 100, дамка 300)
+     * и продвижения простых
+     */
+    static int evaluate(const position &pos)
+    {
+        int score[2];
+        for (int c = 0; c < 2; ++c)
+        {
+            score[c] = 100 * popcount(pos.men[c]) + 300 * popcount(pos.kings[c]);
+            for (uint64_t b = pos.men[c]; b; b &= b - 1)
+            {
+                const int r = row(lowest_bit(b));
+                score[c] += 2 * (c ? r : V::size - 1 - r);
+            }
+        }
+        return pos.color ? score[1] - score[0] : score[0] - score[1];
+    }
+
+    /**
+     * Перебор с альфа-бета отсечением (negamax) на depth ходов; серия взятий - один ход.
+     * Сторона без ходов проигрывает
+     */
+    static int search(const position &pos, const int depth, int alpha, int beta, uint64_t &nodes)
+    {
+        ++nodes;
+        if (depth == 0)
+            return evaluate(pos);
+        move_list moves;
+        generate(pos, moves);
+        if (!moves.size)
+            return -win_score;
+        int best = -win_score - 1;
+        for (const move &m : moves)
+        {
+            const int score = -search(apply(pos, m), depth - 1, -beta, -alpha, nodes);
+            if (score > best)
+            {
+                best = score;
+                alpha = max(alpha, score);
+                if (alpha >= beta)
+                    break;
+            }
+        }
+        return best;
+    }
+
+    static constexpr int win_score = 100000;
+
+    // Номер клетки в официальной нотации варианта (1 - верхняя левая темная клетка)
+    static string square_name(const int sq)
+    {
+        return to_string(sq + 1);
+    }
+
+    // Запись хода: "32-28" или "28x19" (серия взятий - начало и конец)
+    static string move_name(const move &m)
+    {
+        return square_name(m.from) + (m.count ? "x" : "-") + square_name(m.to);
+    }
+
+  private:
+    // Соседние клетки по направлениям 0 - (-1, -1), 1 - (-1, +1), 2 - (+1, -1), 3 - (+1, +1); -1 - края доски
+    struct neighbours
+    {
+        int8_t step[4][V::squares];
+    };
+
+    static constexpr neighbours make_neighbours()
+    {
+        neighbours res{};
+        const int dr[4] = {-1, -1, 1, 1}, dc[4] = {-1, 1, -1, 1};
+        for (int sq = 0; sq < V::squares; ++sq)
+        {
+            for (int d = 0; d < 4; ++d)
+            {
+                const int r = row(sq) + dr[d], c = col(sq) + dc[d];
+                res.step[d][sq] = r < 0 || r >= V::size || c < 0 || c >= V::size
+                                      ? int8_t(-1)
+                                      : int8_t(r * V::row_squares + c / 2);
+            }
+        }
+        return res;
+    }
+
+    static constexpr neighbours geometry = make_neighbours();
+
+    static constexpr uint64_t bit(const int sq)
+    {
+        return uint64_t(1) << sq;
+    }
+
+    static constexpr int promotion_row(const bool color)
+    {
+        return color ? V::size - 1 : 0;
+    }
+
+    static int popcount(const uint64_t b)
+    {
+#if defined(__GNUC__) || defined(__clang__)
+        return __builtin_popcountll(b);
+#else
+        int res = 0;
+        for (uint64_t rest = b; rest; rest &= rest - 1)
+            ++res;
+        return res;
+#endif
+    }
+
+    // Направление d ведет вперед для стороны Color
+    template <bool Color> static constexpr bool is_forward(const int d)
+    {
+        return Color ? d >= 2 : d < 2;
+    }
+
+    /**
+     * Продолжение серии взятий фигурой, стоящей на sq
+     * @param from начальная клетка серии (освобождена: occupied ее не содержит)
+     * @param king фигура бьет как дамка
+     * @param is_man серию начала простая
+     * @param captured уже взятые фигуры (остаются на доске до конца серии)
+     * @param best_count наибольшее число взятых фигур среди найденных серий (для правила большинства)
+     */
+    template <bool Color>
+    static void add_captures(move_list &moves, const int from, const int sq, const bool king, const bool is_man,
+                             const uint64_t captured, const int count, const uint64_t occupied, const uint64_t enemies,
+                             int &best_count)
+    {
+        bool extended = false;
+        for (int d = 0; d < 4; ++d)
+        {
+            if (!king && !V::backward_capture && !is_forward<Color>(d))
+                continue;
+            int target = geometry.step[d][sq];
+            if (king && V::flying_kings)
+            {
+                while (target >= 0 && !((occupied >> target) & 1))
+                    target = geometry.step[d][target];
+            }
+            if (target < 0 || !((enemies >> target) & 1) || ((captured >> target) & 1))
+                continue;
+            // Дамка обязана встать на поле, с которого взятие продолжается, если такое есть
+            // (при правиле большинства короткие серии и так отбрасываются)
+            bool must_continue = false;
+            if (king && V::flying_kings && !V::majority_capture)
+            {
+                for (int to = geometry.step[d][target]; to >= 0 && !((occupied >> to) & 1) && !must_continue;
+                     to = geometry.step[d][to])
+                    must_continue = can_capture<Color>(to, captured | bit(target), occupied, enemies);
+            }
+            for (int to = geometry.step[d][target]; to >= 0 && !((occupied >> to) & 1); to = geometry.step[d][to])
+            {
+                if (must_continue && !can_capture<Color>(to, captured | bit(target), occupied, enemies))
+                    continue;
+                extended = true;
+                const bool next_king = king || (V::promote_in_capture && row(to) == promotion_row(Color));
+                add_captures<Color>(moves, from, to, next_king, is_man, captured | bit(target), count + 1, occupied,
+                                    enemies, best_count);
+                if (!king || !V::flying_kings)
+                    break;
+            }
+        }
+        if (extended || !count)
+            return;
+        if (V::majority_capture)
+        {
+            if (count < best_count)
+                return;
+            if (count > best_count)
+            {
+                best_count = count;
+                moves.size = 0;
+            }
+        }
+        if (!V::path_moves)
+        {
+            for (const move &m : moves)
+            {
+                if (m.from == from && m.to == sq && m.captured == captured)
+                    return;
+            }
+        }
+        // Простая, ставшая дамкой посреди серии, остается дамкой
+        push(moves, from, sq, captured, count, is_man && (king || row(sq) == promotion_row(Color)));
+    }
+
+    // Дамка на клетке sq может продолжить серию взятий
+    template <bool Color>
+    static bool can_capture(const int sq, const uint64_t captured, const uint64_t occupied, const uint64_t enemies)
+    {
+        for (int d = 0; d < 4; ++d)
+        {
+            int target = geometry.step[d][sq];
+            while (target >= 0 && !((occupied >> target) & 1))
+                target = geometry.step[d][target];
+            if (target < 0 || !((enemies >> target) & 1) || ((captured >> target) & 1))
+                continue;
+            const int to = geometry.step[d][target];
+            if (to >= 0 && !((occupied >> to) & 1))
+                return true;
+        }
+        return false;
+    }
+
+    static void push(move_list &moves, const int from, const int to, const uint64_t captured, const int count,
+                     const bool promotion)
+    {
+        if (moves.size == move_list::capacity)
+            return;
+        move &m = moves.items[moves.size++];
+        m.from = uint8_t(from);
+        m.to = uint8_t(to);
+        m.count = uint8_t(count);
+        m.promotion = promotion;
+        m.captured = captured;
+    }
+};
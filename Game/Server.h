@@ -0,0 +1,414 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "../Models/Settings.h"
+#include "History.h"
+#include "Levels.h"
+#include "Logic.h"
+#include "Notation.h"
+
+// Соединение с клиентом сервера
+struct Connection
+{
+    int fd = -1;
+    mutex write_mutex;
+
+    // Отправка строки ответа целиком
+    void send(const string &line)
+    {
+        const string data = line + '\n';
+        lock_guard<mutex> lock(write_mutex);
+        size_t sent = 0;
+        while (sent < data.size())
+        {
+            const ssize_t n = ::send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+            if (n <= 0)
+                return;
+            sent += size_t(n);
+        }
+    }
+};
+
+// Партия на сервере: позиция и компактная история ходов
+struct Session
+{
+    uint64_t id = 0;
+    vector<vector<POS_T>> mtx;
+    bool color = false;                // очередь хода (false - белые)
+    History history;                   // журнал ходов (для отмены и поиска повторений)
+    vector<size_t> turn_starts;        // индекс в истории начала каждого хода
+    int level = 5;                     // уровень бота
+    double budget_ms = 0;              // время на ход бота, 0 - без ограничения
+    uint64_t nodes = 0;                // позиций на ход бота (глубина не ограничена), 0 - поиск на глубину level
+    double noise = 0;                  // шум оценки бота (уровни с бюджетом позиций)
+    bool is_busy = false;              // бот ищет ход в этой партии
+    deque<shared_ptr<Connection>> requests; // очередь запросов хода бота
+    mutex session_mutex;
+};
+
+// Локальный сервер партий: много партий в одном процессе и общий пул потоков поиска.
+// Запросы ходов бота разных партий обслуживаются по очереди (round robin),
+// у каждой партии свой бюджет времени на ход. Команды описаны в README
+class Server
+{
+  public:
+    Server(const Settings &settings, const int threads, const int default_level, const double default_budget_ms)
+        : settings(settings), default_level(default_level), default_budget_ms(default_budget_ms)
+    {
+        for (int i = 0; i < max(1, threads); ++i)
+            workers.emplace_back(&Server::worker_loop, this);
+    }
+
+    ~Server()
+    {
+        {
+            lock_guard<mutex> lock(queue_mutex);
+            is_stopping = true;
+        }
+        queue_cv.notify_all();
+        for (auto &worker : workers)
+            worker.join();
+    }
+
+    // Прием соединений на Unix-сокете path
+    int listen_unix(const string &path)
+    {
+        const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        if (fd < 0 || path.size() >= sizeof(addr.sun_path))
+            return print_error("can't create unix socket " + path);
+        path.copy(addr.sun_path, path.size());
+        unlink(path.c_str());
+        if (bind(fd, (sockaddr *)&addr, sizeof(addr)) || listen(fd, 128))
+            return print_error("can't listen on " + path);
+        return accept_loop(fd);
+    }
+
+    // Прием соединений на 127.0.0.1:port
+    int listen_tcp(const int port)
+    {
+        const int fd = socket(AF_INET, SOCK_STREAM, 0);
+        if (fd < 0)
+            return print_error("can't create tcp socket");
+        const int on = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(uint16_t(port));
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (bind(fd, (sockaddr *)&addr, sizeof(addr)) || listen(fd, 128))
+            return print_error("can't listen on port " + to_string(port));
+        return accept_loop(fd);
+    }
+
+  private:
+    int accept_loop(const int listen_fd)
+    {
+        while (true)
+        {
+            const int fd = accept(listen_fd, nullptr, nullptr);
+            if (fd < 0)
+                continue;
+            auto conn = make_shared<Connection>();
+            conn->fd = fd;
+            thread(&Server::client_loop, this, conn).detach();
+        }
+    }
+
+    // Чтение команд клиента построчно
+    void client_loop(shared_ptr<Connection> conn)
+    {
+        string buffer;
+        char chunk[4096];
+        ssize_t n;
+        while ((n = recv(conn->fd, chunk, sizeof(chunk), 0)) > 0)
+        {
+            buffer.append(chunk, size_t(n));
+            size_t end;
+            while ((end = buffer.find('\n')) != string::npos)
+            {
+                string line = buffer.substr(0, end);
+                buffer.erase(0, end + 1);
+                if (!line.empty() && line.back() == '\r')
+                    line.pop_back();
+                command(conn, line);
+            }
+        }
+        close(conn->fd);
+    }
+
+    void command(const shared_ptr<Connection> &conn, const string &line)
+    {
+        stringstream in(line);
+        string cmd;
+        if (!(in >> cmd))
+            return;
+        if (cmd == "new")
+        {
+            new_session(conn, in);
+            return;
+        }
+        uint64_t id = 0;
+        in >> id;
+        auto session = find_session(id);
+        if (!session)
+        {
+            conn->send("error " + to_string(id) + " unknown session");
+            return;
+        }
+        if (cmd == "bot")
+        {
+            request_bot(session, conn);
+            return;
+        }
+        lock_guard<mutex> lock(session->session_mutex);
+        if (session->is_busy || !session->requests.empty())
+            conn->send("error " + to_string(id) + " busy");
+        else if (cmd == "move")
+        {
+            string text;
+            in >> text;
+            auto chain = notation::parse_chain(parse_logic(), session->mtx, session->color, text);
+            if (chain.empty())
+                conn->send("error " + to_string(id) + " illegal move " + text);
+            else
+            {
+                play_chain(*session, chain);
+                conn->send("ok " + to_string(id));
+            }
+        }
+        else if (cmd == "undo")
+        {
+            if (session->turn_starts.empty())
+                conn->send("error " + to_string(id) + " nothing to undo");
+            else
+            {
+                while (session->history.size() > session->turn_starts.back())
+                    session->history.undo(session->mtx);
+                session->turn_starts.pop_back();
+                session->color = !session->color;
+                conn->send("ok " + to_string(id));
+            }
+        }
+        else if (cmd == "fen")
+            conn->send("fen " + to_string(id) + " " + notation::to_fen(session->mtx, session->color));
+        else if (cmd == "close")
+        {
+            lock_guard<mutex> sessions_lock(sessions_mutex);
+            sessions.erase(id);
+            conn->send("ok " + to_string(id));
+        }
+        else
+            conn->send("error " + to_string(id) + " unknown command " + cmd);
+    }
+
+    // new [level L] [budget MS] [nodes N] [fen FEN]
+    void new_session(const shared_ptr<Connection> &conn, stringstream &in)
+    {
+        auto session = make_shared<Session>();
+        session->level = default_level;
+        session->budget_ms = default_budget_ms;
+        session->mtx = notation::start_position();
+        string word;
+        while (in >> word)
+        {
+            if (word == "level")
+                in >> session->level;
+            else if (word == "budget")
+                in >> session->budget_ms;
+            else if (word == "nodes")
+                in >> session->nodes;
+            else if (word == "fen")
+            {
+                string fen;
+                in >> fen;
+                if (!notation::parse_fen(fen, session->mtx, session->color))
+                {
+                    conn->send("error 0 invalid fen " + fen);
+                    return;
+                }
+            }
+        }
+        // В режиме бюджета уровень задает бюджет позиций (если он не указан явно) и шум оценки
+        if (settings.difficulty == Difficulty::Budget)
+        {
+            session->level = max(0, min(session->level, max_budget_level));
+            if (!session->nodes)
+                session->nodes = budget_levels[session->level].nodes;
+            session->noise = budget_levels[session->level].noise;
+        }
+        else
+            session->level = max(0, min(session->level, 30));
+        session->history.reset(session->mtx, session->color);
+        {
+            lock_guard<mutex> lock(sessions_mutex);
+            session->id = ++last_id;
+            sessions[session->id] = session;
+        }
+        conn->send("session " + to_string(session->id));
+    }
+
+    shared_ptr<Session> find_session(const uint64_t id)
+    {
+        lock_guard<mutex> lock(sessions_mutex);
+        auto it = sessions.find(id);
+        return it == sessions.end() ? nullptr : it->second;
+    }
+
+    // Постановка запроса хода бота в очередь партии; партия встает в общую очередь,
+    // если в ней не было других запросов
+    void request_bot(const shared_ptr<Session> &session, const shared_ptr<Connection> &conn)
+    {
+        bool was_idle;
+        {
+            lock_guard<mutex> lock(session->session_mutex);
+            was_idle = !session->is_busy && session->requests.empty();
+            session->requests.push_back(conn);
+        }
+        if (was_idle)
+        {
+            {
+                lock_guard<mutex> lock(queue_mutex);
+                ready.push_back(session);
+            }
+            queue_cv.notify_one();
+        }
+    }
+
+    void worker_loop()
+    {
+        // У каждого потока свой поиск: Logic не рассчитан на общий доступ
+        Logic logic(settings);
+        while (true)
+        {
+            shared_ptr<Session> session;
+            {
+                unique_lock<mutex> lock(queue_mutex);
+                queue_cv.wait(lock, [this] { return is_stopping || !ready.empty(); });
+                if (is_stopping)
+                    return;
+                session = ready.front();
+                ready.pop_front();
+            }
+            bot_turn(logic, *session);
+            // Партия с оставшимися запросами встает в конец очереди
+            bool has_more;
+            {
+                lock_guard<mutex> lock(session->session_mutex);
+                session->is_busy = false;
+                has_more = !session->requests.empty();
+            }
+            if (has_more)
+            {
+                {
+                    lock_guard<mutex> lock(queue_mutex);
+                    ready.push_back(session);
+                }
+                queue_cv.notify_one();
+            }
+        }
+    }
+
+    // Поиск и выполнение хода бота в партии
+    void bot_turn(Logic &logic, Session &session)
+    {
+        auto start = chrono::steady_clock::now();
+        shared_ptr<Connection> conn;
+        vector<vector<POS_T>> mtx;
+        History history;
+        bool color;
+        search_limits limits;
+        {
+            lock_guard<mutex> lock(session.session_mutex);
+            conn = session.requests.front();
+            session.requests.pop_front();
+            session.is_busy = true;
+            mtx = session.mtx;
+            history = session.history;
+            color = session.color;
+            limits.depth = session.nodes ? max_budget_depth : session.level;
+            limits.nodes = session.nodes;
+            limits.time_ms = session.budget_ms;
+            logic.eval_noise = session.noise;
+        }
+        const string id = to_string(session.id);
+        if (is_draw(history))
+        {
+            conn->send("bestmove " + id + " draw");
+            return;
+        }
+        auto best = logic.search(mtx, history, color, limits);
+        const int ms = int(chrono::duration<double, milli>(chrono::steady_clock::now() - start).count());
+        if (best.empty())
+        {
+            conn->send("bestmove " + id + " none");
+            return;
+        }
+        {
+            lock_guard<mutex> lock(session.session_mutex);
+            play_chain(session, best);
+        }
+        conn->send("bestmove " + id + " " + notation::chain_to_string(best) + " depth " +
+                   to_string(logic.stats.depth) + " nodes " + to_string(logic.stats.nodes) + " time " + to_string(ms));
+    }
+
+    // Ничья по повторению позиции или по правилу ходов без прогресса
+    bool is_draw(const History &history) const
+    {
+        if (settings.no_progress_turns && history.reversible_turns() >= settings.no_progress_turns)
+            return true;
+        return settings.repetition_draw && history.repetitions() >= settings.repetition_draw;
+    }
+
+    void play_chain(Session &session, const vector<move_pos> &chain)
+    {
+        session.turn_starts.push_back(session.history.size());
+        notation::apply_chain(session.mtx, session.history, chain);
+        session.color = !session.color;
+    }
+
+    // Генератор ходов для разбора ходов клиентов (по одному на поток соединения)
+    Logic &parse_logic()
+    {
+        thread_local Logic logic(settings);
+        return logic;
+    }
+
+    int print_error(const string &text)
+    {
+        cerr << "Error: " << text << endl;
+        return 1;
+    }
+
+    const Settings settings;
+    const int default_level;
+    const double default_budget_ms;
+
+    mutex sessions_mutex;
+    map<uint64_t, shared_ptr<Session>> sessions;
+    uint64_t last_id = 0;
+
+    mutex queue_mutex;
+    condition_variable queue_cv;
+    deque<shared_ptr<Session>> ready; // партии с запросами хода бота в порядке очереди
+    bool is_stopping = false;
+    vector<thread> workers;
+};
@@ -0,0 +1,585 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "../Models/Move.h"
+#include "../Models/Search_stats.h"
+#include "../Models/Settings.h"
+#include "History.h"
+#include "Logic.h"
+#include "Notation.h"
+#include "PvTable.h"
+
+using namespace std;
+
+// Итог решения позиции для стороны, которая ходит
+enum class SolveOutcome
+{
+    Unknown, // бюджет узлов или времени исчерпан раньше, чем позиция решена
+    Win,
+    Loss,
+    Draw // ни одна сторона не может форсированно выиграть за оставшиеся ходы; если опровержение выигрыша
+         // опирается на ничьи, которые зависят от пути (повторение, конец партии), ответ - Unknown
+};
+
+// Результат решателя
+struct solve_result
+{
+    SolveOutcome outcome = SolveOutcome::Unknown;
+    int turns = 0;          // длина варианта line в ходах (серия взятий - один ход); 0 - вариант не доведен до конца
+                            // партии (узлы доказательства вытеснены из таблицы)
+    vector<move_pos> line;  // доказывающий вариант, каждый прыжок - отдельный элемент
+    search_stats stats;     // nodes - раскрытые позиции, expanded - узлы в таблице, depth - turns
+
+    // Первый ход варианта (пустой вектор - варианта нет)
+    vector<move_pos> turn() const
+    {
+        return line.empty() ? vector<move_pos>() : split_turns(line).front();
+    }
+};
+
+// Узел таблицы df-pn: числа доказательства (pn) и опровержения (dn) выигрыша атакующей стороны
+struct dfpn_entry
+{
+    uint64_t key = 0;
+    uint32_t pn = 1;
+    uint32_t dn = 1;
+    uint64_t work = 0;           // позиций в поддереве за все поиски узла (вытесняются узлы с меньшей работой)
+    uint16_t distance = 0;       // доказанный выигрыш: ходов до конца партии при лучшей игре сторон
+    uint16_t busy = 0;           // потоки, которые сейчас ищут в поддереве узла
+    bool path_dependent = false; // опровержение (dn = 0) опирается на ничьи, которые зависят от пути
+};
+
+/**
+ * Таблица узлов df-pn фиксированного размера: корзины по 4 узла, при заполнении вытесняется
+ * узел с наименьшей работой, в поддереве которого не ищет ни один поток.
+ * Корзины защищены набором мьютексов, поэтому таблицу используют все потоки решателя
+ */
+class DfpnTable
+{
+  public:
+    explicit DfpnTable(const size_t size_mb)
+    {
+        size_t buckets = 1;
+        while (buckets * 2 * sizeof(bucket) <= (max<size_t>(size_mb, 1) << 20))
+            buckets *= 2;
+        table.resize(buckets);
+        mask = buckets - 1;
+    }
+
+    void clear()
+    {
+        fill(table.begin(), table.end(), bucket());
+        used = 0;
+    }
+
+    bool lookup(const uint64_t key, dfpn_entry &res)
+    {
+        lock_guard<mutex> lock(lock_of(key));
+        const dfpn_entry *entry = find(key);
+        if (entry)
+            res = *entry;
+        return entry != nullptr;
+    }
+
+    // Запись чисел узла; счетчик потоков в узле сохраняется
+    void store(const dfpn_entry &value)
+    {
+        lock_guard<mutex> lock(lock_of(value.key));
+        dfpn_entry *entry = find(value.key);
+        if (!entry)
+            entry = replace(value.key);
+        const uint16_t busy = entry->busy;
+        *entry = value;
+        entry->busy = busy;
+    }
+
+    // Поток входит в узел (add = 1) или выходит из него (add = -1)
+    void mark(const uint64_t key, const int add)
+    {
+        lock_guard<mutex> lock(lock_of(key));
+        dfpn_entry *entry = find(key);
+        if (!entry && add > 0)
+            entry = replace(key);
+        if (entry)
+            entry->busy = uint16_t(max(0, entry->busy + add));
+    }
+
+    // Число занятых узлов
+    size_t size() const
+    {
+        return used;
+    }
+
+    size_t capacity() const
+    {
+        return table.size() * bucket_size;
+    }
+
+  private:
+    static constexpr int bucket_size = 4;
+    static constexpr size_t lock_count = 1024;
+
+    struct bucket
+    {
+        array<dfpn_entry, bucket_size> entries;
+    };
+
+    mutex &lock_of(const uint64_t key)
+    {
+        return locks[(key & mask) % lock_count];
+    }
+
+    dfpn_entry *find(const uint64_t key)
+    {
+        for (auto &entry : table[key & mask].entries)
+        {
+            if (entry.key == key)
+                return &entry;
+        }
+        return nullptr;
+    }
+
+    dfpn_entry *replace(const uint64_t key)
+    {
+        dfpn_entry *victim = nullptr;
+        for (auto &entry : table[key & mask].entries)
+        {
+            if (!entry.key)
+            {
+                victim = &entry;
+                ++used;
+                break;
+            }
+            if (!victim || (entry.busy == 0 && (victim->busy > 0 || entry.work < victim->work)))
+                victim = &entry;
+        }
+        *victim = dfpn_entry();
+        victim->key = key;
+        return victim;
+    }
+
+    vector<bucket> table;
+    size_t mask = 0;
+    array<mutex, lock_count> locks;
+    atomic<size_t> used{0};
+};
+
+/**
+ * Решатель позиций поиском по числам доказательства в глубину (df-pn) с правилом 1 + epsilon.
+ * Выигрыш стороны доказывается до конца партии, а не до горизонта перебора: сначала доказывается
+ * выигрыш стороны, которая ходит, затем выигрыш соперника; если оба опровергнуты - ничья.
+ * Ничьей считаются повторение позиции на пути из корня, правило ходов без прогресса (NoProgressTurns)
+ * и исчерпание оставшихся ходов партии. Счетчик ходов без прогресса входит в ключ узла; повторение
+ * и число оставшихся ходов зависят от пути, а узлы таблицы - нет (проблема истории графа, GHI).
+ * Опровержение, которое опирается на такие ничьи, помечается в узле (path_dependent), и пометка
+ * переходит к узлам, чье опровержение опирается на помеченные. Ничья сообщается, только если оба
+ * опровержения в корне без пометки, иначе ответ - Unknown: выигрыш мог быть пропущен.
+ * Потоки ищут от одного корня с общей таблицей и берут разные ходы из корня; узлы на путях потоков
+ * не вытесняются из таблицы
+ */
+class Solver
+{
+  public:
+    Solver(const Settings &settings) : settings(settings), table(settings.solver_memory_mb)
+    {
+        this->settings.no_random = true;
+    }
+
+    /**
+     * Решение позиции mtx, color - сторона, которая ходит.
+     * Ограничения limits: число позиций (nodes), время и флаг остановки; глубина не используется
+     * @param turns_left ходов до конца партии (0 - MaxNumTurns из настроек)
+     * @param reversible ходов дамками без взятий подряд перед позицией (History::reversible_turns)
+     */
+    solve_result solve(const vector<vector<POS_T>> &mtx, const bool color, const search_limits &limits = {},
+                       const int turns_left = 0, const size_t reversible = 0)
+    {
+        start_time = chrono::steady_clock::now();
+        time_ms = limits.time_ms;
+        max_nodes = limits.nodes ? limits.nodes : settings.solver_nodes;
+        stop = limits.stop;
+        max_turns = turns_left > 0 ? turns_left : settings.max_turns;
+        nodes = 0;
+        table.clear();
+
+        solve_result res;
+        root_mtx = mtx;
+        root_color = color;
+        root_reversible = reversible;
+        root_hash = position_hash(mtx) ^ (color ? zobrist.black_turn : 0);
+        // Выигрыш стороны, которая ходит, затем выигрыш соперника
+        for (const bool side : {color, !color})
+        {
+            const dfpn_entry root = prove(side);
+            if (root.pn == 0)
+            {
+                res.outcome = side == color ? SolveOutcome::Win : SolveOutcome::Loss;
+                if (proving_line(side, res.line))
+                    res.turns = int(split_turns(res.line).size());
+                break;
+            }
+            if (root.dn != 0 || root.path_dependent)
+            {
+                res.outcome = SolveOutcome::Unknown;
+                break;
+            }
+            res.outcome = SolveOutcome::Draw;
+        }
+        res.stats.nodes = nodes.load(memory_order_relaxed);
+        res.stats.expanded = table.size();
+        res.stats.depth = res.turns;
+        res.stats.score = res.outcome == SolveOutcome::Win ? INF : res.outcome == SolveOutcome::Loss ? 0 : 1;
+        res.stats.time_ms = elapsed_ms();
+        return res;
+    }
+
+    // Решение позиции в записи FEN ("W:Wa1,c1,Kd4:Bb8,h8")
+    solve_result solve(const string &fen, const search_limits &limits = {}, const int turns_left = 0)
+    {
+        vector<vector<POS_T>> mtx;
+        bool color = false;
+        if (!notation::parse_fen(fen, mtx, color))
+            throw runtime_error("invalid fen " + fen);
+        return solve(mtx, color, limits, turns_left);
+    }
+
+  private:
+    static constexpr uint32_t infinity = 1u << 30;
+    // Ключ узлов доказательства выигрыша черных (у белых - хеш позиции)
+    static constexpr uint64_t black_attacker = 0x9E6C63D0676A9A99ULL;
+    static constexpr uint64_t reversible_step = 0xD1B54A32D192ED03ULL;
+    // Позиции добавляются к общему счетчику пачками
+    static constexpr uint64_t node_batch = 256;
+
+    // Ход из узла; позиция после него строится, только когда решатель входит в потомка
+    struct child
+    {
+        vector<move_pos> chain;
+        uint64_t hash = 0;     // хеш позиции после хода с очередью хода
+        size_t reversible = 0;  // ходов дамками без взятий подряд
+        bool is_draw = false;   // ничья по правилам партии на этом пути
+        bool path_draw = false; // ничья зависит от пути: повторение на пути или конец партии
+        dfpn_entry entry;
+    };
+
+    // Состояние потока решателя
+    struct worker
+    {
+        explicit worker(const Settings &settings) : logic(settings)
+        {
+        }
+
+        Logic logic;
+        vector<uint64_t> path; // хеши позиций от корня до текущего узла
+        uint64_t nodes = 0;    // позиции, еще не добавленные к общему счетчику
+    };
+
+    // Ключ узла: позиция, сторона, выигрыш которой доказывается, и счетчик ходов без прогресса
+    // (доказательство, найденное при меньшем счетчике, может быть длиннее, чем позволяет правило)
+    uint64_t key_of(const uint64_t hash, const size_t reversible) const
+    {
+        uint64_t key = hash ^ (attacker ? black_attacker : 0);
+        if (settings.no_progress_turns)
+            key ^= reversible * reversible_step;
+        return key ? key : 1;
+    }
+
+    // Доказательство выигрыша attacker всеми потоками; возвращает числа корня
+    dfpn_entry prove(const bool attacker)
+    {
+        this->attacker = attacker;
+        is_solved = false;
+        vector<thread> helpers;
+        for (unsigned int i = 1; i < settings.solver_threads; ++i)
+            helpers.emplace_back(&Solver::work, this);
+        work();
+        for (auto &helper : helpers)
+            helper.join();
+        dfpn_entry root;
+        if (!table.lookup(key_of(root_hash, root_reversible), root))
+            root = dfpn_entry();
+        return root;
+    }
+
+    void work()
+    {
+        worker w(settings);
+        dfpn_entry root;
+        while (!is_solved.load(memory_order_relaxed) && !limit_reached())
+        {
+            mid(w, root_mtx, root_color, root_hash, root_reversible, 0, infinity, infinity, root);
+            if (root.pn == 0 || root.dn == 0)
+                is_solved = true;
+        }
+        nodes.fetch_add(w.nodes, memory_order_relaxed);
+    }
+
+    bool limit_reached() const
+    {
+        if (stop && stop->load(memory_order_relaxed))
+            return true;
+        if (max_nodes && nodes.load(memory_order_relaxed) >= max_nodes)
+            return true;
+        return time_ms > 0 && elapsed_ms() >= time_ms;
+    }
+
+    double elapsed_ms() const
+    {
+        return chrono::duration<double, milli>(chrono::steady_clock::now() - start_time).count();
+    }
+
+    static uint32_t add(const uint32_t a, const uint32_t b)
+    {
+        return uint32_t(min<uint64_t>(uint64_t(a) + b, infinity));
+    }
+
+    // Сумма чисел потомков: бесконечность только у решенного узла, большие суммы ограничены числом меньше нее
+    static uint32_t sum(const uint32_t a, const uint32_t b)
+    {
+        if (a >= infinity || b >= infinity)
+            return infinity;
+        return uint32_t(min<uint64_t>(uint64_t(a) + b, infinity - 1));
+    }
+
+    // Порог для лучшего потомка по второму лучшему значению (правило 1 + epsilon, epsilon = 1/4)
+    static uint32_t second_threshold(const uint32_t second)
+    {
+        return add(second, second / 4 + 1);
+    }
+
+    /**
+     * Ходы из позиции и позиции после них. Ничьи по правилам (повторение на пути, ходы без прогресса,
+     * конец партии) помечаются сразу
+     */
+    vector<child> expand(worker &w, const vector<vector<POS_T>> &mtx, const bool color, const uint64_t hash,
+                         const size_t reversible, const int depth)
+    {
+        const auto chains = w.logic.turn_chains(color, mtx);
+        vector<child> res(chains.size());
+        for (size_t i = 0; i < chains.size(); ++i)
+        {
+            child &c = res[i];
+            c.chain = chains[i];
+            const move_pos &first = c.chain.front();
+            c.reversible = first.xb == -1 && mtx[first.x][first.y] > 2 ? reversible + 1 : 0;
+            c.hash = hash ^ zobrist.black_turn ^ turn_hash(mtx, first);
+            // Хеш серии взятий считается по позициям после каждого прыжка
+            if (c.chain.size() > 1)
+            {
+                auto next = w.logic.make_turn(mtx, first);
+                for (size_t j = 1; j < c.chain.size(); ++j)
+                {
+                    c.hash ^= turn_hash(next, c.chain[j]);
+                    next = w.logic.make_turn(move(next), c.chain[j]);
+                }
+            }
+            c.path_draw =
+                depth + 1 >= max_turns || find(w.path.begin(), w.path.end(), c.hash) != w.path.end();
+            c.is_draw = c.path_draw || (settings.no_progress_turns && c.reversible >= settings.no_progress_turns);
+        }
+        return res;
+    }
+
+    // Позиция после хода chain
+    static vector<vector<POS_T>> after(worker &w, vector<vector<POS_T>> mtx, const vector<move_pos> &chain)
+    {
+        for (const auto &turn : chain)
+            mtx = w.logic.make_turn(move(mtx), turn);
+        return mtx;
+    }
+
+    /**
+     * Поиск в узле, пока его числа ниже порогов th_pn и th_dn (MID из df-pn).
+     * @param res числа узла после поиска (записываются и в таблицу)
+     */
+    void mid(worker &w, const vector<vector<POS_T>> &mtx, const bool color, const uint64_t hash,
+             const size_t reversible, const int depth, const uint32_t th_pn, const uint32_t th_dn, dfpn_entry &res)
+    {
+        const bool is_or = color == attacker; // ходит атакующая сторона
+        const uint64_t key = key_of(hash, reversible);
+        if (++w.nodes >= node_batch)
+        {
+            nodes.fetch_add(w.nodes, memory_order_relaxed);
+            w.nodes = 0;
+        }
+        if (!table.lookup(key, res))
+        {
+            res = dfpn_entry();
+            res.key = key;
+        }
+        auto children = expand(w, mtx, color, hash, reversible, depth);
+        // Сторона без ходов проиграла
+        if (children.empty())
+        {
+            res.pn = is_or ? infinity : 0;
+            res.dn = is_or ? 0 : infinity;
+            res.distance = 0;
+            res.path_dependent = false;
+            res.work = max<uint64_t>(res.work, 1);
+            table.store(res);
+            return;
+        }
+        const uint64_t start_nodes = nodes.load(memory_order_relaxed) + w.nodes;
+        w.path.push_back(hash);
+        table.mark(key, 1);
+        while (true)
+        {
+            // Числа узла по числам потомков
+            uint32_t pn = is_or ? infinity : 0, dn = is_or ? 0 : infinity;
+            // Опровержение хода атакующей стороны требует опровержения всех ходов и зависит от пути, если
+            // от пути зависит хоть одно; опровержение хода защищающейся - если от пути зависят все опровергнутые
+            bool dependent = false, independent = false;
+            for (auto &c : children)
+            {
+                if (c.is_draw)
+                {
+                    c.entry.pn = infinity;
+                    c.entry.dn = 0;
+                    c.entry.busy = 0;
+                    c.entry.path_dependent = c.path_draw;
+                }
+                else if (!table.lookup(key_of(c.hash, c.reversible), c.entry))
+                    c.entry = dfpn_entry();
+                if (is_or)
+                {
+                    pn = min(pn, c.entry.pn);
+                    dn = sum(dn, c.entry.dn);
+                }
+                else
+                {
+                    pn = sum(pn, c.entry.pn);
+                    dn = min(dn, c.entry.dn);
+                }
+                dependent = dependent || c.entry.path_dependent;
+                independent = independent || (c.entry.dn == 0 && !c.entry.path_dependent);
+            }
+            res.pn = pn;
+            res.dn = dn;
+            res.path_dependent = dn == 0 && (is_or ? dependent : !independent);
+            if (pn >= th_pn || dn >= th_dn || pn == 0 || dn == 0 || is_solved.load(memory_order_relaxed) ||
+                limit_reached())
+                break;
+            // Лучший потомок: наименьшее число доказательства (опровержения) хода атакующей (защищающейся)
+            // стороны. В корне потоки берут разные ходы: ход, в котором уже ищет другой поток, выбирается,
+            // только если свободных нет
+            child *best = nullptr;
+            uint64_t best_order = 0;
+            uint32_t second = infinity;
+            for (auto &c : children)
+            {
+                const uint32_t value = is_or ? c.entry.pn : c.entry.dn;
+                const uint64_t order = (uint64_t(depth == 0 && c.entry.busy > 0) << 32) | value;
+                if (!best || order < best_order)
+                {
+                    if (best)
+                        second = min(second, is_or ? best->entry.pn : best->entry.dn);
+                    best = &c;
+                    best_order = order;
+                }
+                else
+                    second = min(second, value);
+            }
+            uint32_t child_pn, child_dn;
+            if (is_or)
+            {
+                child_pn = min(th_pn, second_threshold(second));
+                child_dn = add(th_dn - dn, best->entry.dn);
+            }
+            else
+            {
+                child_pn = add(th_pn - pn, best->entry.pn);
+                child_dn = min(th_dn, second_threshold(second));
+            }
+            // Порог выше числа потомка, даже если меньшее число у хода, занятого другим потоком
+            child_pn = max(child_pn, add(best->entry.pn, 1));
+            child_dn = max(child_dn, add(best->entry.dn, 1));
+            dfpn_entry next;
+            mid(w, after(w, mtx, best->chain), !color, best->hash, best->reversible, depth + 1, child_pn, child_dn,
+                next);
+        }
+        // Длина доказанного выигрыша: атакующая сторона выбирает кратчайший, защищающаяся - самый долгий
+        if (res.pn == 0)
+        {
+            int distance = is_or ? infinity : 0;
+            for (const auto &c : children)
+            {
+                if (c.entry.pn == 0)
+                    distance = is_or ? min<int>(distance, c.entry.distance) : max<int>(distance, c.entry.distance);
+            }
+            res.distance = uint16_t(min(distance + 1, 65535));
+        }
+        res.work += nodes.load(memory_order_relaxed) + w.nodes - start_nodes + 1;
+        table.store(res);
+        table.mark(key, -1);
+        w.path.pop_back();
+    }
+
+    /**
+     * Вариант из доказанных узлов: кратчайший выигрыш против самой долгой защиты
+     * @return true - вариант доведен до конца партии (у проигравшей стороны нет ходов)
+     */
+    bool proving_line(const bool attacker, vector<move_pos> &line)
+    {
+        this->attacker = attacker;
+        worker w(settings);
+        line.clear();
+        vector<vector<POS_T>> mtx = root_mtx;
+        bool color = root_color;
+        uint64_t hash = root_hash;
+        size_t reversible = root_reversible;
+        for (int depth = 0; depth < max_turns; ++depth)
+        {
+            const auto children = expand(w, mtx, color, hash, reversible, depth);
+            if (children.empty())
+                return color != attacker;
+            const child *best = nullptr;
+            dfpn_entry best_entry;
+            for (const auto &c : children)
+            {
+                dfpn_entry entry;
+                if (c.is_draw || !table.lookup(key_of(c.hash, c.reversible), entry) || entry.pn != 0)
+                    continue;
+                if (!best || (color == attacker ? entry.distance < best_entry.distance
+                                                : entry.distance > best_entry.distance))
+                {
+                    best = &c;
+                    best_entry = entry;
+                }
+            }
+            if (!best)
+                break;
+            line.insert(line.end(), best->chain.begin(), best->chain.end());
+            w.path.push_back(hash);
+            mtx = after(w, mtx, best->chain);
+            hash = best->hash;
+            reversible = best->reversible;
+            color = !color;
+        }
+        return false;
+    }
+
+    Settings settings;
+    DfpnTable table;
+    // Корень текущего решения
+    vector<vector<POS_T>> root_mtx;
+    bool root_color = false;
+    uint64_t root_hash = 0;
+    size_t root_reversible = 0;
+    bool attacker = false; // сторона, выигрыш которой доказывается
+    int max_turns = 0;
+    // Ограничения текущего решения
+    double time_ms = 0;
+    uint64_t max_nodes = 0;
+    const atomic<bool> *stop = nullptr;
+    chrono::steady_clock::time_point start_time;
+    atomic<uint64_t> nodes{0};
+    atomic<bool> is_solved{false};
+};
@@ -0,0 +1,152 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <string>
+#include <thread>
+
+#include "../Models/Move.h"
+#include "../Models/Search_stats.h"
+
+using namespace std;
+
+// Запись телеметрии одного хода бота
+struct turn_telemetry
+{
+    static constexpr int max_moves = 16;
+
+    int turn = 0;                 // номер хода в партии
+    bool color = false;           // цвет бота (false - белые, true - черные)
+    search_stats stats;           // счетчики поиска
+    int move_count = 0;           // длина выбранной цепочки ходов
+    move_pos moves[max_moves];    // выбранная цепочка ходов
+};
+
+// Кольцевой буфер без блокировок для одного писателя и одного читателя
+template <class T, size_t N> class spsc_ring
+{
+    static_assert((N & (N - 1)) == 0, "ring size must be a power of two");
+
+  public:
+    // Добавление элемента, false - если буфер заполнен
+    bool push(const T &item)
+    {
+        const size_t head = head_.load(memory_order_relaxed);
+        if (head - tail_.load(memory_order_acquire) == N)
+            return false;
+        items[head & (N - 1)] = item;
+        head_.store(head + 1, memory_order_release);
+        return true;
+    }
+
+    // Извлечение элемента, false - если буфер пуст
+    bool pop(T &item)
+    {
+        const size_t tail = tail_.load(memory_order_relaxed);
+        if (tail == head_.load(memory_order_acquire))
+            return false;
+        item = items[tail & (N - 1)];
+        tail_.store(tail + 1, memory_order_release);
+        return true;
+    }
+
+  private:
+    array<T, N> items;
+    alignas(64) atomic<size_t> head_{0};
+    alignas(64) atomic<size_t> tail_{0};
+};
+
+// Телеметрия поиска в формате JSON Lines (одна запись на ход бота).
+// Игровой поток только кладет запись в кольцевой буфер, форматирование и запись
+// в файл выполняет фоновый поток, поэтому файловый ввод-вывод не задерживает поиск
+class Telemetry
+{
+  public:
+    // path - файл телеметрии, пустая строка отключает запись
+    explicit Telemetry(const string &path)
+    {
+        if (path.empty())
+            return;
+        fout.open(path, ios_base::app);
+        if (!fout)
+            return;
+        is_running = true;
+        writer = thread(&Telemetry::write_loop, this);
+    }
+
+    ~Telemetry()
+    {
+        is_running = false;
+        if (writer.joinable())
+            writer.join();
+    }
+
+    Telemetry(const Telemetry &) = delete;
+    Telemetry &operator=(const Telemetry &) = delete;
+
+    bool enabled() const
+    {
+        return writer.joinable();
+    }
+
+    // Передача записи фоновому потоку; при переполнении буфера запись отбрасывается
+    void push(const turn_telemetry &record)
+    {
+        if (!enabled())
+            return;
+        if (!ring.push(record))
+            dropped.fetch_add(1, memory_order_relaxed);
+    }
+
+    // Число записей, отброшенных из-за переполнения буфера
+    uint64_t dropped_count() const
+    {
+        return dropped.load(memory_order_relaxed);
+    }
+
+  private:
+    void write_loop()
+    {
+        turn_telemetry record;
+        while (true)
+        {
+            // Флаг читается до опустошения буфера, чтобы не потерять последние записи
+            const bool running = is_running;
+            bool written = false;
+            while (ring.pop(record))
+            {
+                write(record);
+                written = true;
+            }
+            if (written)
+                fout.flush();
+            if (!running)
+                break;
+            this_thread::sleep_for(chrono::milliseconds(50));
+        }
+    }
+
+    void write(const turn_telemetry &r)
+    {
+        const search_stats &s = r.stats;
+        fout << "{\"turn\":" << r.turn << ",\"color\":\"" << (r.color ? "black" : "white") << "\",\"depth\":" << s.depth
+             << ",\"nodes\":" << s.nodes << ",\"nps\":" << uint64_t(s.nps()) << ",\"leaves\":" << s.leaves
+             << ",\"cutoffs\":" << s.cutoffs << ",\"tt_hits\":" << s.tt_hits << ",\"branching\":" << s.branching()
+             << ",\"move\":\"";
+        for (int i = 0; i < r.move_count; ++i)
+        {
+            const move_pos &m = r.moves[i];
+            if (i == 0)
+                fout << cell_name(m.x, m.y);
+            fout << (m.xb != -1 ? ':' : '-') << cell_name(m.x2, m.y2);
+        }
+        fout << "\",\"score\":" << s.score << ",\"time_ms\":" << s.time_ms << "}\n";
+    }
+
+    spsc_ring<turn_telemetry, 256> ring;
+    ofstream fout;
+    thread writer;
+    atomic<bool> is_running{false};
+    atomic<uint64_t> dropped{0};
+};
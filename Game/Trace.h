@@ -0,0 +1,240 @@
+#pragma once
+// Трассировка поиска в формате Chrome trace event (открывается в Perfetto и chrome://tracing).
+// Включается при сборке с -DCHECKERS_TRACE; без этого макросы TRACE_* раскрываются в пустоту.
+// Частые участки (генерация ходов, оценка, проверка повторений) записываются выборочно:
+// один вызов из sample_rate (параметр Trace::start)
+#ifdef CHECKERS_TRACE
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+// Событие трассировки: участок кода с временем начала и длительностью
+struct trace_event
+{
+    const char *name;
+    const char *arg_name; // nullptr - без аргумента
+    int64_t arg;
+    uint64_t start_ns;
+    uint64_t duration_ns;
+    char detail[16]; // короткая строка, например ход "c3:e5:g3"
+};
+
+class Trace
+{
+  public:
+    /**
+     * Начало записи трассировки
+     * @param path файл для записи при остановке
+     * @param sample_rate частые участки записываются один раз на sample_rate вызовов (степень двойки)
+     */
+    static void start(const string &path, unsigned int sample_rate)
+    {
+        Trace &t = instance();
+        lock_guard<mutex> lock(t.buffers_mutex);
+        unsigned int rate = 1;
+        while (rate < sample_rate)
+            rate <<= 1;
+        t.sample_mask = rate - 1;
+        t.path = path;
+        for (auto &buffer : t.buffers)
+            buffer->events.clear();
+        t.start_time = chrono::steady_clock::now();
+        t.is_enabled.store(true, memory_order_release);
+    }
+
+    // Остановка и запись всех событий в файл
+    static void stop()
+    {
+        Trace &t = instance();
+        if (!t.is_enabled.exchange(false))
+            return;
+        lock_guard<mutex> lock(t.buffers_mutex);
+        ofstream fout(t.path);
+        fout << "{\"traceEvents\":[";
+        bool first = true;
+        for (auto &buffer : t.buffers)
+        {
+            for (const auto &e : buffer->events)
+            {
+                fout << (first ? "\n" : ",\n");
+                first = false;
+                char line[256];
+                snprintf(line, sizeof(line), "{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f",
+                         e.name, buffer->tid, double(e.start_ns) / 1000, double(e.duration_ns) / 1000);
+                fout << line;
+                if (e.arg_name || e.detail[0])
+                {
+                    fout << ",\"args\":{";
+                    if (e.arg_name)
+                        fout << '"' << e.arg_name << "\":" << e.arg << (e.detail[0] ? "," : "");
+                    if (e.detail[0])
+                        fout << "\"move\":\"" << e.detail << '"';
+                    fout << '}';
+                }
+                fout << '}';
+            }
+            buffer->events.clear();
+        }
+        fout << "\n],\"displayTimeUnit\":\"ms\",\"otherData\":{\"sample_rate\":" << t.sample_mask + 1 << "}}\n";
+    }
+
+    static bool enabled()
+    {
+        return instance().is_enabled.load(memory_order_relaxed);
+    }
+
+    // Нужно ли записать очередной вызов частого участка
+    static bool sample(unsigned int &counter)
+    {
+        return enabled() && (++counter & instance().sample_mask) == 0;
+    }
+
+    static uint64_t now_ns()
+    {
+        return uint64_t(chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() -
+                                                                   instance().start_time)
+                            .count());
+    }
+
+    static void record(const trace_event &event)
+    {
+        thread_buffer &buffer = local_buffer();
+        // Ограничение памяти: при переполнении новые события отбрасываются
+        if (buffer.events.size() < max_events_per_thread)
+            buffer.events.push_back(event);
+    }
+
+  private:
+    struct thread_buffer
+    {
+        unsigned int tid;
+        vector<trace_event> events;
+    };
+
+    static Trace &instance()
+    {
+        static Trace trace;
+        return trace;
+    }
+
+    // Буфер событий текущего потока (регистрируется при первом событии)
+    static thread_buffer &local_buffer()
+    {
+        thread_local thread_buffer *buffer = nullptr;
+        if (!buffer)
+        {
+            Trace &t = instance();
+            lock_guard<mutex> lock(t.buffers_mutex);
+            t.buffers.push_back(make_unique<thread_buffer>());
+            buffer = t.buffers.back().get();
+            buffer->tid = unsigned(t.buffers.size());
+            buffer->events.reserve(1 << 16);
+        }
+        return *buffer;
+    }
+
+    static constexpr size_t max_events_per_thread = 1 << 22;
+
+    atomic<bool> is_enabled{false};
+    unsigned int sample_mask = 63;
+    string path;
+    chrono::steady_clock::time_point start_time = chrono::steady_clock::now();
+    mutex buffers_mutex;
+    vector<unique_ptr<thread_buffer>> buffers;
+};
+
+// Участок кода от создания до уничтожения объекта
+class trace_scope
+{
+  public:
+    /**
+     * @param active записывать ли участок
+     * @param arg_name, arg числовой аргумент события
+     * @param counter если задан, аргумент - приращение счетчика за время участка
+     */
+    trace_scope(const char *name, const bool active, const char *arg_name = nullptr, const int64_t arg = 0,
+                const uint64_t *counter = nullptr)
+        : active(active), counter(counter)
+    {
+        if (!active)
+            return;
+        event.name = name;
+        event.arg_name = arg_name;
+        event.arg = arg;
+        event.detail[0] = 0;
+        if (counter)
+            counter_start = *counter;
+        event.start_ns = Trace::now_ns();
+    }
+
+    ~trace_scope()
+    {
+        if (!active)
+            return;
+        event.duration_ns = Trace::now_ns() - event.start_ns;
+        if (counter)
+            event.arg = int64_t(*counter - counter_start);
+        Trace::record(event);
+    }
+
+    trace_scope(const trace_scope &) = delete;
+    trace_scope &operator=(const trace_scope &) = delete;
+
+    bool is_active() const
+    {
+        return active;
+    }
+
+    // Короткая подпись участка (обрезается до 15 символов)
+    void set_detail(const string &detail)
+    {
+        const size_t len = detail.copy(event.detail, sizeof(event.detail) - 1);
+        event.detail[len] = 0;
+    }
+
+  private:
+    bool active;
+    trace_event event;
+    const uint64_t *counter;
+    uint64_t counter_start = 0;
+};
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+// Участок, записываемый всегда
+#define TRACE_SCOPE(name) trace_scope TRACE_CONCAT(trace_scope_, __LINE__)(name, Trace::enabled())
+// Участок с числовым аргументом
+#define TRACE_SCOPE_ARG(name, arg_name, arg) \
+    trace_scope TRACE_CONCAT(trace_scope_, __LINE__)(name, Trace::enabled(), arg_name, arg)
+// Участок при условии active, аргумент - приращение счетчика counter, detail - подпись
+// (вычисляется только для записываемых участков)
+#define TRACE_SCOPE_COUNTER(name, active, arg_name, counter, detail)                                          \
+    trace_scope TRACE_CONCAT(trace_scope_, __LINE__)((name), (active) && Trace::enabled(), arg_name, 0, &(counter)); \
+    if (TRACE_CONCAT(trace_scope_, __LINE__).is_active())                                                      \
+    TRACE_CONCAT(trace_scope_, __LINE__).set_detail(detail)
+// Частый участок, записывается один раз на sample_rate вызовов
+#define TRACE_SAMPLED_SCOPE(name)                                           \
+    static thread_local unsigned int TRACE_CONCAT(trace_sample_, __LINE__); \
+    trace_scope TRACE_CONCAT(trace_scope_, __LINE__)(name, Trace::sample(TRACE_CONCAT(trace_sample_, __LINE__)))
+#define TRACE_START(path, sample_rate) Trace::start(path, sample_rate)
+#define TRACE_STOP() Trace::stop()
+
+#else
+
+// Без трассировки макросы - пустые операторы: "if (...) TRACE_START(...);" не остается с пустым телом
+#define TRACE_SCOPE(name) ((void)0)
+#define TRACE_SCOPE_ARG(name, arg_name, arg) ((void)0)
+#define TRACE_SCOPE_COUNTER(name, active, arg_name, counter, detail) ((void)0)
+#define TRACE_SAMPLED_SCOPE(name) ((void)0)
+#define TRACE_START(path, sample_rate) ((void)0)
+#define TRACE_STOP() ((void)0)
+
+#endif
@@ -0,0 +1,323 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#if defined(__unix__) || defined(__APPLE__)
+    #include <fcntl.h>
+    #include <sys/file.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+    #define CHECKERS_TT_MMAP
+#endif
+
+#include "../Models/Move.h"
+
+using namespace std;
+
+// Вид оценки в таблице транспозиций
+enum class tt_bound : uint8_t
+{
+    none,  // пустая запись
+    exact, // точная оценка
+    lower, // оценка не меньше score
+    upper  // оценка не больше score
+};
+
+// Прочитанная запись таблицы транспозиций
+struct tt_entry
+{
+    double score = 0;
+    int draft = 0;              // оставшаяся глубина поиска (в ходах), на которую получена оценка
+    tt_bound bound = tt_bound::none;
+    int age = 0;                // поколение (номер поиска по модулю 256), в котором запись сделана
+    move_pos turn;              // лучший ход (первый прыжок), x = -1 - хода нет
+};
+
+/**
+ * Таблица транспозиций в разделяемой памяти.
+ * Записи хранятся в файле, отображенном в память (/dev/shm или обычный диск), поэтому таблица
+ * переживает перезапуск и используется одновременно несколькими процессами и потоками без блокировок.
+ * Запись - три 64-битных слова: key ^ score ^ meta, score и meta. Слова пишутся и читаются
+ * по отдельности, запись, разорванная параллельной записью, не проходит проверку ключа и считается промахом.
+ * Без файла (пустой путь) таблица живет в памяти процесса
+ */
+class TransTable
+{
+    struct slot
+    {
+        atomic<uint64_t> check;
+        atomic<uint64_t> score;
+        atomic<uint64_t> meta;
+    };
+
+    // Заголовок файла таблицы
+    struct header
+    {
+        uint64_t magic;
+        uint64_t slot_count;
+        atomic<uint32_t> generation; // номер поиска, увеличивается каждым поиском любого процесса
+        uint32_t reserved[11];
+    };
+
+    static_assert(atomic<uint64_t>::is_always_lock_free && atomic<uint32_t>::is_always_lock_free,
+                  "shared transposition table needs address-free atomics");
+    static_assert(sizeof(slot) == 24 && sizeof(header) == 64, "unexpected transposition table layout");
+
+  public:
+    static constexpr uint64_t magic_value = 0x3130305454524843; // "CHRTT001"
+
+    /**
+     * Открывает или создает таблицу
+     * @param path файл таблицы, пустая строка - память процесса
+     * @param size_mb размер новой таблицы; у существующего файла размер берется из файла,
+     *        0 - открыть только существующий файл
+     */
+    TransTable(const string &path, const size_t size_mb) : path(path), requested_mb(size_mb)
+    {
+        const size_t requested = size_mb * 1024 * 1024 / sizeof(slot);
+        if (path.empty())
+        {
+            if (!requested)
+                throw runtime_error("transposition table size must be positive");
+            const size_t count = slot_count(requested);
+            mapped_size = sizeof(header) + count * sizeof(slot);
+            private_memory.resize(mapped_size / sizeof(uint64_t));
+            base = reinterpret_cast<char *>(private_memory.data());
+            new (base) header{magic_value, count, {0}, {}};
+        }
+        else
+            open_file(requested);
+        head = reinterpret_cast<header *>(base);
+        slots = reinterpret_cast<slot *>(base + sizeof(header));
+        mask = head->slot_count - 1;
+    }
+
+    ~TransTable()
+    {
+#ifdef CHECKERS_TT_MMAP
+        if (!path.empty() && base)
+            munmap(base, mapped_size);
+#endif
+    }
+
+    TransTable(const TransTable &) = delete;
+    TransTable &operator=(const TransTable &) = delete;
+
+    /**
+     * Общая таблица процесса для файла path: все экземпляры Logic с одинаковыми настройками
+     * ищут в одной таблице. Таблица создается при первом обращении и живет до конца процесса.
+     * Если файл не удалось открыть, исключение выбрасывается один раз, дальше возвращается nullptr
+     */
+    static shared_ptr<TransTable> shared(const string &path, const size_t size_mb)
+    {
+        static mutex registry_mutex;
+        static map<string, shared_ptr<TransTable>> registry;
+        lock_guard<mutex> lock(registry_mutex);
+        const auto it = registry.find(path);
+        // Таблица в памяти процесса пересоздается при изменении размера
+        if (it != registry.end() && (!it->second || !path.empty() || it->second->requested_mb == size_mb))
+            return it->second;
+        auto &table = registry[path];
+        table = nullptr;
+        table = make_shared<TransTable>(path, size_mb);
+        return table;
+    }
+
+    // Начало нового поиска: записи предыдущих поисков становятся старыми и вытесняются первыми
+    void new_search()
+    {
+        head->generation.fetch_add(1, memory_order_relaxed);
+    }
+
+    /**
+     * Поиск записи позиции key
+     * @return false - записи нет или она перезаписана другой позицией
+     */
+    bool probe(const uint64_t key, tt_entry &res) const
+    {
+        uint64_t score_bits, meta;
+        if (read_slot(slots[key & mask], key, score_bits, meta))
+        {
+            res = decode(score_bits, meta);
+            return true;
+        }
+        return false;
+    }
+
+    /**
+     * Сохранение оценки позиции key. Прежняя запись вытесняется, если она
+     * сделана в прошлых поисках или получена не на большей глубине
+     */
+    void store(const uint64_t key, const int draft, const tt_bound bound, const double score, const move_pos &turn)
+    {
+        slot &s = slots[key & mask];
+        const uint32_t age = uint32_t(current_age());
+        const uint64_t old_meta = s.meta.load(memory_order_relaxed);
+        if (old_meta && meta_age(old_meta) == age && meta_draft(old_meta) > draft)
+            return;
+        uint64_t score_bits;
+        memcpy(&score_bits, &score, sizeof(score));
+        const uint64_t meta = encode(draft, bound, age, turn);
+        s.score.store(score_bits, memory_order_relaxed);
+        s.meta.store(meta, memory_order_relaxed);
+        s.check.store(key ^ score_bits ^ meta, memory_order_relaxed);
+    }
+
+    // Число записей
+    size_t size() const
+    {
+        return size_t(head->slot_count);
+    }
+
+    size_t size_mb() const
+    {
+        return size() * sizeof(slot) / (1024 * 1024);
+    }
+
+    // Текущее поколение (номер поиска по модулю 256)
+    int current_age() const
+    {
+        return head->generation.load(memory_order_relaxed) & 0xff;
+    }
+
+    // Запись номер index без проверки ключа (для просмотра таблицы); false - запись пуста
+    bool entry_at(const size_t index, tt_entry &res) const
+    {
+        const uint64_t meta = slots[index].meta.load(memory_order_relaxed);
+        if (!meta)
+            return false;
+        res = decode(slots[index].score.load(memory_order_relaxed), meta);
+        return true;
+    }
+
+    // Очистка записи номер index
+    void clear_at(const size_t index)
+    {
+        slots[index].meta.store(0, memory_order_relaxed);
+        slots[index].score.store(0, memory_order_relaxed);
+        slots[index].check.store(0, memory_order_relaxed);
+    }
+
+  private:
+    void open_file(const size_t requested)
+    {
+#ifdef CHECKERS_TT_MMAP
+        const int fd = open(path.c_str(), requested ? O_RDWR | O_CREAT : O_RDWR, 0666);
+        if (fd < 0)
+            throw runtime_error("can't open transposition table " + path);
+        // Блокировка только на время создания файла, поиск идет без блокировок
+        flock(fd, LOCK_EX);
+        struct stat st;
+        fstat(fd, &st);
+        size_t file_size = size_t(st.st_size);
+        header file_header{};
+        if (file_size >= sizeof(header) && pread(fd, &file_header, sizeof(header), 0) != sizeof(header))
+            file_size = 0;
+        if (file_size == 0)
+        {
+            if (!requested)
+            {
+                flock(fd, LOCK_UN);
+                close(fd);
+                throw runtime_error(path + " is empty");
+            }
+            const size_t count = slot_count(requested);
+            file_size = sizeof(header) + count * sizeof(slot);
+            const header new_header{magic_value, count, {0}, {}};
+            if (ftruncate(fd, off_t(file_size)) != 0 || pwrite(fd, &new_header, sizeof(header), 0) != sizeof(header))
+            {
+                flock(fd, LOCK_UN);
+                close(fd);
+                throw runtime_error("can't create transposition table " + path);
+            }
+        }
+        else if (file_header.magic != magic_value || file_header.slot_count == 0 ||
+                 (file_header.slot_count & (file_header.slot_count - 1)) ||
+                 file_size != sizeof(header) + file_header.slot_count * sizeof(slot))
+        {
+            flock(fd, LOCK_UN);
+            close(fd);
+            throw runtime_error(path + " is not a transposition table");
+        }
+        void *memory = mmap(nullptr, file_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        flock(fd, LOCK_UN);
+        close(fd);
+        if (memory == MAP_FAILED)
+            throw runtime_error("can't map transposition table " + path);
+        base = static_cast<char *>(memory);
+        mapped_size = file_size;
+#else
+        (void)requested;
+        throw runtime_error("file-backed transposition table is not supported on this platform");
+#endif
+    }
+
+    // Число записей - степень двойки не больше requested, индекс записи - младшие биты ключа
+    static size_t slot_count(const size_t requested)
+    {
+        size_t count = 1;
+        while (count * 2 <= requested)
+            count *= 2;
+        return count;
+    }
+
+    // Чтение записи с проверкой ключа
+    static bool read_slot(const slot &s, const uint64_t key, uint64_t &score_bits, uint64_t &meta)
+    {
+        const uint64_t check = s.check.load(memory_order_relaxed);
+        score_bits = s.score.load(memory_order_relaxed);
+        meta = s.meta.load(memory_order_relaxed);
+        return meta && (check ^ score_bits ^ meta) == key;
+    }
+
+    // meta: глубина (8 бит), вид оценки (2), поколение (8), ход: x, y, x2, y2 по 3 бита и признак хода
+    static uint64_t encode(const int draft, const tt_bound bound, const uint32_t age, const move_pos &turn)
+    {
+        uint64_t meta = uint64_t(min(max(draft, 0), 255)) | uint64_t(bound) << 8 | uint64_t(age) << 10;
+        if (turn.x != -1)
+            meta |= (uint64_t(1) | uint64_t(turn.x) << 1 | uint64_t(turn.y) << 4 | uint64_t(turn.x2) << 7 |
+                     uint64_t(turn.y2) << 10)
+                    << 18;
+        return meta;
+    }
+
+    static int meta_draft(const uint64_t meta)
+    {
+        return int(meta & 0xff);
+    }
+
+    static uint32_t meta_age(const uint64_t meta)
+    {
+        return uint32_t(meta >> 10) & 0xff;
+    }
+
+    static tt_entry decode(const uint64_t score_bits, const uint64_t meta)
+    {
+        tt_entry res;
+        memcpy(&res.score, &score_bits, sizeof(res.score));
+        res.draft = meta_draft(meta);
+        res.bound = tt_bound((meta >> 8) & 3);
+        res.age = int(meta_age(meta));
+        const uint64_t turn = meta >> 18;
+        if (turn & 1)
+            res.turn = move_pos(POS_T(turn >> 1 & 7), POS_T(turn >> 4 & 7), POS_T(turn >> 7 & 7), POS_T(turn >> 10 & 7));
+        return res;
+    }
+
+    string path;
+    size_t requested_mb;
+    vector<uint64_t> private_memory; // память таблицы без файла
+    char *base = nullptr;
+    size_t mapped_size = 0;
+    header *head = nullptr;
+    slot *slots = nullptr;
+    uint64_t mask = 0;
+};
@@ -0,0 +1,43 @@
+#pragma once
+
+/**
+ * Вариант шашек: размер доски и особенности правил - константы времени компиляции,
+ * поэтому код, специализированный по варианту, не проверяет их во время игры
+ * @tparam Size клеток по стороне доски
+ * @tparam StartRows рядов с шашками каждой стороны в начальной расстановке
+ * @tparam BackwardCapture простые бьют назад
+ * @tparam MajorityCapture из нескольких взятий обязательно то, что бьет больше фигур
+ * @tparam PromoteInCapture простая, дошедшая до последнего ряда в середине серии взятий, продолжает бить как дамка
+ *         (иначе превращается, только если серия закончилась на последнем ряду)
+ * @tparam FlyingKings дамка ходит и бьет на любое расстояние по диагонали
+ */
+template <int Size, int StartRows, bool BackwardCapture, bool MajorityCapture, bool PromoteInCapture, bool FlyingKings>
+struct variant
+{
+    static constexpr int size = Size;
+    static constexpr int start_rows = StartRows;
+    static constexpr int squares = Size * Size / 2; // темные клетки
+    static constexpr int row_squares = Size / 2;    // темные клетки в ряду
+    static constexpr bool backward_capture = BackwardCapture;
+    static constexpr bool majority_capture = MajorityCapture;
+    static constexpr bool promote_in_capture = PromoteInCapture;
+    static constexpr bool flying_kings = FlyingKings;
+    // Серии взятий с разными путями - разные ходы: ход записывается всеми полями пути (c3:e5:g3).
+    // При правиле большинства ход записывается началом и концом, и такие серии - один ход
+    static constexpr bool path_moves = !MajorityCapture;
+
+    static_assert(Size % 2 == 0 && 2 * StartRows < Size, "invalid board geometry");
+    static_assert(Size * Size / 2 <= 64, "dark squares must fit in a 64-bit board");
+};
+
+// Русские шашки: 8x8, простая бьет назад и превращается в дамку посреди взятия, выбор взятия свободный
+using russian = variant<8, 3, true, false, true, true>;
+// Бразильские шашки: правила международных на доске 8x8
+using brazilian = variant<8, 3, true, true, false, true>;
+// Международные шашки: 10x10, по 20 шашек, обязательно взятие наибольшего числа фигур
+using international = variant<10, 4, true, true, false, true>;
+
+// Вариант, в который играет окно игры (Board, Hand, Logic)
+using game_variant = russian;
+// Клеток по стороне доски игры
+constexpr int board_size = game_variant::size;
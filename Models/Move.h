@@ -1,45 +1,98 @@
 #pragma once
-#include <stdlib.h>  //   int8_t
+#include <stdint.h>  // Для использования int8_t и uint8_t
+#include <string>
 
-//      (8x8
-typedef int8_t POS_T;  // 8-    -128..127
+// Тип для хранения координат на доске(8x8
+typedef int8_t POS_T;  // 8-битное целое со знаком -128..127
 
-// ,    
+// Структура, описывающая ход в игре
 struct move_pos
 {
-    //    
-    POS_T x, y;             // from 
+    // Координаты начальной позиции фигуры
+    POS_T x, y;             // from откуда
 
-    //      
-    POS_T x2, y2;           // to 
+    // Координаты конечной позиции фигуры  
+    POS_T x2, y2;           // to куда
 
-    //     
-    // (-1, -1) -    
-    POS_T xb = -1, yb = -1; // beaten  
+    // Координаты побитой фигуры если есть
+    // (-1, -1) - если ход без взятия
+    POS_T xb = -1, yb = -1; // beaten побитая фигура
 
-    //     
+    // Пустой ход (все координаты -1)
+    move_pos() : x(-1), y(-1), x2(-1), y2(-1)
+    {
+    }
+
+    // Конструктор для обычного хода 
     move_pos(const POS_T x, const POS_T y, const POS_T x2, const POS_T y2)
         : x(x), y(y), x2(x2), y2(y2)
     {
     }
 
-    //      
+    // Конструктор для хода со взятием фигуры
     move_pos(const POS_T x, const POS_T y, const POS_T x2, const POS_T y2,
         const POS_T xb, const POS_T yb)
         : x(x), y(y), x2(x2), y2(y2), xb(xb), yb(yb)
     {
     }
 
-    //    
+    // Оператор сравнения ходов 
     bool operator==(const move_pos& other) const
     {
         return (x == other.x && y == other.y &&
             x2 == other.x2 && y2 == other.y2);
     }
 
-    //  
+    // Оператор неравенства
     bool operator!=(const move_pos& other) const
     {
         return !(*this == other);
     }
-};
\ No newline at end of file
+};
+
+// Название клетки в шахматной нотации (a1 - левый нижний угол со стороны белых)
+inline std::string cell_name(const POS_T x, const POS_T y)
+{
+    return std::string{char('a' + y), char('8' - x)};
+}
+
+// Компактная запись хода для истории партии (5 байт вместо копии доски)
+struct turn_record
+{
+    // Номер клетки x * 8 + y, откуда сделан ход
+    uint8_t from;
+    // Номер клетки, куда сделан ход
+    uint8_t to;
+    // Номер клетки побитой фигуры (no_cell - если ход без взятия)
+    uint8_t beaten;
+    // Тип побитой фигуры (0 - если ход без взятия)
+    uint8_t beaten_type;
+    // Бит 0 - превращение в дамку, бит 1 - обратимый ход (дамкой без взятия),
+    // остальные биты - номер хода в серии взятий
+    uint8_t flags;
+
+    static constexpr uint8_t no_cell = 0xFF;
+
+    bool is_promotion() const
+    {
+        return flags & 1;
+    }
+
+    bool is_reversible() const
+    {
+        return flags & 2;
+    }
+
+    int beat_series() const
+    {
+        return flags >> 2;
+    }
+
+    // Восстановление хода в виде move_pos
+    move_pos to_move() const
+    {
+        if (beaten == no_cell)
+            return move_pos(from / 8, from % 8, to / 8, to % 8);
+        return move_pos(from / 8, from % 8, to / 8, to % 8, beaten / 8, beaten % 8);
+    }
+};
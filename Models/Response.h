@@ -1,11 +1,12 @@
 #pragma once
 
-//     
+// Перечисление возможных действий в игре
 enum class Response
 {
-    OK,     //    
-    BACK,   //     
-    REPLAY, //   
-    QUIT,   //  
-    CELL    // ,       
+    OK,     // Успешное выполнение действия 
+    BACK,   // возврат к предыдущему ходу 
+    REPLAY, // перезапуск игры 
+    QUIT,   //выход из игры
+    CELL,   // Указывает, что был выбран конкретный элемент на поле
+    TIMEOUT // истекло время игрока на часах партии
 };
@@ -0,0 +1,103 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <stdint.h>
+#include <vector>
+
+#include "Move.h"
+
+using namespace std;
+
+// Счетчики одного поиска лучшего хода
+struct search_stats
+{
+    uint64_t nodes = 0;     // посещенные позиции
+    uint64_t leaves = 0;    // позиции, оцененные calc_score
+    uint64_t cutoffs = 0;   // альфа-бета отсечения
+    uint64_t tt_hits = 0;   // попадания в таблицу транспозиций
+    uint64_t expanded = 0;  // позиции, для которых генерировались ходы
+    uint64_t generated = 0; // сгенерированные ходы
+    uint64_t eval_cache_hits = 0;   // оценки простых в листьях из кэша (Bot.EvalCache)
+    uint64_t eval_cache_misses = 0; // оценки простых в листьях, посчитанные заново
+    uint64_t endgame_hits = 0;      // позиции, оцененные распознавателями эндшпиля
+    int depth = 0;          // глубина перебора в ходах
+    double score = 0;       // оценка выбранного хода
+    double time_ms = 0;     // время поиска
+
+    // Позиций в секунду
+    double nps() const
+    {
+        return time_ms > 0 ? nodes * 1000.0 / time_ms : 0;
+    }
+
+    // Средний коэффициент ветвления
+    double branching() const
+    {
+        return expanded ? double(generated) / expanded : 0;
+    }
+};
+
+// Вариант анализа: ход из корня, его оценка и ожидаемое продолжение
+struct pv_line
+{
+    double score = 0;       // оценка с точки зрения стороны, которая ходит в корне
+    size_t turn_length = 0; // число прыжков хода из корня в начале moves (больше 1 - серия взятий)
+    vector<move_pos> moves; // ход из корня и продолжение, каждый прыжок - отдельный элемент
+
+    // Ход из корня
+    vector<move_pos> turn() const
+    {
+        return vector<move_pos>(moves.begin(), moves.begin() + turn_length);
+    }
+};
+
+// Состояние идущего поиска для отображения поверх доски
+struct search_info
+{
+    int depth = 0;          // глубина перебора в ходах
+    uint64_t nodes = 0;     // посещенные позиции
+    double nps = 0;         // позиций в секунду
+    double elapsed_ms = 0;  // время с начала поиска
+    vector<move_pos> pv;    // лучшая найденная цепочка ходов
+};
+
+// Счетчики, которые поиск публикует для других потоков.
+// Поиск обращается к ним, только если указатель на объект задан
+struct search_progress
+{
+    atomic<int> depth{0};
+    atomic<uint64_t> nodes{0};
+
+    void set_pv(const vector<move_pos> &turns)
+    {
+        lock_guard<mutex> lock(pv_mutex);
+        pv = turns;
+    }
+
+    // Снимок состояния поиска, начатого в момент start
+    search_info info(const chrono::steady_clock::time_point start)
+    {
+        search_info res;
+        res.depth = depth.load(memory_order_relaxed);
+        res.nodes = nodes.load(memory_order_relaxed);
+        res.elapsed_ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        res.nps = res.elapsed_ms > 0 ? res.nodes * 1000.0 / res.elapsed_ms : 0;
+        lock_guard<mutex> lock(pv_mutex);
+        res.pv = pv;
+        return res;
+    }
+
+  private:
+    mutex pv_mutex;
+    vector<move_pos> pv;
+};
+
+// Ограничения поиска с итеративным углублением
+struct search_limits
+{
+    int depth = -1;                    // максимальный уровень (глубина - 1), -1 - уровень бота
+    double time_ms = 0;                // время на поиск, 0 - без ограничения
+    uint64_t nodes = 0;                // число позиций, 0 - без ограничения
+    const atomic<bool> *stop = nullptr; // внешний флаг остановки
+};
@@ -0,0 +1,113 @@
+#pragma once
+#include <string>
+
+using namespace std;
+
+// Функция оценки позиции ботом
+enum class ScoringType
+{
+    NumberOnly,         // только количество шашек
+    NumberAndPotential, // количество шашек и их продвижение
+    NumberAndStructure  // количество шашек и структура простых: продвижение, охрана последнего ряда, связки
+};
+
+// Уровень оптимизации перебора
+enum class Optimization
+{
+    O0, // полный перебор
+    O1, // отсечение худших ветвей
+    O2  // (временно недоступен) работает как O1
+};
+
+// Алгоритм поиска хода бота
+enum class EngineType
+{
+    AlphaBeta, // перебор с альфа-бета отсечением (Logic)
+    Mcts       // поиск по дереву Монте-Карло (Mcts)
+};
+
+// Что задает уровень бота (WhiteBotLevel, BlackBotLevel)
+enum class Difficulty
+{
+    Depth, // глубина перебора: время хода зависит от позиции
+    Budget // бюджет позиций на ход и шум оценки (Levels.h): время хода ограничено
+};
+
+// Формула выбора хода в дереве Монте-Карло
+enum class MctsPolicy
+{
+    UCT,  // средний результат и бонус за малое число посещений
+    PUCT  // то же с априорными вероятностями ходов по calc_score
+};
+
+// Разобранные и проверенные настройки из settings.json.
+// Снимок не изменяется после создания, при перезагрузке файла создается новый
+struct Settings
+{
+    // WindowSize
+    unsigned int width = 0;
+    unsigned int height = 0;
+
+    // Bot, индексы массивов - цвет (0 - белые, 1 - черные)
+    bool is_bot[2] = {false, true};
+    int bot_level[2] = {0, 5};
+    ScoringType scoring = ScoringType::NumberAndPotential;
+    bool eval_cache = true; // оценка листьев без обхода доски с кэшем оценки простых (NumberAndPotential, NumberAndStructure)
+    bool endgame = true;    // распознаватели эндшпиля: точные ничьи и оценки известных окончаний
+    unsigned int bot_delay_ms = 0;
+    bool no_random = false;
+    Optimization optimization = Optimization::O1;
+    bool search_overlay = false; // статистика поиска поверх доски
+    EngineType engine = EngineType::AlphaBeta;
+    Difficulty difficulty = Difficulty::Depth;
+
+    // Animation
+    unsigned int animation_fps = 60;      // кадров в секунду при анимации хода бота
+    unsigned int animation_move_ms = 150; // длительность одного прыжка, 0 - ходы без анимации
+
+    // Mcts
+    MctsPolicy mcts_policy = MctsPolicy::UCT;
+    unsigned int mcts_threads = 1;        // потоки, строящие одно дерево
+    unsigned int mcts_time_ms = 1000;     // время на ход
+    unsigned int mcts_playouts = 0;       // число симуляций на ход, 0 - ограничение только по времени
+    double mcts_exploration = 1.4;        // вес бонуса за исследование
+    bool mcts_eval_rollouts = false;      // симуляции выбирают ходы по calc_score вместо случайных
+    unsigned int mcts_rollout_turns = 40; // длина симуляции, после нее позиция оценивается calc_score
+    unsigned int mcts_memory_mb = 64;     // память под узлы дерева
+
+    // Hint
+    bool hint = false; // подсказка лучшего хода игроку
+    int hint_level = 0; // уровень поиска подсказки, 0 - на один больше уровня бота соперника
+
+    // Game
+    int max_turns = 120;
+    int repetition_draw = 3;
+    unsigned int no_progress_turns = 30;
+    string pdn_file = "games.pdn"; // законченные партии дописываются в этот файл, пустая строка - не сохранять
+
+    // Clock
+    unsigned int clock_base_ms = 0;      // основное время каждой стороны, 0 - партия без часов
+    unsigned int clock_increment_ms = 0; // добавка за каждый ход
+
+    // Solver
+    bool solver = false;                 // бот решает эндшпиль до конца партии перед поиском
+    unsigned int solver_max_pieces = 6;  // решаются позиции, где фигур не больше
+    unsigned int solver_threads = 1;     // потоки решателя с общей таблицей узлов
+    unsigned int solver_memory_mb = 64;  // память таблицы узлов
+    unsigned int solver_nodes = 1000000; // позиций на одно решение, 0 - без ограничения
+
+    // TranspositionTable
+    unsigned int tt_size_mb = 0; // размер новой таблицы транспозиций, 0 - таблица отключена
+    string tt_file;              // файл таблицы (в /dev/shm - общая память процессов), пустая строка - память процесса
+
+    // AnalysisCache
+    string cache_file;                // журнал кэша анализа (индекс - в файле с суффиксом .idx), пустая строка - кэш отключен
+    unsigned int cache_min_depth = 6; // записываются анализы не мельче этой глубины
+
+    // Telemetry
+    string telemetry_file; // файл телеметрии (например, "telemetry.jsonl"), пустая строка - телеметрия отключена
+
+    // Trace (действует только в сборке с CHECKERS_TRACE)
+    string trace_file;                  // пустая строка - трассировка отключена
+    unsigned int trace_sample_rate = 64; // частые участки записываются один раз на столько вызовов
+};
@@ -0,0 +1,187 @@
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+#include "Game/Logic.h"
+#include "Game/Notation.h"
+#include "Game/Pdn.h"
+
+// Пакетный анализ партий: analyze <in.pdn> <out.pdn> [--depth D] [--threads N] [--hash MB] [--hash-file PATH]
+// [--cache PATH].
+// Партии читаются потоком, анализируются параллельно и записываются в исходном порядке.
+// Одновременно в памяти находится не больше window партий, поэтому размер архива не ограничен.
+// Потоки ищут в общей таблице транспозиций; с --hash-file таблица общая и для нескольких процессов.
+// С --cache позиции, уже проанализированные на эту глубину, берутся из кэша анализа, новые анализы записываются в него
+
+int depth = 6;
+int threads = int(thread::hardware_concurrency());
+unsigned int hash_mb = 0;
+string hash_file;
+string cache_file;
+
+mutex pipeline_mutex;
+condition_variable pipeline_cv;
+deque<pair<size_t, pdn::game_record>> jobs; // прочитанные, но не проанализированные партии
+map<size_t, pdn::game_record> done;         // проанализированные, но не записанные партии
+size_t read_count = 0, written_count = 0;
+bool is_read_done = false;
+
+// Анализ каждой позиции партии: оценка и лучший ход добавляются в комментарий к ходу
+void analyze_game(Logic &logic, pdn::game_record &game)
+{
+    vector<vector<POS_T>> mtx = notation::start_position();
+    bool color = false;
+    const string fen = game.tag("FEN");
+    if (!fen.empty() && !notation::parse_fen(fen, mtx, color))
+    {
+        game.set_tag("Annotator", "Checkers: invalid FEN");
+        return;
+    }
+    History history;
+    history.reset(mtx, color);
+    search_limits limits;
+    limits.depth = depth;
+    for (size_t i = 0; i < game.moves.size(); ++i)
+    {
+        const auto chain = notation::parse_chain(logic, mtx, color, game.moves[i]);
+        string &comment = game.comments[i];
+        if (chain.empty())
+        {
+            comment += string(comment.empty() ? "" : " ") + "illegal move";
+            break;
+        }
+        const auto best = logic.search(mtx, history, color, limits);
+        ostringstream note;
+        note << "eval " << fixed << setprecision(3) << logic.stats.score;
+        if (notation::chain_to_string(best) != notation::chain_to_string(chain))
+            note << " best " << notation::chain_to_string(best);
+        comment += (comment.empty() ? "" : " ") + note.str();
+        notation::apply_chain(mtx, history, chain);
+        color = !color;
+    }
+    game.set_tag("Annotator", "Checkers depth " + to_string(depth));
+}
+
+void worker()
+{
+    Settings settings;
+    settings.no_random = true;
+    settings.tt_size_mb = hash_mb;
+    settings.tt_file = hash_file;
+    settings.cache_file = cache_file;
+    settings.cache_min_depth = 0;
+    Logic logic(settings);
+    while (true)
+    {
+        pair<size_t, pdn::game_record> job;
+        {
+            unique_lock<mutex> lock(pipeline_mutex);
+            pipeline_cv.wait(lock, [] { return is_read_done || !jobs.empty(); });
+            if (jobs.empty())
+                return;
+            job = move(jobs.front());
+            jobs.pop_front();
+        }
+        analyze_game(logic, job.second);
+        {
+            lock_guard<mutex> lock(pipeline_mutex);
+            done.emplace(job.first, move(job.second));
+        }
+        pipeline_cv.notify_all();
+    }
+}
+
+// Запись проанализированных партий строго по порядку
+void writer(ostream &out)
+{
+    while (true)
+    {
+        pdn::game_record game;
+        {
+            unique_lock<mutex> lock(pipeline_mutex);
+            pipeline_cv.wait(lock, [] {
+                return done.count(written_count) || (is_read_done && written_count == read_count);
+            });
+            if (!done.count(written_count))
+                return;
+            game = move(done[written_count]);
+            done.erase(written_count);
+        }
+        pdn::write(out, game);
+        {
+            lock_guard<mutex> lock(pipeline_mutex);
+            ++written_count;
+        }
+        pipeline_cv.notify_all();
+        if (written_count % 100 == 0)
+            cerr << "analyzed " << written_count << " games" << endl;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 3)
+    {
+        cerr << "usage: analyze <in.pdn> <out.pdn> [--depth D] [--threads N] [--hash MB] [--hash-file PATH] "
+                "[--cache PATH]"
+             << endl;
+        return 1;
+    }
+    for (int i = 3; i + 1 < argc; i += 2)
+    {
+        if (!strcmp(argv[i], "--depth"))
+            depth = max(0, atoi(argv[i + 1]));
+        else if (!strcmp(argv[i], "--threads"))
+            threads = max(1, atoi(argv[i + 1]));
+        else if (!strcmp(argv[i], "--hash"))
+            hash_mb = unsigned(max(0, atoi(argv[i + 1])));
+        else if (!strcmp(argv[i], "--hash-file"))
+            hash_file = argv[i + 1];
+        else if (!strcmp(argv[i], "--cache"))
+            cache_file = argv[i + 1];
+    }
+    // Файл без размера: таблица открывается с размером существующего файла или 64 МБ
+    if (!hash_file.empty() && !hash_mb)
+        hash_mb = 64;
+    ifstream fin(argv[1]);
+    ofstream fout(argv[2]);
+    if (!fin || !fout)
+    {
+        cerr << "Error: can't open " << (fin ? argv[2] : argv[1]) << endl;
+        return 1;
+    }
+    const size_t window = size_t(threads) * 4;
+    vector<thread> workers;
+    for (int i = 0; i < threads; ++i)
+        workers.emplace_back(worker);
+    thread output(writer, ref(fout));
+
+    pdn::Reader reader(fin);
+    pdn::game_record game;
+    while (reader.next(game))
+    {
+        unique_lock<mutex> lock(pipeline_mutex);
+        // Чтение ждет, пока партий в работе не станет меньше window
+        pipeline_cv.wait(lock, [window] { return read_count - written_count < window; });
+        jobs.emplace_back(read_count++, move(game));
+        lock.unlock();
+        pipeline_cv.notify_all();
+    }
+    {
+        lock_guard<mutex> lock(pipeline_mutex);
+        is_read_done = true;
+    }
+    pipeline_cv.notify_all();
+    for (auto &t : workers)
+        t.join();
+    output.join();
+    cerr << "analyzed " << written_count << " games" << endl;
+    return 0;
+}
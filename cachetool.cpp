@@ -0,0 +1,108 @@
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <map>
+
+#include "Game/AnalysisCache.h"
+#include "Game/Logic.h"
+#include "Game/Notation.h"
+
+// Обслуживание кэша анализа: cachetool <file> [stats | compact | prepare PLIES DEPTH].
+// stats - позиции по глубине анализа, размер журнала и доля мусора; compact - сжатие журнала;
+// prepare - подготовка дебютов: все позиции после не больше PLIES ходов от начальной расстановки
+// анализируются на DEPTH уровней и записываются в кэш (уже проанализированные берутся из кэша)
+
+void print_stats(const AnalysisCache &cache)
+{
+    map<int, size_t> depths;
+    for (size_t i = 0; i < cache.capacity(); ++i)
+    {
+        const int depth = cache.depth_at(i);
+        if (depth >= 0)
+            ++depths[depth];
+    }
+    cout << fixed << setprecision(1);
+    cout << "positions " << cache.size() << ", index " << cache.capacity() << " slots ("
+         << cache.size() * 100.0 / cache.capacity() << "% used)\n";
+    cout << "log " << cache.log_bytes() << " bytes, live " << cache.live_bytes() << ", garbage "
+         << cache.garbage_bytes() << " (" << cache.garbage_bytes() * 100.0 / cache.log_bytes() << "%)\n";
+    cout << "depth:";
+    for (const auto &d : depths)
+        cout << " " << d.first << ":" << d.second;
+    cout << "\n";
+}
+
+// Анализ всех позиций до plies ходов; возвращает число проанализированных позиций
+size_t prepare(Logic &logic, const vector<vector<POS_T>> &mtx, History &history, const bool color, const int plies,
+               const int depth)
+{
+    const auto chains = logic.turn_chains(color, mtx);
+    if (chains.empty())
+        return 0;
+    search_limits limits;
+    limits.depth = depth - 1;
+    logic.search(mtx, history, color, limits);
+    size_t res = 1;
+    if (plies == 0)
+        return res;
+    for (const auto &chain : chains)
+    {
+        auto next = mtx;
+        notation::apply_chain(next, history, chain);
+        res += prepare(logic, next, history, !color, plies - 1, depth);
+        for (size_t i = 0; i < chain.size(); ++i)
+            history.undo(next);
+    }
+    return res;
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2)
+    {
+        cerr << "usage: cachetool <file> [stats | compact | prepare PLIES DEPTH]" << endl;
+        return 1;
+    }
+    const string command = argc > 2 ? argv[2] : "stats";
+    try
+    {
+        if (command == "stats")
+            print_stats(AnalysisCache(argv[1]));
+        else if (command == "compact")
+        {
+            AnalysisCache cache(argv[1]);
+            const uint64_t before = cache.log_bytes();
+            cache.compact();
+            cout << "log " << before << " -> " << cache.log_bytes() << " bytes" << endl;
+        }
+        else if (command == "prepare" && argc > 4)
+        {
+            Settings settings;
+            settings.no_random = true;
+            settings.cache_file = argv[1];
+            settings.cache_min_depth = 0;
+            const auto cache = AnalysisCache::shared(argv[1]);
+            Logic logic(settings);
+            const auto start = chrono::steady_clock::now();
+            const auto mtx = notation::start_position();
+            History history;
+            history.reset(mtx, false);
+            const size_t count = prepare(logic, mtx, history, false, max(0, atoi(argv[3])), max(1, atoi(argv[4])));
+            const double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+            cout << "positions " << count << ", from cache " << cache->hits << ", analyzed " << cache->stores
+                 << ", time " << fixed << setprecision(1) << seconds << " s" << endl;
+        }
+        else
+        {
+            cerr << "usage: cachetool <file> [stats | compact | prepare PLIES DEPTH]" << endl;
+            return 1;
+        }
+    }
+    catch (const exception &e)
+    {
+        cerr << "Error: " << e.what() << endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,18 @@
+#include "Game/Engine.h"
+
+// checkers-engine [команда] - без аргументов читает команды из stdin,
+// иначе выполняет одну команду (например, "bench depth 8 json bench.json") и завершается
+int main(int argc, char* argv[])
+{
+    ios::sync_with_stdio(false);
+    Engine engine;
+    if (argc > 1)
+    {
+        string line;
+        for (int i = 1; i < argc; ++i)
+            line += string(i > 1 ? " " : "") + argv[i];
+        engine.command(line);
+        return 0;
+    }
+    return engine.run();
+}
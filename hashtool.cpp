@@ -0,0 +1,100 @@
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <map>
+
+#include "Game/TransTable.h"
+
+// Обслуживание файла таблицы транспозиций: hashtool <file> [stats | age N | clear].
+// stats - заполненность, записи по виду оценки, глубине и возрасту; age N - удаление записей,
+// сделанных N и более поисков назад; clear - удаление всех записей.
+// Таблицу можно обслуживать, пока ее используют другие процессы
+
+// Возраст записи: сколько поисков назад она сделана (поколение хранится по модулю 256)
+int entry_age(const TransTable &table, const tt_entry &entry)
+{
+    return (table.current_age() - entry.age) & 0xff;
+}
+
+void print_stats(const TransTable &table)
+{
+    size_t used = 0;
+    size_t bounds[4] = {0, 0, 0, 0};
+    map<int, size_t> drafts, ages;
+    tt_entry entry;
+    for (size_t i = 0; i < table.size(); ++i)
+    {
+        if (!table.entry_at(i, entry))
+            continue;
+        ++used;
+        ++bounds[int(entry.bound)];
+        ++drafts[entry.draft];
+        // Возраст группируется по степеням двойки: 0, 1, 2-3, 4-7, ...
+        const int age = entry_age(table, entry);
+        int group = 0;
+        while ((1 << group) <= age)
+            ++group;
+        ++ages[group];
+    }
+    cout << fixed << setprecision(1);
+    cout << "entries " << table.size() << " (" << table.size_mb() << " MB), used " << used << " ("
+         << (table.size() ? used * 100.0 / table.size() : 0) << "%), generation " << table.current_age() << "\n";
+    cout << "exact " << bounds[int(tt_bound::exact)] << ", lower " << bounds[int(tt_bound::lower)] << ", upper "
+         << bounds[int(tt_bound::upper)] << "\n";
+    cout << "draft:";
+    for (const auto &d : drafts)
+        cout << " " << d.first << ":" << d.second;
+    cout << "\nage (searches ago):";
+    for (const auto &a : ages)
+    {
+        const int low = a.first ? 1 << (a.first - 1) : 0;
+        const int high = a.first ? (1 << a.first) - 1 : 0;
+        cout << " " << low;
+        if (high != low)
+            cout << "-" << high;
+        cout << ":" << a.second;
+    }
+    cout << "\n";
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2)
+    {
+        cerr << "usage: hashtool <file> [stats | age N | clear]" << endl;
+        return 1;
+    }
+    const string command = argc > 2 ? argv[2] : "stats";
+    try
+    {
+        TransTable table(argv[1], 0);
+        if (command == "stats")
+            print_stats(table);
+        else if ((command == "age" && argc > 3) || command == "clear")
+        {
+            const int max_age = command == "clear" ? 0 : max(0, atoi(argv[3]));
+            size_t removed = 0;
+            tt_entry entry;
+            for (size_t i = 0; i < table.size(); ++i)
+            {
+                if (table.entry_at(i, entry) && entry_age(table, entry) >= max_age)
+                {
+                    table.clear_at(i);
+                    ++removed;
+                }
+            }
+            cout << "removed " << removed << " entries" << endl;
+        }
+        else
+        {
+            cerr << "usage: hashtool <file> [stats | age N | clear]" << endl;
+            return 1;
+        }
+    }
+    catch (const exception &e)
+    {
+        cerr << "Error: " << e.what() << endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,158 @@
+#include <algorithm>
+#include <arpa/inet.h>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <netinet/in.h>
+#include <string>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using namespace std;
+
+// Нагрузочный клиент для server: clients соединений, в каждом games партий бот против бота.
+// Измеряется задержка каждого запроса хода бота (от отправки до ответа)
+// loadgen [--socket PATH | --port N] [--clients N] [--games N] [--turns N] [--level L] [--budget MS] [--nodes N]
+
+string socket_path = "/tmp/checkers.sock";
+int port = 0, clients = 8, games = 4, max_turns = 120, level = 5;
+double budget_ms = 100;
+unsigned long long nodes = 0; // бюджет позиций на ход бота, 0 - по уровню сервера
+
+mutex result_mutex;
+vector<double> latencies;
+int errors = 0;
+
+int connect_server()
+{
+    if (port)
+    {
+        const int fd = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(uint16_t(port));
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        return connect(fd, (sockaddr *)&addr, sizeof(addr)) ? -1 : fd;
+    }
+    const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    socket_path.copy(addr.sun_path, sizeof(addr.sun_path) - 1);
+    return connect(fd, (sockaddr *)&addr, sizeof(addr)) ? -1 : fd;
+}
+
+// Отправка команды и ожидание одной строки ответа
+string request(const int fd, string &buffer, const string &line)
+{
+    const string data = line + '\n';
+    if (send(fd, data.data(), data.size(), MSG_NOSIGNAL) != ssize_t(data.size()))
+        return "";
+    size_t end;
+    char chunk[4096];
+    while ((end = buffer.find('\n')) == string::npos)
+    {
+        const ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+        if (n <= 0)
+            return "";
+        buffer.append(chunk, size_t(n));
+    }
+    string res = buffer.substr(0, end);
+    buffer.erase(0, end + 1);
+    return res;
+}
+
+void client()
+{
+    const int fd = connect_server();
+    if (fd < 0)
+    {
+        lock_guard<mutex> lock(result_mutex);
+        ++errors;
+        return;
+    }
+    string buffer;
+    vector<double> local;
+    int local_errors = 0;
+    for (int g = 0; g < games; ++g)
+    {
+        const string reply = request(fd, buffer,
+                                     "new level " + to_string(level) + " budget " + to_string(budget_ms) +
+                                         (nodes ? " nodes " + to_string(nodes) : string()));
+        if (reply.rfind("session ", 0) != 0)
+        {
+            ++local_errors;
+            break;
+        }
+        const string id = reply.substr(8);
+        for (int turn = 0; turn < max_turns; ++turn)
+        {
+            auto start = chrono::steady_clock::now();
+            const string move = request(fd, buffer, "bot " + id);
+            local.push_back(chrono::duration<double, milli>(chrono::steady_clock::now() - start).count());
+            if (move.rfind("bestmove ", 0) != 0)
+            {
+                ++local_errors;
+                break;
+            }
+            // Конец партии: ходов нет или ничья
+            if (move.find(" none") != string::npos || move.find(" draw") != string::npos)
+                break;
+        }
+        request(fd, buffer, "close " + id);
+    }
+    close(fd);
+    lock_guard<mutex> lock(result_mutex);
+    latencies.insert(latencies.end(), local.begin(), local.end());
+    errors += local_errors;
+}
+
+double percentile(const vector<double> &sorted, const double p)
+{
+    if (sorted.empty())
+        return 0;
+    const size_t index = min(sorted.size() - 1, size_t(p * double(sorted.size() - 1) + 0.5));
+    return sorted[index];
+}
+
+int main(int argc, char* argv[])
+{
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        if (!strcmp(argv[i], "--socket"))
+            socket_path = argv[i + 1];
+        else if (!strcmp(argv[i], "--port"))
+            port = atoi(argv[i + 1]);
+        else if (!strcmp(argv[i], "--clients"))
+            clients = atoi(argv[i + 1]);
+        else if (!strcmp(argv[i], "--games"))
+            games = atoi(argv[i + 1]);
+        else if (!strcmp(argv[i], "--turns"))
+            max_turns = atoi(argv[i + 1]);
+        else if (!strcmp(argv[i], "--level"))
+            level = atoi(argv[i + 1]);
+        else if (!strcmp(argv[i], "--budget"))
+            budget_ms = atof(argv[i + 1]);
+        else if (!strcmp(argv[i], "--nodes"))
+            nodes = strtoull(argv[i + 1], nullptr, 10);
+    }
+    auto start = chrono::steady_clock::now();
+    vector<thread> threads;
+    for (int i = 0; i < clients; ++i)
+        threads.emplace_back(client);
+    for (auto &t : threads)
+        t.join();
+    const double total_s = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    sort(latencies.begin(), latencies.end());
+    cout << fixed << setprecision(1);
+    cout << "requests " << latencies.size() << " errors " << errors << " time " << total_s << " s"
+         << " throughput " << double(latencies.size()) / max(total_s, 1e-9) << " req/s" << endl;
+    cout << "latency ms p50 " << percentile(latencies, 0.5) << " p90 " << percentile(latencies, 0.9) << " p99 "
+         << percentile(latencies, 0.99) << " max " << (latencies.empty() ? 0 : latencies.back()) << endl;
+    return errors ? 1 : 0;
+}
@@ -0,0 +1,133 @@
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <random>
+
+#include "Game/Endgame.h"
+#include "Game/History.h"
+#include "Game/Logic.h"
+#include "Game/Mcts.h"
+#include "Game/Notation.h"
+
+// Матч поиска по дереву Монте-Карло против перебора с альфа-бета отсечением при равном времени на ход:
+// match [--games N] [--time MS] [--threads N] [--policy UCT|PUCT] [--eval-rollouts] [--turns N] [--opening N].
+// Перебор идет в одном потоке с итеративным углублением, Mcts - в --threads потоках (по умолчанию 1,
+// тогда у обоих движков одинаковое процессорное время). Каждый дебют играется дважды со сменой цветов
+
+int games = 10;
+double time_ms = 200;
+int max_turns = 120;
+int opening_turns = 4;
+
+// Случайный дебют из opening_turns ходов от начальной расстановки
+void make_opening(mt19937 &rng, Logic &logic, vector<vector<POS_T>> &mtx, History &history, bool &color)
+{
+    mtx = notation::start_position();
+    color = false;
+    history.reset(mtx, color);
+    for (int i = 0; i < opening_turns; ++i)
+    {
+        const auto chains = logic.turn_chains(color, mtx);
+        if (chains.empty())
+            return;
+        notation::apply_chain(mtx, history, chains[rng() % chains.size()]);
+        color = !color;
+    }
+}
+
+/**
+ * Партия из позиции mtx
+ * @param mcts_color цвет Mcts
+ * @return 1 - победа Mcts, 0 - поражение, 0.5 - ничья
+ */
+double play(const Settings &settings, vector<vector<POS_T>> mtx, History history, bool color, const bool mcts_color,
+            uint64_t &ab_nodes, double &ab_time, uint64_t &playouts, int &mcts_turns)
+{
+    Logic logic(settings);
+    Mcts mcts(settings);
+    for (int turn = 0; turn < max_turns; ++turn)
+    {
+        if (history.repetitions() >= 3 ||
+            (settings.no_progress_turns && history.reversible_turns() >= settings.no_progress_turns))
+            return 0.5;
+        // Теоретическая ничья засчитывается сразу, не доигрываясь до правила ходов без прогресса
+        if (settings.endgame && Endgame::is_known_draw(mtx, color))
+            return 0.5;
+        search_limits limits;
+        limits.time_ms = time_ms;
+        vector<move_pos> best;
+        if (color == mcts_color)
+        {
+            best = mcts.search(mtx, history, color, limits);
+            playouts += mcts.playout_count();
+            ++mcts_turns;
+        }
+        else
+        {
+            limits.depth = 63;
+            best = logic.search(mtx, history, color, limits);
+            ab_nodes += logic.stats.nodes;
+            ab_time += logic.stats.time_ms;
+        }
+        if (best.empty())
+            return color == mcts_color ? 0 : 1;
+        notation::apply_chain(mtx, history, best);
+        color = !color;
+    }
+    return 0.5;
+}
+
+int main(int argc, char* argv[])
+{
+    Settings settings;
+    settings.mcts_threads = 1;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (!strcmp(argv[i], "--eval-rollouts"))
+            settings.mcts_eval_rollouts = true;
+        else if (i + 1 >= argc)
+            break;
+        else if (!strcmp(argv[i], "--games"))
+            games = max(1, atoi(argv[++i]));
+        else if (!strcmp(argv[i], "--time"))
+            time_ms = max(1.0, atof(argv[++i]));
+        else if (!strcmp(argv[i], "--threads"))
+            settings.mcts_threads = max(1, atoi(argv[++i]));
+        else if (!strcmp(argv[i], "--policy"))
+            settings.mcts_policy = !strcmp(argv[++i], "PUCT") ? MctsPolicy::PUCT : MctsPolicy::UCT;
+        else if (!strcmp(argv[i], "--turns"))
+            max_turns = max(1, atoi(argv[++i]));
+        else if (!strcmp(argv[i], "--opening"))
+            opening_turns = max(0, atoi(argv[++i]));
+    }
+
+    mt19937 rng(2024);
+    Logic opening_logic(settings);
+    double score = 0;
+    int wins = 0, draws = 0, losses = 0;
+    uint64_t ab_nodes = 0, playouts = 0;
+    double ab_time = 0;
+    int mcts_turns = 0;
+    vector<vector<POS_T>> mtx;
+    History history;
+    bool color = false;
+    for (int game = 0; game < games; ++game)
+    {
+        if (game % 2 == 0)
+            make_opening(rng, opening_logic, mtx, history, color);
+        const bool mcts_color = game % 2;
+        const double res = play(settings, mtx, history, color, mcts_color, ab_nodes, ab_time, playouts, mcts_turns);
+        score += res;
+        wins += res == 1;
+        draws += res == 0.5;
+        losses += res == 0;
+        cout << "game " << game + 1 << ": mcts " << (mcts_color ? "black" : "white") << ", "
+             << (res == 1 ? "mcts wins" : res == 0 ? "alpha-beta wins" : "draw") << endl;
+    }
+    cout << fixed << setprecision(1) << "mcts " << wins << " wins, " << draws << " draws, " << losses
+         << " losses, score " << score * 100 / games << "%\n";
+    cout << "alpha-beta " << uint64_t(ab_time > 0 ? ab_nodes * 1000.0 / ab_time : 0) << " nodes/s, mcts "
+         << (mcts_turns ? playouts / mcts_turns : 0) << " playouts/move on " << settings.mcts_threads
+         << " thread(s), " << time_ms << " ms/move\n";
+    return 0;
+}
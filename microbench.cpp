@@ -0,0 +1,534 @@
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+#ifdef __linux__
+    #include <linux/perf_event.h>
+    #include <sys/ioctl.h>
+    #include <sys/syscall.h>
+    #include <unistd.h>
+#endif
+
+#include "Game/Bench.h"
+#include "Game/Board.h"
+#include "Game/Endgame.h"
+#include "Game/Logic.h"
+#include "Game/Notation.h"
+
+// Замеры отдельных функций движка: microbench [--time MS] [--filter ТЕКСТ] [--check N].
+// Для каждой функции выводятся ns/op, выделения памяти на операцию
+// и промахи кеша на операцию (через perf_event, если он доступен).
+// search/Potential и search/Structure - перебор с оценкой листьев NumberAndPotential и NumberAndStructure
+// без кэша оценки простых (обход доски в каждом листе) и с ним, операция - один лист;
+// после замера с кэшем выводится доля попаданий в кэш во всех переборах замера
+// --check N - сверка генератора ходов с пошаговым обходом диагоналей на N случайных позициях
+// и проверка распознавателей эндшпиля на позициях с известным исходом
+
+// Счетчик выделений памяти: глобальные operator new и delete заменены только в этой программе.
+// Заменены все обычные формы (одиночные и массивы, с размером и nothrow), и все они выделяют
+// и освобождают память одной парой функций, поэтому new и delete любой формы согласованы
+static atomic<uint64_t> allocations{0};
+
+// Выделение и освобождение не встраиваются в места вызова: компилятор видит только пару
+// operator new / operator delete и не сравнивает ее с malloc и free внутри
+[[gnu::noinline]] static void *counted_alloc(const size_t size) noexcept
+{
+    allocations.fetch_add(1, memory_order_relaxed);
+    return malloc(size ? size : 1);
+}
+
+[[gnu::noinline]] static void counted_free(void *ptr) noexcept
+{
+    free(ptr);
+}
+
+void *operator new(size_t size)
+{
+    if (void *ptr = counted_alloc(size))
+        return ptr;
+    throw bad_alloc();
+}
+
+void *operator new[](size_t size)
+{
+    if (void *ptr = counted_alloc(size))
+        return ptr;
+    throw bad_alloc();
+}
+
+void *operator new(size_t size, const nothrow_t &) noexcept
+{
+    return counted_alloc(size);
+}
+
+void *operator new[](size_t size, const nothrow_t &) noexcept
+{
+    return counted_alloc(size);
+}
+
+void operator delete(void *ptr) noexcept
+{
+    counted_free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept
+{
+    counted_free(ptr);
+}
+
+void operator delete(void *ptr, size_t) noexcept
+{
+    counted_free(ptr);
+}
+
+void operator delete[](void *ptr, size_t) noexcept
+{
+    counted_free(ptr);
+}
+
+void operator delete(void *ptr, const nothrow_t &) noexcept
+{
+    counted_free(ptr);
+}
+
+void operator delete[](void *ptr, const nothrow_t &) noexcept
+{
+    counted_free(ptr);
+}
+
+// Аппаратный счетчик промахов кеша текущего потока
+class PerfCounter
+{
+  public:
+    PerfCounter()
+    {
+#ifdef __linux__
+        perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.size = sizeof(attr);
+        attr.config = PERF_COUNT_HW_CACHE_MISSES;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        fd = int(syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+#endif
+    }
+
+    ~PerfCounter()
+    {
+#ifdef __linux__
+        if (fd >= 0)
+            close(fd);
+#endif
+    }
+
+    bool available() const
+    {
+        return fd >= 0;
+    }
+
+    void start()
+    {
+#ifdef __linux__
+        if (fd >= 0)
+        {
+            ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+#endif
+    }
+
+    uint64_t stop()
+    {
+        uint64_t count = 0;
+#ifdef __linux__
+        if (fd >= 0)
+        {
+            ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+            if (read(fd, &count, sizeof(count)) != sizeof(count))
+                count = 0;
+        }
+#endif
+        return count;
+    }
+
+  private:
+    int fd = -1;
+};
+
+typedef vector<vector<POS_T>> board_t;
+
+// Наборы позиций из Bench: дебют, миттельшпиль, эндшпиль с дамками
+struct position_set
+{
+    string name;
+    vector<board_t> boards;
+    vector<bool> colors;
+    vector<vector<move_pos>> turns; // ходы стороны, которая ходит, в каждой позиции
+};
+
+vector<position_set> make_sets()
+{
+    vector<position_set> sets = {{"opening", {}, {}, {}}, {"midgame", {}, {}, {}}, {"kings", {}, {}, {}}};
+    const auto &fens = Bench::positions();
+    for (size_t i = 0; i < fens.size(); ++i)
+    {
+        position_set &set = sets[i < 2 ? 0 : i < 7 ? 1 : 2];
+        board_t mtx;
+        bool color = false;
+        notation::parse_fen(fens[i], mtx, color);
+        set.boards.push_back(mtx);
+        set.colors.push_back(color);
+    }
+    Settings settings;
+    settings.no_random = true;
+    Logic logic(settings);
+    for (auto &set : sets)
+    {
+        for (size_t i = 0; i < set.boards.size(); ++i)
+        {
+            logic.find_turns(set.colors[i], set.boards[i]);
+            set.turns.push_back(logic.turns);
+        }
+    }
+    return sets;
+}
+
+// Ходы дамки обходом диагоналей по клеткам (прежний генератор) для сверки с Logic::find_turns.
+// continuing - оставлять после взятия только поля, с которых взятие продолжается, если такие есть
+vector<move_pos> reference_king_turns(const POS_T x, const POS_T y, const board_t &mtx, const bool continuing = true)
+{
+    vector<move_pos> res;
+    const POS_T type = mtx[x][y];
+    for (POS_T i = -1; i <= 1; i += 2)
+    {
+        for (POS_T j = -1; j <= 1; j += 2)
+        {
+            POS_T xb = -1, yb = -1;
+            vector<move_pos> ray;
+            for (POS_T i2 = x + i, j2 = y + j; i2 != 8 && j2 != 8 && i2 != -1 && j2 != -1; i2 += i, j2 += j)
+            {
+                if (mtx[i2][j2])
+                {
+                    if (mtx[i2][j2] % 2 == type % 2 || xb != -1)
+                        break;
+                    xb = i2;
+                    yb = j2;
+                }
+                if (xb != -1 && xb != i2)
+                    ray.emplace_back(x, y, i2, j2, xb, yb);
+            }
+            // Взятая фигура остается на доске до конца серии: на копии она становится своей
+            vector<move_pos> next;
+            for (const auto &turn : ray)
+            {
+                if (!continuing)
+                    break;
+                board_t after = mtx;
+                after[x][y] = 0;
+                after[turn.xb][turn.yb] = type;
+                after[turn.x2][turn.y2] = type;
+                const auto further = reference_king_turns(turn.x2, turn.y2, after, false);
+                if (!further.empty() && further.front().xb != -1)
+                    next.push_back(turn);
+            }
+            if (next.empty())
+                next = ray;
+            res.insert(res.end(), next.begin(), next.end());
+        }
+    }
+    if (!res.empty())
+        return res;
+    for (POS_T i = -1; i <= 1; i += 2)
+    {
+        for (POS_T j = -1; j <= 1; j += 2)
+        {
+            for (POS_T i2 = x + i, j2 = y + j; i2 != 8 && j2 != 8 && i2 != -1 && j2 != -1; i2 += i, j2 += j)
+            {
+                if (mtx[i2][j2])
+                    break;
+                res.emplace_back(x, y, i2, j2);
+            }
+        }
+    }
+    return res;
+}
+
+// Сверка ходов всех дамок на count случайных позициях, false - при расхождении
+bool check_king_turns(Logic &logic, const int count)
+{
+    mt19937 rng(12345);
+    size_t kings = 0;
+    for (int n = 0; n < count; ++n)
+    {
+        board_t mtx(8, vector<POS_T>(8, 0));
+        const int fill = int(rng() % 60) + 5; // процент занятых клеток
+        for (POS_T i = 0; i < 8; ++i)
+        {
+            for (POS_T j = 1 - i % 2; j < 8; j += 2)
+            {
+                if (int(rng() % 100) < fill)
+                    mtx[i][j] = POS_T(rng() % 4 + 1);
+            }
+        }
+        for (POS_T i = 0; i < 8; ++i)
+        {
+            for (POS_T j = 0; j < 8; ++j)
+            {
+                if (mtx[i][j] < 3)
+                    continue;
+                ++kings;
+                const auto expected = reference_king_turns(i, j, mtx);
+                logic.find_turns(i, j, mtx);
+                bool same = expected.size() == logic.turns.size();
+                for (size_t k = 0; same && k < expected.size(); ++k)
+                {
+                    same = expected[k] == logic.turns[k] && expected[k].xb == logic.turns[k].xb &&
+                           expected[k].yb == logic.turns[k].yb;
+                }
+                if (!same)
+                {
+                    cout << "king turns mismatch at " << cell_name(i, j) << " in " << notation::to_fen(mtx, false)
+                         << '\n';
+                    return false;
+                }
+            }
+        }
+    }
+    cout << "king turns match on " << count << " random positions (" << kings << " kings)\n";
+    return true;
+}
+
+// Позиции, в которых распознаватели эндшпиля ошибались, и ничьи, которые они должны признавать
+struct endgame_case
+{
+    string fen;
+    bool draw; // теоретическая ничья; иначе сторона, которая ходит, выигрывает
+};
+
+const vector<endgame_case> endgame_cases = {
+    {"W:WKa1,Kd2:BKh8", false}, // d2-c3 h8:b2 a1:c3
+    {"W:WKa1,d2:BKh8", false},  // d2-c3 h8:b2 a1:c3
+    {"W:WKa1:BKh2", true},
+    {"W:WKc1,Ke1:BKh8", true},
+    {"B:WKc1,Ke1:BKh8", true},
+    {"W:WKc1,e3:BKh8", true},
+    {"W:WKc1,Ke1,Kg1:BKa1", true},
+};
+
+// Признание ничьи Endgame::is_known_draw и выигрыш в переборе с распознавателями, false - при ошибке
+bool check_endgame(const Settings &settings)
+{
+    for (const auto &c : endgame_cases)
+    {
+        board_t mtx;
+        bool color = false;
+        notation::parse_fen(c.fen, mtx, color);
+        if (Endgame::is_known_draw(mtx, color) != c.draw)
+        {
+            cout << "endgame draw " << (c.draw ? "not recognized" : "recognized wrongly") << " in " << c.fen << '\n';
+            return false;
+        }
+        if (c.draw)
+            continue;
+        // Выигрыш жертвой виден на глубине 4, если распознаватель не обрывает перебор ничьей
+        Logic logic(settings);
+        logic.Max_depth = 4;
+        History history;
+        history.reset(mtx, color);
+        logic.find_best_turns(mtx, history, color);
+        if (logic.stats.score < INF)
+        {
+            cout << "endgame win not found in " << c.fen << '\n';
+            return false;
+        }
+    }
+    cout << "endgame recognizers match on " << endgame_cases.size() << " positions\n";
+    return true;
+}
+
+double time_limit_ms = 200;
+string filter;
+PerfCounter cache;
+volatile double sink; // результат замеряемых функций, чтобы компилятор их не удалил
+
+// Повтор body до истечения времени; body возвращает число выполненных операций
+void measure(const string &name, const function<size_t()> &body)
+{
+    if (!filter.empty() && name.find(filter) == string::npos)
+        return;
+    // Прогрев; в наборе может не быть нужных фигур (например, дамок в дебюте)
+    if (!body())
+        return;
+    size_t ops = 0;
+    const uint64_t allocations_before = allocations.load(memory_order_relaxed);
+    cache.start();
+    auto start = chrono::steady_clock::now();
+    double elapsed = 0;
+    while (elapsed < time_limit_ms)
+    {
+        ops += body();
+        elapsed = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    }
+    const uint64_t misses = cache.stop();
+    const double allocs = double(allocations.load(memory_order_relaxed) - allocations_before);
+    ops = max<size_t>(ops, 1);
+    cout << left << setw(40) << name << right << fixed << setprecision(1) << setw(12) << elapsed * 1e6 / double(ops)
+         << setprecision(2) << setw(12) << allocs / double(ops);
+    if (cache.available())
+        cout << setw(14) << double(misses) / double(ops);
+    else
+        cout << setw(14) << "n/a";
+    cout << '\n';
+}
+
+int main(int argc, char* argv[])
+{
+    int check_count = 0;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        if (!strcmp(argv[i], "--time"))
+            time_limit_ms = atof(argv[i + 1]);
+        else if (!strcmp(argv[i], "--filter"))
+            filter = argv[i + 1];
+        else if (!strcmp(argv[i], "--check"))
+            check_count = atoi(argv[i + 1]);
+    }
+    Settings settings;
+    settings.no_random = true;
+    Logic logic(settings);
+    settings.eval_cache = false;
+    Logic potential_uncached(settings);
+    settings.eval_cache = true;
+    settings.scoring = ScoringType::NumberOnly;
+    Logic number_only(settings);
+    settings.scoring = ScoringType::NumberAndStructure;
+    Logic structure(settings);
+    settings.eval_cache = false;
+    Logic structure_uncached(settings);
+    const auto sets = make_sets();
+    if (check_count > 0 && (!check_king_turns(logic, check_count) || !check_endgame(Settings())))
+        return 1;
+
+    cout << left << setw(40) << "benchmark" << right << setw(12) << "ns/op" << setw(12) << "allocs/op" << setw(14)
+         << "misses/op" << '\n';
+    for (const auto &set : sets)
+    {
+        // Ходы всех фигур стороны, которая ходит
+        measure("find_turns(color)/" + set.name, [&] {
+            for (size_t i = 0; i < set.boards.size(); ++i)
+                logic.find_turns(set.colors[i], set.boards[i]);
+            return set.boards.size();
+        });
+        // Ходы одной фигуры: простые и дамки отдельно
+        for (const bool kings : {false, true})
+        {
+            measure(string("find_turns(x,y)/") + (kings ? "kings/" : "men/") + set.name, [&] {
+                size_t ops = 0;
+                for (const auto &mtx : set.boards)
+                {
+                    for (POS_T x = 0; x < 8; ++x)
+                    {
+                        for (POS_T y = 0; y < 8; ++y)
+                        {
+                            if (!mtx[x][y] || (mtx[x][y] > 2) != kings)
+                                continue;
+                            logic.find_turns(x, y, mtx);
+                            ++ops;
+                        }
+                    }
+                }
+                return ops;
+            });
+        }
+        measure("make_turn/" + set.name, [&] {
+            size_t ops = 0;
+            for (size_t i = 0; i < set.boards.size(); ++i)
+            {
+                for (const auto &turn : set.turns[i])
+                {
+                    sink = logic.make_turn(set.boards[i], turn)[turn.x2][turn.y2];
+                    ++ops;
+                }
+            }
+            return ops;
+        });
+        measure("calc_score/NumberAndPotential/" + set.name, [&] {
+            for (size_t i = 0; i < set.boards.size(); ++i)
+                sink = logic.calc_score(set.boards[i], set.colors[i]);
+            return set.boards.size();
+        });
+        measure("calc_score/NumberOnly/" + set.name, [&] {
+            for (size_t i = 0; i < set.boards.size(); ++i)
+                sink = number_only.calc_score(set.boards[i], set.colors[i]);
+            return set.boards.size();
+        });
+        measure("calc_score/NumberAndStructure/" + set.name, [&] {
+            for (size_t i = 0; i < set.boards.size(); ++i)
+                sink = structure_uncached.calc_score(set.boards[i], set.colors[i]);
+            return set.boards.size();
+        });
+        // Оценка листьев в переборе: обходом доски (без кэша) и по материалу пути с кэшем оценки простых
+        for (const auto &mode : {make_pair(string("Potential"), make_pair(&potential_uncached, &logic)),
+                                 make_pair(string("Structure"), make_pair(&structure_uncached, &structure))})
+        {
+            for (Logic *search_logic : {mode.second.first, mode.second.second})
+            {
+                const bool cached = search_logic == mode.second.second;
+                uint64_t hits = 0, misses = 0;
+                measure("search/" + mode.first + "/" + (cached ? "cache/" : "no-cache/") + set.name, [&] {
+                    size_t leaves = 0;
+                    for (size_t i = 0; i < set.boards.size(); ++i)
+                    {
+                        History history;
+                        history.reset(set.boards[i], set.colors[i]);
+                        search_limits limits;
+                        limits.depth = 4;
+                        search_logic->search(set.boards[i], history, set.colors[i], limits);
+                        leaves += search_logic->stats.leaves;
+                        hits += search_logic->stats.eval_cache_hits;
+                        misses += search_logic->stats.eval_cache_misses;
+                    }
+                    return leaves;
+                });
+                if (cached && hits + misses)
+                    cout << "  eval cache hit rate " << fixed << setprecision(1) << hits * 100.0 / double(hits + misses)
+                         << "%\n";
+            }
+        }
+
+        // Доска без окна: отрисовка пропускается, замеряется только работа с позицией
+        Board board;
+        board.set_board(set.boards.back());
+        measure("Board::get_board/" + set.name, [&] {
+            for (int i = 0; i < 16; ++i)
+                sink = board.get_board()[0][1];
+            return size_t(16);
+        });
+        measure("Board::move_piece+rollback/" + set.name, [&] {
+            size_t ops = 0;
+            for (size_t i = 0; i < set.boards.size(); ++i)
+            {
+                board.set_board(set.boards[i]);
+                for (const auto &turn : set.turns[i])
+                {
+                    board.move_piece(turn, turn.xb != -1);
+                    board.rollback();
+                    ++ops;
+                }
+            }
+            return ops;
+        });
+    }
+    if (!cache.available())
+        cout << "perf_event is not available, cache misses are not counted\n";
+    return 0;
+}
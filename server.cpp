@@ -0,0 +1,34 @@
+#include <cstring>
+
+#include "Game/Server.h"
+
+// server [--socket PATH | --port N] [--threads N] [--level L] [--budget MS] [--difficulty depth|budget] [--cache PATH]
+int main(int argc, char* argv[])
+{
+    string socket_path = "/tmp/checkers.sock";
+    int port = 0, threads = int(thread::hardware_concurrency()), level = 5;
+    double budget_ms = 1000;
+    bool by_budget = false;
+    Settings settings;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        if (!strcmp(argv[i], "--socket"))
+            socket_path = argv[i + 1];
+        else if (!strcmp(argv[i], "--port"))
+            port = atoi(argv[i + 1]);
+        else if (!strcmp(argv[i], "--threads"))
+            threads = atoi(argv[i + 1]);
+        else if (!strcmp(argv[i], "--level"))
+            level = atoi(argv[i + 1]);
+        else if (!strcmp(argv[i], "--budget"))
+            budget_ms = atof(argv[i + 1]);
+        else if (!strcmp(argv[i], "--difficulty"))
+            by_budget = !strcmp(argv[i + 1], "budget");
+        else if (!strcmp(argv[i], "--cache"))
+            settings.cache_file = argv[i + 1];
+    }
+    settings.no_random = true;
+    settings.difficulty = by_budget ? Difficulty::Budget : Difficulty::Depth;
+    Server server(settings, threads, level, budget_ms);
+    return port ? server.listen_tcp(port) : server.listen_unix(socket_path);
+}
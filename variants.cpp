@@ -0,0 +1,223 @@
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <tuple>
+
+#include "Game/Logic.h"
+#include "Game/Notation.h"
+#include "Game/Rules.h"
+
+// Замер правил вариантов на битовых досках: variants [--perft D] [--depth D] [--check N].
+// Для русских шашек 8x8 и международных 10x10 считается perft от начальной расстановки на глубину D
+// (для 10x10 на единицу меньше: ветвление больше) и перебор с альфа-бета отсечением на --depth ходов.
+// Для сравнения тот же perft считается генератором игры (Logic, матрица 8x8).
+// --check N сравнивает ходы Rules<russian> и Logic в позициях regression_positions и в N случайных позициях
+// и завершается с ошибкой, если ходы различаются
+
+int perft_depth = 8;
+int search_depth = 8;
+int check_positions = 0;
+
+double elapsed_ms(const chrono::steady_clock::time_point start)
+{
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+void report(const string &name, const string &test, const uint64_t nodes, const double ms)
+{
+    cout << left << setw(22) << name << setw(12) << test << right << setw(12) << nodes << " nodes " << setw(9)
+         << fixed << setprecision(1) << ms << " ms " << setw(8) << setprecision(2)
+         << (ms > 0 ? nodes / ms / 1000 : 0) << " Mnodes/s" << endl;
+}
+
+template <class V> void bench_variant(const string &name, const int depth)
+{
+    const auto pos = Rules<V>::start_position();
+    auto start = chrono::steady_clock::now();
+    const uint64_t count = Rules<V>::perft(pos, depth);
+    report(name, "perft " + to_string(depth), count, elapsed_ms(start));
+
+    uint64_t nodes = 0;
+    start = chrono::steady_clock::now();
+    Rules<V>::search(pos, search_depth, -Rules<V>::win_score - 1, Rules<V>::win_score + 1, nodes);
+    report(name, "search " + to_string(search_depth), nodes, elapsed_ms(start));
+}
+
+// perft генератора игры: ход - серия взятий целиком, как в Rules
+uint64_t logic_perft(Logic &logic, const vector<vector<POS_T>> &mtx, const bool color, const int depth)
+{
+    if (depth == 0)
+        return 1;
+    const auto chains = logic.turn_chains(color, mtx);
+    if (depth == 1)
+        return chains.size();
+    uint64_t res = 0;
+    for (const auto &chain : chains)
+    {
+        auto next = mtx;
+        for (const auto &turn : chain)
+            next = logic.make_turn(next, turn);
+        res += logic_perft(logic, next, !color, depth - 1);
+    }
+    return res;
+}
+
+// Номер темной клетки (x, y) в Rules для доски 8x8
+int square_of(const POS_T x, const POS_T y)
+{
+    return x * russian::row_squares + y / 2;
+}
+
+Rules<russian>::position to_rules(const vector<vector<POS_T>> &mtx, const bool color)
+{
+    Rules<russian>::position pos;
+    pos.color = color;
+    for (POS_T x = 0; x < board_size; ++x)
+    {
+        for (POS_T y = 0; y < board_size; ++y)
+        {
+            const POS_T type = mtx[x][y];
+            if (!type)
+                continue;
+            const uint64_t b = uint64_t(1) << square_of(x, y);
+            (type > 2 ? pos.kings : pos.men)[(type - 1) % 2] |= b;
+        }
+    }
+    return pos;
+}
+
+// Позиции, в которых генератор игры расходился с правилами: дамка останавливалась на поле, с которого
+// взятие не продолжается, или серия проходила через поле уже взятой фигуры
+const vector<string> regression_positions = {
+    "B:Wa1,g1,b2,d2,h2,c3,d4:Ba3,d6,f6,h6,a7,g7,f8,h8",
+    "B:Wa1,g1,b2,d2,c3,g3,Kb6:Ba3,h6,a7,f8,h8",
+    "B:Wa1,b2,d2,f2,c3,g3:Ba3,c5,h6,f8,h8",
+    "W:Wa1,c1,g1,b2,f2,h2,b4,h6:Bf4,g5,a7,e7,g7,d8,h8",
+    "W:Wa1,c1,e1,g1,d2,f2,a3,c3,Ka5,h6:Bb6,d6,g7,f8,h8",
+    "B:Wa1,g1,d2,d4:BKe1,h2,a5,c5,c7,h8",
+    "W:Wd4,f4,Kf8:Bb2,a5,e7",
+    "B:Wh2,e3,a5,d6:BKc1",
+    "B:Wa1,e1,g1,b2,d2,h2,e5:Ba3,c5,h6,a7,e7,b8,f8,h8",
+    "B:Wa1,d2,f2,h2,a3,c3,Kd4,f4:Bh4,g5,a7,c7",
+    "B:Wa1,d2,h2,a3,d4:Bh4,Kc5,a7,c7",
+    "W:WKg7:Ba3,d6,Kf6",
+    "W:We1,b2,f2,d4,Kf8:Ba5,e5,f6,c7,e7,h8",
+};
+
+typedef vector<tuple<int, int, uint64_t>> move_set; // поле начала, поле конца, взятые фигуры
+
+// Ходы Logic и Rules в позиции, отсортированные
+void compare_moves(Logic &logic, const vector<vector<POS_T>> &mtx, const bool color, move_set &expected,
+                   move_set &actual)
+{
+    expected.clear();
+    actual.clear();
+    for (const auto &chain : logic.turn_chains(color, mtx))
+    {
+        uint64_t captured = 0;
+        for (const auto &turn : chain)
+        {
+            if (turn.xb != -1)
+                captured |= uint64_t(1) << square_of(turn.xb, turn.yb);
+        }
+        expected.emplace_back(square_of(chain.front().x, chain.front().y), square_of(chain.back().x2, chain.back().y2),
+                              captured);
+    }
+    Rules<russian>::move_list moves;
+    Rules<russian>::generate(to_rules(mtx, color), moves);
+    for (const auto &m : moves)
+        actual.emplace_back(m.from, m.to, m.captured);
+    sort(expected.begin(), expected.end());
+    sort(actual.begin(), actual.end());
+}
+
+// Вывод различия ходов в позиции (не больше 10 позиций)
+void report_difference(const int differences, const string &fen, const move_set &expected, const move_set &actual)
+{
+    if (differences <= 10)
+        cout << "moves differ: " << fen << " logic " << expected.size() << " moves, rules " << actual.size() << endl;
+}
+
+/**
+ * Сравнение ходов Rules<russian> и Logic в позициях regression_positions и в случайных позициях
+ * из случайных партий
+ * @return число позиций, в которых ходы различаются
+ */
+int check(const int count)
+{
+    Settings settings;
+    settings.no_random = true;
+    Logic logic(settings);
+    move_set expected, actual;
+    int differences = 0;
+    for (const auto &fen : regression_positions)
+    {
+        vector<vector<POS_T>> mtx;
+        bool color;
+        if (!notation::parse_fen(fen, mtx, color))
+        {
+            ++differences;
+            cout << "bad position: " << fen << endl;
+            continue;
+        }
+        compare_moves(logic, mtx, color, expected, actual);
+        if (expected != actual)
+            report_difference(++differences, fen, expected, actual);
+    }
+
+    mt19937 rng(2024);
+    for (int n = 0; n < count;)
+    {
+        auto mtx = notation::start_position();
+        bool color = false;
+        const int plies = int(rng() % 80);
+        for (int i = 0; i <= plies && n < count; ++i)
+        {
+            const auto chains = logic.turn_chains(color, mtx);
+            if (chains.empty())
+                break;
+            ++n;
+            compare_moves(logic, mtx, color, expected, actual);
+            if (expected != actual)
+                report_difference(++differences, notation::to_fen(mtx, color), expected, actual);
+            const auto &chain = chains[rng() % chains.size()];
+            for (const auto &turn : chain)
+                mtx = logic.make_turn(mtx, turn);
+            color = !color;
+        }
+    }
+    cout << "checked " << regression_positions.size() << " regression and " << count
+         << " random positions, moves differ in " << differences << endl;
+    return differences;
+}
+
+int main(int argc, char *argv[])
+{
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        if (!strcmp(argv[i], "--perft"))
+            perft_depth = max(1, atoi(argv[i + 1]));
+        else if (!strcmp(argv[i], "--depth"))
+            search_depth = max(1, atoi(argv[i + 1]));
+        else if (!strcmp(argv[i], "--check"))
+            check_positions = max(0, atoi(argv[i + 1]));
+    }
+    if (check_positions)
+    {
+        return check(check_positions) ? 1 : 0;
+    }
+
+    bench_variant<russian>("russian 8x8", perft_depth);
+    bench_variant<international>("international 10x10", max(1, perft_depth - 1));
+
+    Settings settings;
+    settings.no_random = true;
+    Logic logic(settings);
+    const auto start = chrono::steady_clock::now();
+    const uint64_t count = logic_perft(logic, notation::start_position(), false, perft_depth);
+    report("game engine 8x8", "perft " + to_string(perft_depth), count, elapsed_ms(start));
+    return 0;
+}